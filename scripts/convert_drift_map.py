@@ -0,0 +1,99 @@
+############################################################
+#
+# Convert a drift field map from the text format to the
+# binary format read by nexus (see FieldMapDriftField.h).
+#
+# The text map has header lines starting with '*' that define
+# the anode and cathode z positions ("* anode <mm>" and
+# "* cathode <mm>"). Every other line holds the coordinates
+# of a node of a regular grid, either r z or x y z (mm), and
+# its drift velocity (mm/ns), transverse and longitudinal
+# diffusion (mm) and the two displacements (mm) at the anode.
+#
+# The drift velocity must be the mean velocity along the drift
+# line from the node to the anode, i.e. the distance in z from
+# the node to the anode divided by the drift time to the anode,
+# not the local velocity at the node: nexus drifts the electrons
+# to the anode in one step with that velocity.
+#
+# Usage: python convert_drift_map.py map.txt map.bin
+#
+############################################################
+
+import sys
+import struct
+import numpy as np
+
+num_values = 5
+
+
+def read_text_map(filename):
+    anode   = None
+    cathode = None
+    rows    = []
+
+    with open(filename) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            if line.startswith('*'):
+                fields = line[1:].split()
+                if len(fields) >= 2 and fields[0] == 'anode':
+                    anode = float(fields[1])
+                elif len(fields) >= 2 and fields[0] == 'cathode':
+                    cathode = float(fields[1])
+                continue
+            rows.append([float(v) for v in line.split()])
+
+    if anode is None or cathode is None:
+        sys.exit('The map header must define anode and cathode')
+
+    rows = np.array(rows)
+    dimensions = rows.shape[1] - num_values
+    if dimensions not in (2, 3):
+        sys.exit('The map must have 2 or 3 coordinates and 5 values per node')
+
+    return dimensions, anode, cathode, rows
+
+
+def grid_axis(coords):
+    nodes = np.unique(coords)
+    if len(nodes) == 1:
+        return nodes[0], 0., 1
+    steps = np.diff(nodes)
+    if not np.allclose(steps, steps[0]):
+        sys.exit('The nodes of the map are not evenly spaced')
+    return nodes[0], steps[0], len(nodes)
+
+
+def write_binary_map(filename, dimensions, anode, cathode, rows):
+    coords = rows[:, :dimensions]
+    axes   = [grid_axis(coords[:, i]) for i in range(dimensions)]
+    if dimensions == 2:
+        axes.append((0., 0., 1))
+
+    mins, pitches, num_nodes = zip(*axes)
+    if np.prod(num_nodes) != len(rows):
+        sys.exit('The map does not cover all the nodes of its grid')
+
+    # Order the nodes by the first, second and third coordinate
+    index = [np.rint((coords[:, i] - mins[i]) / pitches[i]).astype(int)
+             if num_nodes[i] > 1 else np.zeros(len(rows), dtype=int)
+             for i in range(dimensions)]
+    order  = np.lexsort(index[::-1])
+    values = rows[order, dimensions:]
+
+    header = struct.pack('=8sII3II3d3ddd', b'NXDRMAP1', 1, dimensions,
+                         *num_nodes, 0, *mins, *pitches, anode, cathode)
+
+    with open(filename, 'wb') as f:
+        f.write(header)
+        f.write(values.astype(np.float32).tobytes())
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit('Usage: python convert_drift_map.py map.txt map.bin')
+
+    write_binary_map(sys.argv[2], *read_text_map(sys.argv[1]))
@@ -0,0 +1,75 @@
+############################################################
+#
+# Convert an EL look-up table from the text format to the
+# binary format memory-mapped by nexus (see ELLookupTable.h).
+#
+# Usage: python convert_el_table.py table.txt table.bin
+#
+############################################################
+
+import sys
+import struct
+import numpy as np
+
+
+def read_text_table(filename):
+    radius = None
+    pitch  = None
+    points = {}
+    num_bins = 0
+
+    with open(filename) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            if line.startswith('*'):
+                fields = line[1:].split()
+                if len(fields) >= 2 and fields[0] == 'grid_radius':
+                    radius = float(fields[1])
+                elif len(fields) >= 2 and fields[0] == 'grid_pitch':
+                    pitch = float(fields[1])
+                continue
+
+            fields = line.split()
+            point_id, sensor_id = int(fields[0]), int(fields[1])
+            probs = [float(p) for p in fields[2:]]
+            points.setdefault(point_id, {})[sensor_id] = probs
+            num_bins = max(num_bins, len(probs))
+
+    if radius is None or pitch is None:
+        sys.exit('The table header must define grid_radius and grid_pitch')
+
+    return radius, pitch, points, num_bins
+
+
+def write_binary_table(filename, radius, pitch, points, num_bins):
+    num_points = max(points) + 1 if points else 0
+
+    offsets    = np.zeros(num_points + 1, dtype=np.uint64)
+    sensor_ids = []
+    probs      = []
+
+    for point_id in range(num_points):
+        sensors = points.get(point_id, {})
+        for sensor_id in sorted(sensors):
+            sensor_ids.append(sensor_id)
+            p = sensors[sensor_id]
+            probs.extend(p + [0.] * (num_bins - len(p)))
+        offsets[point_id + 1] = len(sensor_ids)
+
+    header = struct.pack('=8sIIddQQ', b'NXELTAB1', 1, num_bins,
+                         radius, pitch, num_points, len(sensor_ids))
+
+    with open(filename, 'wb') as f:
+        f.write(header)
+        f.write(offsets.tobytes())
+        f.write(np.array(sensor_ids, dtype=np.int32).tobytes())
+        f.write(np.array(probs, dtype=np.float32).tobytes())
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit('Usage: python convert_el_table.py table.txt table.bin')
+
+    write_binary_table(sys.argv[2], *read_text_table(sys.argv[1]))
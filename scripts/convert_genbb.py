@@ -0,0 +1,78 @@
+############################################################
+#
+# Convert a genbb event file from the text format written
+# by DECAY0 to the binary format memory-mapped by nexus
+# (see GenbbFile.h). The GEANT3 particle codes of the text
+# file are translated to PDG codes.
+#
+# Usage: python convert_genbb.py events.genbb events.bin
+#
+############################################################
+
+import sys
+import struct
+import numpy as np
+
+# Same translation as Decay0Interface::G3toPDG
+g3_to_pdg = { 1:         22, # gamma
+              2:        -11, # e+
+              3:         11, # e-
+              5:        -13, # mu+
+              6:         13, # mu-
+             13:       2112, # neutron
+             14:       2212, # proton
+             47: 1000020040} # alpha
+
+particle_dtype = np.dtype([('pdg_code', 'i4'), ('reserved', 'i4'),
+                           ('momentum', 'f8', 3), ('time', 'f8')])
+
+
+def read_text_events(filename):
+    with open(filename) as f:
+        # The events start two lines after the "First event" one
+        for line in f:
+            if 'First event' in line:
+                break
+        else:
+            sys.exit('The genbb file has no "First event" line')
+        next(f, None)
+        tokens = f.read().split()
+
+    times     = []
+    offsets   = [0]
+    particles = []
+
+    i = 0
+    while i + 3 <= len(tokens):
+        entries = int(tokens[i + 2])
+        times.append(float(tokens[i + 1]))
+        i += 3
+        for _ in range(entries):
+            g3code = int(tokens[i])
+            if g3code not in g3_to_pdg:
+                sys.exit(f'Particle with unknown GEANT3 code: {g3code}')
+            particles.append((g3_to_pdg[g3code], 0,
+                              [float(v) for v in tokens[i+1:i+4]],
+                              float(tokens[i + 4])))
+            i += 5
+        offsets.append(len(particles))
+
+    return times, offsets, particles
+
+
+def write_binary_events(filename, times, offsets, particles):
+    header = struct.pack('=8sIIQQ', b'NXGENBB1', 1, 0,
+                         len(times), len(particles))
+
+    with open(filename, 'wb') as f:
+        f.write(header)
+        f.write(np.array(offsets, dtype=np.uint64).tobytes())
+        f.write(np.array(times, dtype=np.float64).tobytes())
+        f.write(np.array(particles, dtype=particle_dtype).tobytes())
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit('Usage: python convert_genbb.py events.genbb events.bin')
+
+    write_binary_events(sys.argv[2], *read_text_events(sys.argv[1]))
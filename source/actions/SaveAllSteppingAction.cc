@@ -14,15 +14,35 @@
 #include <G4VPersistencyManager.hh>
 #include <G4ProcessManager.hh>
 #include <G4ParticleTable.hh>
+#include <G4PhysicalVolumeStore.hh>
+
+#include <algorithm>
 
 using namespace nexus;
 
 
 
+void StepColumns::clear()
+{
+  track_ids      .clear();
+  step_ids       .clear();
+  particles      .clear();
+  initial_volumes.clear();
+    final_volumes.clear();
+  procs          .clear();
+  initial_poss   .clear();
+    final_poss   .clear();
+}
+
+
+
 SaveAllSteppingAction::SaveAllSteppingAction():
 G4UserSteppingAction(),
 msg_(0),
-selected_volumes_()
+selected_volumes_(),
+volumes_resolved_(false),
+current_track_(0),
+current_nsteps_(0)
 {
   msg_ = new G4GenericMessenger(this, "/Actions/SaveAllSteppingAction/");
 
@@ -51,33 +71,38 @@ SaveAllSteppingAction::~SaveAllSteppingAction()
 
 void SaveAllSteppingAction::UserSteppingAction(const G4Step* step)
 {
-  G4ParticleDefinition* pdef          = step->GetTrack()->GetDefinition();
-  G4int                 track_id      = step->GetTrack()->GetTrackID();
-  G4String              particle_name = pdef->GetParticleName();
+  const G4Track* track = step->GetTrack();
+  const G4ParticleDefinition* pdef = track->GetDefinition();
 
   if (!KeepParticle(pdef)) return;
 
   G4StepPoint* pre  = step->GetPreStepPoint();
   G4StepPoint* post = step->GetPostStepPoint();
 
-  G4ThreeVector initial_pos = pre ->GetPosition();
-  G4ThreeVector   final_pos = post->GetPosition();
-
-  G4String initial_volume = pre ->GetTouchableHandle()->GetVolume()->GetName();
-  G4String   final_volume = post->GetTouchableHandle()->GetVolume()->GetName();
-  G4String      proc_name = post->GetProcessDefinedStep()->GetProcessName();
+  const G4VPhysicalVolume* initial_volume = pre ->GetTouchableHandle()->GetVolume();
+  const G4VPhysicalVolume*   final_volume = post->GetTouchableHandle()->GetVolume();
 
   if (!KeepVolume(initial_volume, final_volume))
     return;
 
-  std::pair<G4int, G4String> key = std::make_pair(track_id, particle_name);
+  // Tracks are followed one at a time, so the counter is looked up
+  // only when the track changes
+  G4int track_id = track->GetTrackID();
+  if (!current_nsteps_ || track_id != current_track_) {
+    current_track_  = track_id;
+    current_nsteps_ = &nsteps_[track_id];
+  }
+
+  steps_.track_ids.push_back(track_id);
+  steps_.step_ids .push_back((*current_nsteps_)++);
+  steps_.particles.push_back(pdef);
 
-  initial_volumes_[key].push_back(initial_volume);
-    final_volumes_[key].push_back(  final_volume);
-       proc_names_[key].push_back(     proc_name);
+  steps_.initial_volumes.push_back(initial_volume);
+  steps_.  final_volumes.push_back(  final_volume);
+  steps_.          procs.push_back(post->GetProcessDefinedStep());
 
-  initial_poss_   [key].push_back(initial_pos);
-    final_poss_   [key].push_back(  final_pos);
+  steps_.initial_poss.push_back(pre ->GetPosition());
+  steps_.  final_poss.push_back(post->GetPosition());
 }
 
 
@@ -95,10 +120,31 @@ void SaveAllSteppingAction::AddSelectedParticle(G4String particle_name)
 void SaveAllSteppingAction::AddSelectedVolume(G4String volume_name)
 {
   selected_volumes_.push_back(volume_name);
+  volumes_resolved_ = false;
 }
 
 
-G4bool SaveAllSteppingAction::KeepParticle(G4ParticleDefinition* pdef)
+void SaveAllSteppingAction::ResolveVolumes()
+{
+  // The selection is done by name, but the names are matched only
+  // once against the volumes of the geometry
+  volumes_.clear();
+
+  G4PhysicalVolumeStore* store = G4PhysicalVolumeStore::GetInstance();
+  for (auto pv=store->begin(); pv != store->end(); ++pv) {
+    for (auto volume=selected_volumes_.begin(); volume != selected_volumes_.end(); ++volume) {
+      if ((*pv)->GetName().contains(*volume)) {
+        volumes_.insert(*pv);
+        break;
+      }
+    }
+  }
+
+  volumes_resolved_ = true;
+}
+
+
+G4bool SaveAllSteppingAction::KeepParticle(const G4ParticleDefinition* pdef) const
 {
   if (!selected_particles_.size()) return true;
 
@@ -107,15 +153,15 @@ G4bool SaveAllSteppingAction::KeepParticle(G4ParticleDefinition* pdef)
 }
 
 
-G4bool SaveAllSteppingAction::KeepVolume(G4String& initial_volume, G4String& final_volume)
+G4bool SaveAllSteppingAction::KeepVolume(const G4VPhysicalVolume* initial_volume,
+                                         const G4VPhysicalVolume*   final_volume)
 {
   if (!selected_volumes_.size()) return true;
 
-  for (auto volume=selected_volumes_.begin(); volume != selected_volumes_.end(); volume++)
-  {
-    if (initial_volume.contains(*volume)) return true;
-    if (  final_volume.contains(*volume)) return true;
-  }
+  if (!volumes_resolved_) ResolveVolumes();
+
+  if (volumes_.count(initial_volume)) return true;
+  if (volumes_.count(  final_volume)) return true;
 
   return false;
 }
@@ -124,10 +170,7 @@ G4bool SaveAllSteppingAction::KeepVolume(G4String& initial_volume, G4String& fin
 
 void SaveAllSteppingAction::Reset()
 {
-  initial_volumes_.clear();
-    final_volumes_.clear();
-       proc_names_.clear();
-
-  initial_poss_   .clear();
-    final_poss_   .clear();
+  steps_.clear();
+  nsteps_.clear();
+  current_nsteps_ = 0;
 }
@@ -18,16 +18,34 @@
 #include <globals.hh>
 
 #include <vector>
-#include <map>
+#include <unordered_map>
+#include <unordered_set>
 
 class G4Step;
-
-template<typename T>
-using StepContainer = std::map<std::pair<G4int, G4String>, std::vector<T>>;
+class G4VPhysicalVolume;
+class G4VProcess;
 
 
 namespace nexus {
 
+  /// Steps of one event, stored column by column in the order they
+  /// are taken. Names are resolved only when the steps are written.
+  struct StepColumns
+  {
+    std::vector<G4int> track_ids;
+    std::vector<G4int> step_ids; ///< index of the step among the saved ones of its track
+    std::vector<const G4ParticleDefinition*> particles;
+    std::vector<const G4VPhysicalVolume*> initial_volumes;
+    std::vector<const G4VPhysicalVolume*>   final_volumes; ///< null out of the world
+    std::vector<const G4VProcess*> procs;
+    std::vector<G4ThreeVector> initial_poss;
+    std::vector<G4ThreeVector>   final_poss;
+
+    size_t size() const { return track_ids.size(); }
+    void clear();
+  };
+
+
   //  Stepping action to analyze the behaviour of optical photons
 
   class SaveAllSteppingAction: public G4UserSteppingAction
@@ -40,43 +58,37 @@ namespace nexus {
 
     virtual void UserSteppingAction(const G4Step*);
 
+    /// Steps saved since the last reset
+    const StepColumns& GetSteps() const;
+
+    void Reset();
+
+  private:
+    void   AddSelectedParticle(G4String);
+    void   AddSelectedVolume  (G4String);
+    void   ResolveVolumes();
+    G4bool KeepVolume  (const G4VPhysicalVolume*, const G4VPhysicalVolume*);
+    G4bool KeepParticle(const G4ParticleDefinition*) const;
+
   private:
     G4GenericMessenger* msg_;
 
     std::vector<G4String>              selected_volumes_;
     std::vector<G4ParticleDefinition*> selected_particles_;
 
-    StepContainer<G4String> initial_volumes_;
-    StepContainer<G4String>   final_volumes_;
-    StepContainer<G4String>      proc_names_;
-
-    StepContainer<G4ThreeVector> initial_poss_;
-    StepContainer<G4ThreeVector>   final_poss_;
-
-  public:
-
-    StepContainer<G4String> get_initial_volumes();
-    StepContainer<G4String> get_final_volumes();
-    StepContainer<G4String> get_proc_names();
+    /// Physical volumes whose name contains one of the selected names
+    std::unordered_set<const G4VPhysicalVolume*> volumes_;
+    G4bool volumes_resolved_; ///< is volumes_ up to date?
 
-    StepContainer<G4ThreeVector> get_initial_poss();
-    StepContainer<G4ThreeVector> get_final_poss();
+    StepColumns steps_;
 
-    void Reset();
-
-  private:
-    void   AddSelectedParticle(G4String);
-    void   AddSelectedVolume  (G4String);
-    G4bool        KeepVolume  (G4String&, G4String&);
-    G4bool        KeepParticle(G4ParticleDefinition*);
+    std::unordered_map<G4int, G4int> nsteps_; ///< saved steps per track
+    G4int  current_track_;  ///< track of the last saved step
+    G4int* current_nsteps_; ///< saved steps of current_track_
   };
 
-inline StepContainer<G4String> SaveAllSteppingAction::get_initial_volumes(){return initial_volumes_;}
-inline StepContainer<G4String> SaveAllSteppingAction::get_final_volumes  (){return   final_volumes_;}
-inline StepContainer<G4String> SaveAllSteppingAction::get_proc_names     (){return      proc_names_;}
-
-inline StepContainer<G4ThreeVector> SaveAllSteppingAction::get_initial_poss(){return initial_poss_;}
-inline StepContainer<G4ThreeVector> SaveAllSteppingAction::get_final_poss  (){return   final_poss_;}
+  inline const StepColumns& SaveAllSteppingAction::GetSteps() const
+  { return steps_; }
 
 } // namespace nexus
 
@@ -6,7 +6,8 @@
 // FORTRAN package, with nexus.
 // It provides the primary vertex of a Xe-136 double beta decay.
 // The possibility of reading a previously generated ascii file with the
-// electron momenta is also allowed.
+// electron momenta is also allowed, as well as its binary version made
+// with scripts/convert_genbb.py, which is memory-mapped.
 //
 // The NEXT Collaboration
 // ----------------------------------------------------------------------------
@@ -21,14 +22,20 @@
 #include <G4ParticleTable.hh>
 #include <G4ParticleDefinition.hh>
 #include "decay0.h"
+#include "Decay0Producer.h"
+#include "GeneratorFilter.h"
+#include "GenbbFile.h"
+#include <Randomize.hh>
 #include <iostream>
+#include <limits>
 using namespace nexus;
 
 
 
 
 Decay0Interface::Decay0Interface():
-  G4VPrimaryGenerator(), msg_(0), opened_(false), geom_(0)
+  G4VPrimaryGenerator(), msg_(0), opened_(false), buffer_size_(0),
+  producer_(0), start_event_(0), next_event_(0), genbb_(0), geom_(0), filter_(0)
 {
 
   msg_ = new G4GenericMessenger(this, "/Generator/Decay0Interface/",
@@ -41,13 +48,27 @@ Decay0Interface::Decay0Interface():
   msg_->DeclareMethod("Xe136DecayMode", &Decay0Interface::SetXe136DecayMode, "");
   msg_->DeclareMethod("Ba136FinalState", &Decay0Interface::SetBa136FinalState, "");
 
+  G4GenericMessenger::Command& start_cmd =
+    msg_->DeclareProperty("start_event", start_event_,
+                          "Index of the first event of the input file read by this job.");
+  start_cmd.SetParameterName("start_event", false);
+  start_cmd.SetRange("start_event>=0");
+
+  G4GenericMessenger::Command& buffer_cmd =
+    msg_->DeclareProperty("buffer_size", buffer_size_,
+                          "Number of decays generated in advance by a separate thread (0: none).");
+  buffer_cmd.SetParameterName("buffer_size", false);
+  buffer_cmd.SetRange("buffer_size>=0");
+
   DetectorConstruction* detConst = (DetectorConstruction*)
   G4RunManager::GetRunManager()->GetUserDetectorConstruction();
   geom_ = detConst->GetGeometry();
 
   decay0_ = 0;
   myEventCounter_ = 0;
-  energyThreshold_ = 0.;
+
+  filter_ = new GeneratorFilter("/Generator/Decay0Interface/",
+                                GeneratorFilter::kEnergy | GeneratorFilter::kVolume);
 }
 
 
@@ -55,8 +76,20 @@ Decay0Interface::Decay0Interface():
 Decay0Interface::~Decay0Interface()
 {
   if (file_.is_open()) file_.close();
+  delete genbb_;
   if (fOutDebug_.is_open()) fOutDebug_.close();
+  // The thread must stop before its generator is deleted
+  delete producer_;
   if (decay0_ != 0) delete decay0_;
+  delete filter_;
+  delete msg_;
+}
+
+
+
+void Decay0Interface::SetEnergyThreshold(double e)
+{
+  filter_->SetMinEnergy(e*MeV);
 }
 
 
@@ -69,6 +102,13 @@ void Decay0Interface::OpenInputFile(G4String filename)
      return;
    }
 
+  // Binary files are mapped instead of parsed
+  if (GenbbFile::IsBinary(filename)) {
+    genbb_ = new GenbbFile(filename);
+    opened_ = true;
+    return;
+  }
+
   file_.open(filename.data());
 
   if (file_.good()) {
@@ -98,21 +138,32 @@ void Decay0Interface::GeneratePrimaryVertex(G4Event* event)
 //      std::string fOutStr(fOutStrStr.str());
 //      fOutDebug_.open(fOutStr.c_str());
        if (fOutDebug_.is_open()) fOutDebug_ << " evt tr pdg px py pz e t  " << std::endl;
+
+       // The thread gets its own random engine, seeded from the
+       // Geant4 one so that the run remains reproducible
+       if (buffer_size_ > 0) {
+         const long seed = static_cast<long>(G4UniformRand() * 2147483646.) + 1;
+         producer_ = new Decay0Producer(decay0_, buffer_size_, seed);
+       }
      }
 
-     std::vector<decay0Part> theParts;
-     decay0_->decay0DoIt(theParts);
+     std::vector<decay0Part>& theParts = particles_;
      //
-     // Keep the event only if the sum of the electron energies are above the threshold.
+     // Generate decays until the sum of the electron energies and the vertex pass the filter.
      //
-     double eTotKin = 0.;
-     for(std::vector<decay0Part>::const_iterator itp = theParts.begin(); itp != theParts.end(); itp++) {
-
-       if (std::abs(itp->pdgCode_) == 11) eTotKin += itp->energy_;
-     }
-     const bool keepEvt = eTotKin > energyThreshold_;
+     double eTotKin;
+     do {
+       if (producer_) producer_->Pop(theParts);
+       else decay0_->decay0DoIt(theParts);
+       eTotKin = 0.;
+       for(std::vector<decay0Part>::const_iterator itp = theParts.begin(); itp != theParts.end(); itp++) {
+
+         if (std::abs(itp->pdgCode_) == 11) eTotKin += itp->energy_;
+       }
+       particle_position = geom_->GenerateVertex(region_);
+     } while (!filter_->Accept(eTotKin*MeV, particle_position));
      myEventCounter_++;
-     if (fOutDebug_.is_open() && keepEvt ) {
+     if (fOutDebug_.is_open()) {
        int k = 0;
        for (std::vector<decay0Part>::const_iterator itp = theParts.begin(); itp != theParts.end(); itp++, k++) {
          fOutDebug_ << " " << myEventCounter_ << " " << k << " " << itp->pdgCode_ << " "
@@ -120,11 +171,9 @@ void Decay0Interface::GeneratePrimaryVertex(G4Event* event)
 		   << itp->energy_ << " " << itp->time_ << std::endl;
         }
      }
-     if (runG4 && keepEvt) {
-        particle_position = geom_->GenerateVertex(region_);
+     if (runG4) {
         for (std::vector<decay0Part>::const_iterator itp = theParts.begin(); itp != theParts.end(); itp++) {
-          G4ParticleDefinition* g4code =
-             G4ParticleTable::GetParticleTable()->FindParticle(itp->pdgCode_);
+          G4ParticleDefinition* g4code = ParticleDefinition(itp->pdgCode_);
           G4PrimaryParticle* particle =
 	     new G4PrimaryParticle(g4code, MeV*itp->pmom_[0], MeV*itp->pmom_[1], MeV*itp->pmom_[2]);
          // create a primary vertex for the particle
@@ -139,49 +188,80 @@ void Decay0Interface::GeneratePrimaryVertex(G4Event* event)
 
   //G4cout << "GeneratePrimaryVertex()" << G4endl;
 
-  // reading event-related information
-  G4int entries;     // number of particles in the event
-  G4long evt_no;     // event number
-  G4double evt_time; // initial time in seconds
+  if (genbb_) {
+    ReadBinaryEvent(event);
+    return;
+  }
+
+  // skip the events of the file before the first one of this job
+  for (; next_event_ < start_event_; next_event_++) {
+    G4int entries;
+    G4long evt_no;
+    G4double evt_time;
+    file_ >> evt_no >> evt_time >> entries;
+    for (G4int i=0; i<=entries && file_; i++)
+      file_.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  }
 
-  file_ >> evt_no >> evt_time >> entries;
+  // Read events until one passes the filter
+  G4double electron_energy;
+  do {
+    // reading event-related information
+    G4int entries;     // number of particles in the event
+    G4long evt_no;     // event number
+    G4double evt_time; // initial time in seconds
 
+    file_ >> evt_no >> evt_time >> entries;
+    next_event_++;
 
-  // abort if end-of-file was reached in last operation
-  if (file_.eof()) {
-    G4cout  << "[Decay0Interface] End-of-File reached. "
-            << "Aborting the run..." << G4endl;
-    G4RunManager::GetRunManager()->AbortRun();
-    return;
-  }
 
-  //G4cout << "entries: " << entries << G4endl;
+    // abort if end-of-file was reached in last operation
+    if (file_.eof()) {
+      G4cout  << "[Decay0Interface] End-of-File reached. "
+              << "Aborting the run..." << G4endl;
+      G4RunManager::GetRunManager()->AbortRun();
+      return;
+    }
+
+    //G4cout << "entries: " << entries << G4endl;
+
+    // reading info for each particle in the event,
+    // with the energy of the electrons for the filter
+    particles_.resize(entries);
+    electron_energy = 0.;
 
-  // generate a position in the detector
-  // (all primary particles will be generated there)
-  particle_position = geom_->GenerateVertex(region_);
+    for (G4int i=0; i<entries; i++) {
+      //G4cout << i << G4endl;
 
+      G4int g3code;           // GEANT3 particle code
+      decay0Part& part = particles_[i];
 
-  // reading info for each particle in the event
-  for (G4int i=0; i<entries; i++) {
-    //G4cout << i << G4endl;
+      file_ >> g3code >> part.pmom_[0] >> part.pmom_[1] >> part.pmom_[2] >> part.time_;
+      part.pdgCode_ = G3toPDG(g3code);
 
-    G4int g3code;           // GEANT3 particle code
-    G4double px, py, pz;    // Momentum components in MeV
+      electron_energy += ElectronEnergy(part.pdgCode_, part.pmom_);
+    }
+
+    // generate a position in the detector
+    // (all primary particles will be generated there)
+    particle_position = geom_->GenerateVertex(region_);
 
-    file_ >> g3code >> px >> py >> pz >> particle_time;
+  } while (!filter_->Accept(electron_energy, particle_position));
 
-    G4ParticleDefinition* g4code =
-      G4ParticleTable::GetParticleTable()->FindParticle(G3toPDG(g3code));
+
+  for (size_t i=0; i<particles_.size(); i++) {
+    const decay0Part& part = particles_[i];
+    G4ParticleDefinition* g4code = ParticleDefinition(part.pdgCode_);
 
     // create a primary particle
     G4PrimaryParticle* particle =
-      new G4PrimaryParticle(g4code, px*MeV, py*MeV, pz*MeV);
+      new G4PrimaryParticle(g4code, part.pmom_[0]*MeV, part.pmom_[1]*MeV, part.pmom_[2]*MeV);
 
     particle->SetMass(g4code->GetPDGMass());
     particle->SetCharge(g4code->GetPDGCharge());
 
     // create a primary vertex for the particle
+    particle_time = part.time_;
     G4PrimaryVertex* vertex =
       new G4PrimaryVertex(particle_position, particle_time*second);
 
@@ -194,6 +274,66 @@ void Decay0Interface::GeneratePrimaryVertex(G4Event* event)
 
 
 
+void Decay0Interface::ReadBinaryEvent(G4Event* event)
+{
+  if (next_event_ < start_event_) next_event_ = start_event_;
+
+  // Take events from the mapped file until one passes the filter
+  GenbbFile::Event evt;
+  G4double electron_energy;
+  do {
+    if (next_event_ >= (G4long) genbb_->GetNumberOfEvents()) {
+      G4cout  << "[Decay0Interface] End-of-File reached. "
+              << "Aborting the run..." << G4endl;
+      G4RunManager::GetRunManager()->AbortRun();
+      return;
+    }
+
+    evt = genbb_->GetEvent(next_event_++);
+
+    electron_energy = 0.;
+    for (size_t i=0; i<evt.size; i++)
+      electron_energy += ElectronEnergy(evt.particles[i].pdg_code,
+                                        evt.particles[i].momentum);
+
+    particle_position = geom_->GenerateVertex(region_);
+
+  } while (!filter_->Accept(electron_energy, particle_position));
+
+  for (size_t i=0; i<evt.size; i++) {
+    const GenbbParticle& part = evt.particles[i];
+    G4ParticleDefinition* g4code = ParticleDefinition(part.pdg_code);
+
+    G4PrimaryParticle* particle =
+      new G4PrimaryParticle(g4code, part.momentum[0]*MeV,
+                            part.momentum[1]*MeV, part.momentum[2]*MeV);
+
+    particle->SetMass(g4code->GetPDGMass());
+    particle->SetCharge(g4code->GetPDGCharge());
+
+    particle_time = part.time;
+    G4PrimaryVertex* vertex =
+      new G4PrimaryVertex(particle_position, particle_time*second);
+
+    vertex->SetPrimary(particle);
+    event->AddPrimaryVertex(vertex);
+  }
+}
+
+
+
+G4double Decay0Interface::ElectronEnergy(G4int pdg, const G4double momentum[3])
+{
+  if (std::abs(pdg) != 11) return 0.;
+
+  G4double mass = ParticleDefinition(pdg)->GetPDGMass();
+  G4double p2 = (momentum[0]*momentum[0] + momentum[1]*momentum[1] +
+                 momentum[2]*momentum[2]) * MeV*MeV;
+  return std::sqrt(p2 + mass*mass) - mass;
+}
+
+
+
 void Decay0Interface::ProcessHeader()
 {
   G4String line;
@@ -206,6 +346,24 @@ void Decay0Interface::ProcessHeader()
 
 
 
+G4ParticleDefinition* Decay0Interface::ParticleDefinition(G4int pdg)
+{
+  std::map<G4int, G4ParticleDefinition*>::const_iterator it = definitions_.find(pdg);
+  if (it != definitions_.end()) return it->second;
+
+  G4ParticleDefinition* definition =
+    G4ParticleTable::GetParticleTable()->FindParticle(pdg);
+
+  if (!definition) {
+    G4Exception("[Decay0Interface]", "ParticleDefinition()", FatalException,
+                ("Unknown particle with PDG code " + std::to_string(pdg)).c_str());
+  }
+  definitions_[pdg] = definition;
+  return definition;
+}
+
+
+
 G4int Decay0Interface::G3toPDG(const G4int G3code)
 {
   int pdg_code = 0;
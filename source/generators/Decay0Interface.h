@@ -5,7 +5,8 @@
 // interfacing the DECAY0 c++ code, translated from the original
 // FORTRAN package, with nexus.
 // The possibility of reading a previously generated ascii file with the
-// electron momenta is also allowed.
+// electron momenta is also allowed, as well as its binary version made
+// with scripts/convert_genbb.py, which is memory-mapped.
 //
 // The NEXT Collaboration
 // ----------------------------------------------------------------------------
@@ -13,17 +14,24 @@
 #ifndef DECAY0_INTERFACE_H
 #define DECAY0_INTERFACE_H
 
+#include "decay0.h"
+
 #include <G4VPrimaryGenerator.hh>
 #include <fstream>
+#include <map>
+#include <vector>
 
 class G4GenericMessenger;
 class G4Event;
 class G4PrimaryParticle;
-class decay0;
+class G4ParticleDefinition;
 
 namespace nexus {
 
   class BaseGeometry;
+  class Decay0Producer;
+  class GenbbFile;
+  class GeneratorFilter;
 
 
   /// This primary generator sets the G4Event objects according to the
@@ -47,10 +55,20 @@ namespace nexus {
     void OpenInputFile(G4String);
     /// Parse information in the file header
     void ProcessHeader();
+    /// Generate the primaries of the next event of a binary file
+    void ReadBinaryEvent(G4Event*);
+
+    /// Kinetic energy of a particle if it is an electron
+    /// or a positron, zero otherwise
+    G4double ElectronEnergy(G4int pdg, const G4double momentum[3]);
 
     /// Return the PDG code equivalent to a given GEANT3 particle code
     G4int G3toPDG(const G4int);
 
+    /// Return the particle definition of a PDG code, looked
+    /// up in the particle table only the first time
+    G4ParticleDefinition* ParticleDefinition(G4int pdg);
+
   private:
     G4GenericMessenger* msg_;
 
@@ -67,13 +85,25 @@ namespace nexus {
                           // Valid list: 0, 819,  1551, 1579, 2080, 2129, 2141, 2223, 2315, 2400)
 			  // default is 0 (ground state)
 
-    double energyThreshold_;
+    G4int buffer_size_; ///< Decays generated in advance by a thread (0: none)
+    Decay0Producer* producer_;
+    std::vector<decay0Part> particles_; ///< Particles of the current decay
+
+    G4long start_event_; ///< First event of the input file read by this job
+    G4long next_event_;  ///< Index of the next event of the input file
+    GenbbFile* genbb_;   ///< Input file in binary format, if any
+
+    std::map<G4int, G4ParticleDefinition*> definitions_; ///< By PDG code
 
     std::ofstream fOutDebug_; // for debugging...
     const BaseGeometry* geom_;
 
+    /// Selection of the decays, on the summed energy of the
+    /// electrons and on the volume of the vertex
+    GeneratorFilter* filter_;
+
 
-    inline void SetEnergyThreshold(double e) { energyThreshold_ = e;}
+    void SetEnergyThreshold(double e);
     inline void SetXe136DecayMode(int dcm) { Xe136DecayMode_ = dcm;}
     inline void SetBa136FinalState(int fs) { Ba136FinalState_ = fs;}
   };
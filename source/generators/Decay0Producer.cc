@@ -0,0 +1,81 @@
+// ----------------------------------------------------------------------------
+// nexus | Decay0Producer.cc
+//
+// This class generates decay0 events in a dedicated thread, so that the
+// next decays are generated while the current event is being simulated.
+// Events are handed over through a ring buffer: the thread blocks when
+// the buffer is full and the simulation when it is empty.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#include "Decay0Producer.h"
+
+#include <CLHEP/Random/MixMaxRng.h>
+
+using namespace nexus;
+
+
+Decay0Producer::Decay0Producer(decay0* generator, size_t capacity, long seed):
+  generator_(generator), engine_(0), ring_(capacity), head_(0), count_(0),
+  stop_(false)
+{
+  // The Geant4 engine can't be shared with the simulation thread
+  engine_ = new CLHEP::MixMaxRng(seed);
+  generator_->SetRandomEngine(engine_);
+
+  thread_ = std::thread(&Decay0Producer::Run, this);
+}
+
+
+
+Decay0Producer::~Decay0Producer()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  not_full_.notify_all();
+
+  thread_.join();
+
+  delete engine_;
+}
+
+
+
+void Decay0Producer::Pop(std::vector<decay0Part>& particles)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  not_empty_.wait(lock, [this]{ return count_ > 0; });
+
+  // The thread gets back the buffers of the caller
+  particles.swap(ring_[head_]);
+  head_ = (head_ + 1) % ring_.size();
+  --count_;
+
+  lock.unlock();
+  not_full_.notify_one();
+}
+
+
+
+void Decay0Producer::Run()
+{
+  std::vector<decay0Part> particles;
+
+  while (true) {
+
+    generator_->decay0DoIt(particles);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this]{ return count_ < ring_.size() || stop_; });
+    if (stop_) break;
+
+    particles.swap(ring_[(head_ + count_) % ring_.size()]);
+    ++count_;
+
+    lock.unlock();
+    not_empty_.notify_one();
+  }
+}
@@ -0,0 +1,63 @@
+// ----------------------------------------------------------------------------
+// nexus | Decay0Producer.h
+//
+// This class generates decay0 events in a dedicated thread, so that the
+// next decays are generated while the current event is being simulated.
+// Events are handed over through a ring buffer: the thread blocks when
+// the buffer is full and the simulation when it is empty.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#ifndef DECAY0_PRODUCER_H
+#define DECAY0_PRODUCER_H
+
+#include "decay0.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CLHEP { class HepRandomEngine; }
+
+
+namespace nexus {
+
+  class Decay0Producer
+  {
+  public:
+    /// Constructor. The generator gets its own random engine,
+    /// initialized with the given seed, and the thread is started.
+    Decay0Producer(decay0* generator, size_t capacity, long seed);
+    /// Destructor. Stops the thread.
+    ~Decay0Producer();
+
+    /// Replace the content of the vector with the particles of the
+    /// next decay. Blocks while the buffer is empty.
+    void Pop(std::vector<decay0Part>& particles);
+
+  private:
+    /// Main loop of the producer thread
+    void Run();
+
+  private:
+    decay0* generator_; ///< Generator used by the thread
+    CLHEP::HepRandomEngine* engine_; ///< Random engine of the thread
+
+    std::vector<std::vector<decay0Part> > ring_; ///< Generated decays
+    size_t head_;  ///< Slot of the next decay to be handed over
+    size_t count_; ///< Number of generated decays in the buffer
+
+    bool stop_; ///< Should the thread finish?
+
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+
+    std::thread thread_;
+  };
+
+} // namespace nexus
+
+#endif
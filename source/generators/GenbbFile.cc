@@ -0,0 +1,113 @@
+// ----------------------------------------------------------------------------
+// nexus | GenbbFile.cc
+//
+// This class gives access to the events of a file in the binary genbb
+// format, which is memory-mapped and decoded without copies: the
+// particles of an event are read directly from the mapped file.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#include "GenbbFile.h"
+
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace nexus {
+
+  namespace {
+    const char genbb_magic[8] = {'N','X','G','E','N','B','B','1'};
+  }
+
+
+
+  GenbbFile::GenbbFile(const G4String& filename):
+    num_events_(0), offsets_(0), times_(0), particles_(0),
+    map_(0), map_size_(0)
+  {
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+      G4Exception("[GenbbFile]", "GenbbFile()", FatalErrorInArgument,
+                  ("Cannot open genbb file " + filename).c_str());
+    }
+
+    map_size_ = st.st_size;
+    // The mapping is shared, so parallel jobs reading
+    // the same file use a single physical copy of it
+    map_ = mmap(0, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map_ == MAP_FAILED) {
+      map_ = 0;
+      G4Exception("[GenbbFile]", "GenbbFile()", FatalException,
+                  ("Cannot map genbb file " + filename).c_str());
+    }
+
+    const char* data = static_cast<const char*>(map_);
+    GenbbHeader header;
+    if (map_size_ >= sizeof(header)) std::memcpy(&header, data, sizeof(header));
+
+    if (map_size_ < sizeof(header) ||
+        std::memcmp(header.magic, genbb_magic, sizeof(header.magic)) != 0 ||
+        header.version != 1) {
+      G4Exception("[GenbbFile]", "GenbbFile()", FatalErrorInArgument,
+                  ("Unsupported genbb file " + filename).c_str());
+    }
+
+    num_events_ = header.num_events;
+
+    size_t offsets_size   = (num_events_ + 1) * sizeof(uint64_t);
+    size_t times_size     = num_events_ * sizeof(double);
+    size_t particles_size = header.num_particles * sizeof(GenbbParticle);
+
+    if (map_size_ != sizeof(header) + offsets_size + times_size + particles_size) {
+      G4Exception("[GenbbFile]", "GenbbFile()", FatalErrorInArgument,
+                  ("Truncated genbb file " + filename).c_str());
+    }
+
+    data += sizeof(header);
+    offsets_   = reinterpret_cast<const uint64_t*>(data);
+    times_     = reinterpret_cast<const double*>(data + offsets_size);
+    particles_ = reinterpret_cast<const GenbbParticle*>(data + offsets_size + times_size);
+
+    // The offsets must never decrease, or the particles of an event
+    // would be read beyond the end of the file
+    G4bool sorted = true;
+    for (size_t i=0; i<num_events_ && sorted; ++i)
+      sorted = offsets_[i] <= offsets_[i+1];
+
+    if (offsets_[0] != 0 || offsets_[num_events_] != header.num_particles || !sorted) {
+      G4Exception("[GenbbFile]", "GenbbFile()", FatalErrorInArgument,
+                  ("Inconsistent event offsets in genbb file " + filename).c_str());
+    }
+
+    // The events are usually read in order
+    madvise(map_, map_size_, MADV_SEQUENTIAL);
+  }
+
+
+
+  GenbbFile::~GenbbFile()
+  {
+    if (map_) munmap(map_, map_size_);
+  }
+
+
+
+  G4bool GenbbFile::IsBinary(const G4String& filename)
+  {
+    std::ifstream file(filename, std::ifstream::binary);
+    char magic[sizeof(genbb_magic)] = {0};
+    file.read(magic, sizeof(magic));
+    return file && std::memcmp(magic, genbb_magic, sizeof(magic)) == 0;
+  }
+
+
+} // end namespace nexus
@@ -0,0 +1,87 @@
+// ----------------------------------------------------------------------------
+// nexus | GenbbFile.h
+//
+// This class gives access to the events of a file in the binary genbb
+// format, which is memory-mapped and decoded without copies: the
+// particles of an event are read directly from the mapped file.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#ifndef GENBB_FILE_H
+#define GENBB_FILE_H
+
+#include <globals.hh>
+
+#include <stdint.h>
+
+
+namespace nexus {
+
+  /// Binary format (native byte order):
+  ///   GenbbHeader
+  ///   uint64_t      offsets[num_events+1]  first particle of each event
+  ///   double        times[num_events]      start time of each event (s)
+  ///   GenbbParticle particles[num_particles]
+  /// The scripts/convert_genbb.py script converts genbb text files,
+  /// translating the GEANT3 particle codes to PDG codes.
+
+  struct GenbbHeader {
+    char     magic[8];      ///< "NXGENBB1"
+    uint32_t version;       ///< Format version (1)
+    uint32_t reserved;
+    uint64_t num_events;    ///< Number of events
+    uint64_t num_particles; ///< Number of particles of all the events
+  };
+
+  struct GenbbParticle {
+    int32_t pdg_code;    ///< PDG code of the particle
+    int32_t reserved;
+    double  momentum[3]; ///< Momentum components (MeV)
+    double  time;        ///< Time of the particle (s)
+  };
+
+  class GenbbFile
+  {
+  public:
+    /// Particles of an event, pointing to the mapped file
+    struct Event {
+      const GenbbParticle* particles;
+      size_t size; ///< Number of particles
+      G4double time; ///< Start time of the event (s)
+    };
+
+  public:
+    /// Constructor, mapping a binary genbb file
+    GenbbFile(const G4String& filename);
+    /// Destructor
+    ~GenbbFile();
+
+    /// Return true if the file starts as a binary genbb file
+    static G4bool IsBinary(const G4String& filename);
+
+    Event GetEvent(size_t i) const;
+    size_t GetNumberOfEvents() const;
+
+  private:
+    size_t num_events_;
+
+    const uint64_t* offsets_;
+    const double* times_;
+    const GenbbParticle* particles_;
+
+    void*  map_; ///< Mapped file
+    size_t map_size_;
+  };
+
+  inline GenbbFile::Event GenbbFile::GetEvent(size_t i) const
+  {
+    Event event = {particles_ + offsets_[i], size_t(offsets_[i+1] - offsets_[i]), times_[i]};
+    return event;
+  }
+
+  inline size_t GenbbFile::GetNumberOfEvents() const { return num_events_; }
+
+} // end namespace nexus
+
+#endif
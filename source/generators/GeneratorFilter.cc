@@ -0,0 +1,178 @@
+// ----------------------------------------------------------------------------
+// nexus | GeneratorFilter.cc
+//
+// This class applies a selection to the candidates of a primary generator,
+// which generates new candidates until one passes it, instead of emitting
+// empty events. The cuts, on the energy, the volume of the vertex or the
+// direction, are set through the "filter/" commands of the generator.
+// While a filter is in use, the number of candidates generated for each
+// event is passed to the persistency manager, which stores the numbers of
+// generated and accepted candidates in the configuration of the output.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#include "GeneratorFilter.h"
+#include "PersistencyManager.h"
+
+#include <G4GenericMessenger.hh>
+#include <G4TransportationManager.hh>
+#include <G4Navigator.hh>
+#include <G4VPhysicalVolume.hh>
+
+#include <algorithm>
+#include <cfloat>
+#include <sstream>
+
+using namespace nexus;
+
+
+GeneratorFilter::GeneratorFilter(const G4String& generator_dir, G4int cuts):
+  msg_(0), min_energy_(0.), max_energy_(DBL_MAX), volume_(""),
+  min_costheta_(-1.), max_costheta_(1.), axis_(0., 0., 1.),
+  max_trials_(1000000), trials_(0), generated_(0), accepted_(0),
+  navigator_(0)
+{
+  msg_ = new G4GenericMessenger(this, generator_dir + "filter/",
+    "Selection of the candidates of the generator.");
+
+  if (cuts & kEnergy) {
+    G4GenericMessenger::Command& min_energy_cmd =
+      msg_->DeclareProperty("min_energy", min_energy_,
+                            "Energy above which the candidates are accepted.");
+    min_energy_cmd.SetUnitCategory("Energy");
+    min_energy_cmd.SetParameterName("min_energy", false);
+    min_energy_cmd.SetRange("min_energy>=0.");
+
+    G4GenericMessenger::Command& max_energy_cmd =
+      msg_->DeclareProperty("max_energy", max_energy_,
+                            "Maximum energy of the accepted candidates.");
+    max_energy_cmd.SetUnitCategory("Energy");
+    max_energy_cmd.SetParameterName("max_energy", false);
+    max_energy_cmd.SetRange("max_energy>0.");
+  }
+
+  if (cuts & kVolume)
+    msg_->DeclareProperty("volume", volume_,
+                          "Volume where the vertices of the accepted candidates are.");
+
+  if (cuts & kDirection) {
+    G4GenericMessenger::Command& min_costheta_cmd =
+      msg_->DeclareProperty("min_costheta", min_costheta_,
+                            "Minimum cosine of the angle between the direction and the axis.");
+    min_costheta_cmd.SetParameterName("min_costheta", false);
+    min_costheta_cmd.SetRange("min_costheta>=-1. && min_costheta<=1.");
+
+    G4GenericMessenger::Command& max_costheta_cmd =
+      msg_->DeclareProperty("max_costheta", max_costheta_,
+                            "Maximum cosine of the angle between the direction and the axis.");
+    max_costheta_cmd.SetParameterName("max_costheta", false);
+    max_costheta_cmd.SetRange("max_costheta>=-1. && max_costheta<=1.");
+
+    msg_->DeclareProperty("axis", axis_, "Axis of the direction cut.");
+  }
+
+  G4GenericMessenger::Command& max_trials_cmd =
+    msg_->DeclareProperty("max_trials", max_trials_,
+                          "Maximum number of candidates generated for one event.");
+  max_trials_cmd.SetParameterName("max_trials", false);
+  max_trials_cmd.SetRange("max_trials>0");
+
+  Filters().push_back(this);
+}
+
+
+
+GeneratorFilter::~GeneratorFilter()
+{
+  std::vector<GeneratorFilter*>& filters = Filters();
+  filters.erase(std::remove(filters.begin(), filters.end(), this), filters.end());
+
+  delete msg_;
+  delete navigator_;
+}
+
+
+
+G4bool GeneratorFilter::Accept(G4double energy, const G4ThreeVector& position,
+                               const G4ThreeVector& direction)
+{
+  ++generated_;
+
+  if (++trials_ > max_trials_) {
+    std::ostringstream msg;
+    msg << "No candidate passed the filter after " << max_trials_ << " trials.";
+    G4Exception("[GeneratorFilter]", "Accept()", FatalException, msg.str().c_str());
+  }
+
+  // Strictly above the minimum energy, as the EnergyThreshold of
+  // Decay0Interface, which sets it, has always required
+  if ((min_energy_ > 0. && energy <= min_energy_) || energy > max_energy_)
+    return false;
+
+  if (volume_ != "" && VolumeName(position) != volume_)
+    return false;
+
+  if (min_costheta_ > -1. || max_costheta_ < 1.) {
+    G4double costheta = direction.unit().dot(axis_.unit());
+    if (costheta < min_costheta_ || costheta > max_costheta_)
+      return false;
+  }
+
+  ++accepted_;
+
+  // The candidates generated for the event are counted in the output
+  if (InUse()) {
+    PersistencyManager* pm = dynamic_cast<PersistencyManager*>
+      (G4VPersistencyManager::GetPersistencyManager());
+    if (pm) pm->CountCandidates(trials_, 1);
+  }
+
+  trials_ = 0;
+  return true;
+}
+
+
+
+G4String GeneratorFilter::VolumeName(const G4ThreeVector& position)
+{
+  // Own navigator on the world volume: locating the vertex with the
+  // tracking one would change its state while primaries are generated
+  if (!navigator_) {
+    navigator_ = new G4Navigator();
+    navigator_->SetWorldVolume(G4TransportationManager::GetTransportationManager()
+                               ->GetNavigatorForTracking()->GetWorldVolume());
+  }
+
+  G4VPhysicalVolume* volume =
+    navigator_->LocateGlobalPointAndSetup(position, 0, false);
+
+  return volume ? volume->GetName() : G4String("");
+}
+
+
+
+std::vector<GeneratorFilter*>& GeneratorFilter::Filters()
+{
+  static std::vector<GeneratorFilter*> filters;
+  return filters;
+}
+
+
+
+G4bool GeneratorFilter::HasCuts() const
+{
+  return min_energy_ > 0. || max_energy_ < DBL_MAX || volume_ != "" ||
+    min_costheta_ > -1. || max_costheta_ < 1.;
+}
+
+
+
+G4bool GeneratorFilter::InUse()
+{
+  for (size_t i=0; i<Filters().size(); ++i)
+    if (Filters()[i]->HasCuts() ||
+        Filters()[i]->GetGenerated() > Filters()[i]->GetAccepted())
+      return true;
+  return false;
+}
@@ -0,0 +1,90 @@
+// ----------------------------------------------------------------------------
+// nexus | GeneratorFilter.h
+//
+// This class applies a selection to the candidates of a primary generator,
+// which generates new candidates until one passes it, instead of emitting
+// empty events. The cuts, on the energy, the volume of the vertex or the
+// direction, are set through the "filter/" commands of the generator.
+// While a filter is in use, the number of candidates generated for each
+// event is passed to the persistency manager, which stores the numbers of
+// generated and accepted candidates in the configuration of the output.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#ifndef GENERATOR_FILTER_H
+#define GENERATOR_FILTER_H
+
+#include <G4ThreeVector.hh>
+
+#include <vector>
+
+class G4GenericMessenger;
+class G4Navigator;
+
+
+namespace nexus {
+
+  class GeneratorFilter
+  {
+  public:
+    /// Cuts that can be applied to the candidates of a generator
+    enum Cut { kEnergy = 1, kVolume = 2, kDirection = 4 };
+
+  public:
+    /// Constructor, with the messenger directory of the generator
+    /// and the cuts (combination of Cut values) that make sense for it
+    GeneratorFilter(const G4String& generator_dir, G4int cuts);
+    /// Destructor
+    ~GeneratorFilter();
+
+    /// Return true if the candidate passes the cuts. Every call counts
+    /// as a generated candidate. The energy and direction of the
+    /// candidate are defined by each generator.
+    G4bool Accept(G4double energy, const G4ThreeVector& position,
+                  const G4ThreeVector& direction = G4ThreeVector());
+
+    void SetMinEnergy(G4double);
+
+    G4long GetGenerated() const;
+    G4long GetAccepted() const;
+
+    /// Return true if any filter has a cut set or has rejected candidates
+    static G4bool InUse();
+
+  private:
+    static std::vector<GeneratorFilter*>& Filters();
+
+    /// Return true if any cut differs from its default, accepting all
+    G4bool HasCuts() const;
+
+    /// Name of the volume containing a point
+    G4String VolumeName(const G4ThreeVector&);
+
+  private:
+    G4GenericMessenger* msg_;
+
+    G4double min_energy_;
+    G4double max_energy_;
+    G4String volume_; ///< Volume of the vertices, all if empty
+    G4double min_costheta_;
+    G4double max_costheta_;
+    G4ThreeVector axis_; ///< Axis of the direction cut
+
+    G4long max_trials_; ///< Maximum number of candidates for one event
+    G4long trials_;     ///< Candidates rejected since the last accepted one
+
+    G4long generated_;
+    G4long accepted_;
+
+    G4Navigator* navigator_; ///< Locates the vertices for the volume cut
+  };
+
+  inline void GeneratorFilter::SetMinEnergy(G4double e) { min_energy_ = e; }
+
+  inline G4long GeneratorFilter::GetGenerated() const { return generated_; }
+  inline G4long GeneratorFilter::GetAccepted() const { return accepted_; }
+
+} // end namespace nexus
+
+#endif
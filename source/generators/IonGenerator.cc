@@ -12,6 +12,7 @@
 
 #include "BaseGeometry.h"
 #include "DetectorConstruction.h"
+#include "GeneratorFilter.h"
 
 #include <G4GenericMessenger.hh>
 #include <G4RunManager.hh>
@@ -27,7 +28,7 @@ IonGenerator::IonGenerator():
   atomic_number_(0), mass_number_(0), energy_level_(0.),
   decay_at_time_zero_(true),
   region_(""),
-  msg_(nullptr), geom_(nullptr)
+  msg_(nullptr), geom_(nullptr), filter_(nullptr)
 {
   msg_ = new G4GenericMessenger(this, "/Generator/IonGenerator/",
                                 "Control commands of the ion gun primary generator.");
@@ -59,11 +60,15 @@ IonGenerator::IonGenerator():
     (G4RunManager::GetRunManager()->GetUserDetectorConstruction());
   if (detconst) geom_ = detconst->GetGeometry();
   else G4Exception("[IonGenerator]", "IonGenerator()", FatalException, "Unable to load geometry.");
+
+  // Only the volume of the vertex is known before the decay
+  filter_ = new GeneratorFilter("/Generator/IonGenerator/", GeneratorFilter::kVolume);
 }
 
 
 IonGenerator::~IonGenerator()
 {
+  delete filter_;
   delete msg_;
 }
 
@@ -98,8 +103,12 @@ void IonGenerator::GeneratePrimaryVertex(G4Event* event)
   // Create the new primary particle (i.e. the ion)
   G4PrimaryParticle* ion = new G4PrimaryParticle(pdef);
 
-  // Generate an initial position for the ion using the geometry
-  G4ThreeVector position = geom_->GenerateVertex(region_);
+  // Generate an initial position for the ion using the geometry,
+  // until one passes the filter of the generator
+  G4ThreeVector position;
+  do {
+    position = geom_->GenerateVertex(region_);
+  } while (!filter_->Accept(0., position));
   // Ion generated at the start-of-event time
   G4double time = 0.;
   // Create a new vertex
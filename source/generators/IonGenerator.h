@@ -21,6 +21,7 @@ class G4ParticleDefinition;
 namespace nexus{
 
   class BaseGeometry;
+  class GeneratorFilter;
 
   class IonGenerator: public G4VPrimaryGenerator
   {
@@ -44,6 +45,7 @@ namespace nexus{
     G4String region_;
     G4GenericMessenger* msg_;
     const BaseGeometry* geom_;
+    GeneratorFilter* filter_; ///< Selection of the vertices
   };
 
 } // end namespace nexus
@@ -13,7 +13,6 @@
 #include <G4GenericMessenger.hh>
 #include <G4ParticleDefinition.hh>
 #include <G4RunManager.hh>
-#include <G4ParticleTable.hh>
 #include <G4PrimaryVertex.hh>
 #include <G4Event.hh>
 #include <G4RandomDirection.hh>
@@ -21,20 +20,31 @@
 #include <G4OpticalPhoton.hh>
 #include "MuonsPointSampler.h"
 #include "AddUserInfoToPV.h"
+#include "AliasSampler.h"
+
+#include <G4MuonPlus.hh>
+#include <G4MuonMinus.hh>
+#include <G4VSolid.hh>
+#include <G4VPhysicalVolume.hh>
+#include <G4LogicalVolume.hh>
 
-#include <TMath.h>
 #include "TFile.h"
 #include "TH2F.h"
 #include "CLHEP/Units/SystemOfUnits.h"
 
+#include <algorithm>
+#include <cmath>
+
 using namespace nexus;
 using namespace CLHEP;
 
 
 MuonAngleGenerator::MuonAngleGenerator():
   G4VPrimaryGenerator(), msg_(0), particle_definition_(0),
-  angular_generation_(true), rPhi_(NULL), energy_min_(0.),
-  energy_max_(0.), distribution_(0), geom_(0), geom_solid_(0)
+  mu_plus_(0), mu_minus_(0),
+  angular_generation_(true), importance_sampling_(false), rPhi_(NULL),
+  energy_min_(0.), energy_max_(0.), distribution_(0), angle_sampler_(0),
+  plane_y_(0.), geom_(0), geom_solid_(0)
 {
   msg_ = new G4GenericMessenger(this, "/Generator/MuonAngleGenerator/",
 				"Control commands of muongenerator.");
@@ -57,6 +67,10 @@ MuonAngleGenerator::MuonAngleGenerator():
   msg_->DeclareProperty("angles_on", angular_generation_,
 			"Distribute muon directions according to file?");
 
+  msg_->DeclareProperty("importance_sampling", importance_sampling_,
+			"Generate the vertices only where the muons can reach the "
+			"detector, weighting the events by the acceptance?");
+
   msg_->DeclareProperty("angle_file", ang_file_,
 			"Name of the file containing angular distribution.");
   msg_->DeclareProperty("angle_dist", dist_name_,
@@ -72,12 +86,15 @@ MuonAngleGenerator::MuonAngleGenerator():
   DetectorConstruction* detconst = (DetectorConstruction*) G4RunManager::GetRunManager()->GetUserDetectorConstruction();
   geom_ = detconst->GetGeometry();
 
+  mu_plus_  = G4MuonPlus::Definition();
+  mu_minus_ = G4MuonMinus::Definition();
 }
 
 
 MuonAngleGenerator::~MuonAngleGenerator()
 {
 
+  delete angle_sampler_;
   delete msg_;
 }
 
@@ -95,24 +112,192 @@ void MuonAngleGenerator::SetupAngles()
   distribution_->SetDirectory(0);
   angle_file.Close();
 
-  // Get the solid to check overlap
-  geom_solid_ =
-    geom_->GetLogicalVolume()->GetDaughter(0)->GetLogicalVolume()->GetSolid();
+  // Get the solid to check overlap, and the transformation
+  // of the points from the world to its placement frame
+  G4VPhysicalVolume* envelope = geom_->GetLogicalVolume()->GetDaughter(0);
+  geom_solid_ = envelope->GetLogicalVolume()->GetSolid();
+  geom_transform_ =
+    G4AffineTransform(envelope->GetRotation(), envelope->GetTranslation()).Inverse();
+
+  // Bins of the distribution with entries, sampled
+  // from an alias table instead of TH2::GetRandom2
+  for (G4int ix=1; ix<=distribution_->GetNbinsX(); ++ix)
+    for (G4int iy=1; iy<=distribution_->GetNbinsY(); ++iy)
+      if (distribution_->GetBinContent(ix, iy) > 0.) {
+        bin_x_.push_back(ix);
+        bin_y_.push_back(iy);
+      }
+
+  if (importance_sampling_)
+    SetupFootprints();
+
+  std::vector<G4double> contents(bin_x_.size());
+  for (size_t i=0; i<bin_x_.size(); ++i)
+    contents[i] = distribution_->GetBinContent(bin_x_[i], bin_y_[i]);
+
+  angle_sampler_ = new AliasSampler(contents);
+}
+
+
+void MuonAngleGenerator::SetupFootprints()
+{
+  // The generation region must be a horizontal plane sampled
+  // uniformly, whose extent is estimated from random vertices
+  const G4int num_points = 10000;
+  plane_.xmin = plane_.zmin =  kInfinity;
+  plane_.xmax = plane_.zmax = -kInfinity;
+
+  for (G4int i=0; i<num_points; ++i) {
+    G4ThreeVector point = geom_->GenerateVertex(region_);
+    if (i == 0)
+      plane_y_ = point.y();
+    else if (std::abs(point.y() - plane_y_) > 1. * micrometer)
+      G4Exception("[MuonAngleGenerator]", "SetupFootprints()", FatalException,
+                  "Importance sampling needs a horizontal generation plane.");
+    plane_.xmin = std::min(plane_.xmin, point.x());
+    plane_.xmax = std::max(plane_.xmax, point.x());
+    plane_.zmin = std::min(plane_.zmin, point.z());
+    plane_.zmax = std::max(plane_.zmax, point.z());
+  }
 
+  // Unbiased estimate of the edges of a uniform distribution
+  G4double dx = (plane_.xmax - plane_.xmin) / (num_points - 1);
+  G4double dz = (plane_.zmax - plane_.zmin) / (num_points - 1);
+  plane_.xmin -= dx; plane_.xmax += dx;
+  plane_.zmin -= dz; plane_.zmax += dz;
+  G4double plane_area = (plane_.xmax - plane_.xmin) * (plane_.zmax - plane_.zmin);
+
+  // Corners of the envelope of the detector, in the world frame
+  G4ThreeVector bmin, bmax;
+  geom_solid_->BoundingLimits(bmin, bmax);
+  G4AffineTransform to_world = geom_transform_.Inverse();
+  std::vector<G4ThreeVector> corners;
+  G4double top = -kInfinity;
+  for (G4int c=0; c<8; ++c) {
+    corners.push_back(to_world.TransformPoint(
+      G4ThreeVector((c & 1) ? bmax.x() : bmin.x(),
+                    (c & 2) ? bmax.y() : bmin.y(),
+                    (c & 4) ? bmax.z() : bmin.z())));
+    top = std::max(top, corners.back().y());
+  }
+  if (top >= plane_y_)
+    G4Exception("[MuonAngleGenerator]", "SetupFootprints()", FatalException,
+                "The generation plane must be above the detector.");
+
+  // For each bin, the vertices whose line crosses the envelope
+  // are those within the projection of its corners along the
+  // directions of the bin, computed on a grid of directions
+  // enlarged by the largest distance between neighbouring points
+  const G4int num_dirs = 5;
+  std::vector<G4double> xs(num_dirs*num_dirs), zs(num_dirs*num_dirs);
+  const G4int num_hit_trials = 1000;
+
+  std::vector<G4int> bin_x, bin_y;
+  G4double total = 0., kept = 0.;
+
+  for (size_t b=0; b<bin_x_.size(); ++b) {
+    G4double content = distribution_->GetBinContent(bin_x_[b], bin_y_[b]);
+    total += content;
+
+    // !! Current distribution in units of pi
+    G4double az_min = distribution_->GetXaxis()->GetBinLowEdge(bin_x_[b]) * pi;
+    G4double az_max = distribution_->GetXaxis()->GetBinUpEdge (bin_x_[b]) * pi;
+    G4double ze_min = distribution_->GetYaxis()->GetBinLowEdge(bin_y_[b]) * pi;
+    G4double ze_max = distribution_->GetYaxis()->GetBinUpEdge (bin_y_[b]) * pi;
+
+    Footprint fp = plane_;
+
+    // Close to the horizon, the whole plane
+    if (std::cos(ze_max) > 1.e-3) {
+      fp.xmin = fp.zmin =  kInfinity;
+      fp.xmax = fp.zmax = -kInfinity;
+      G4double margin = 0.;
+
+      for (size_t c=0; c<corners.size(); ++c) {
+        const G4ThreeVector& corner = corners[c];
+        G4double height = plane_y_ - corner.y();
+
+        for (G4int i=0; i<num_dirs; ++i)
+          for (G4int j=0; j<num_dirs; ++j) {
+            G4ThreeVector dir =
+              Direction(ze_min + (ze_max - ze_min) * i / (num_dirs - 1),
+                        az_min + (az_max - az_min) * j / (num_dirs - 1));
+            G4ThreeVector point = corner + height / dir.y() * dir;
+
+            G4int k = i * num_dirs + j;
+            xs[k] = point.x();
+            zs[k] = point.z();
+            if (i > 0)
+              margin = std::max(margin, std::hypot(xs[k] - xs[k-num_dirs],
+                                                   zs[k] - zs[k-num_dirs]));
+            if (j > 0)
+              margin = std::max(margin, std::hypot(xs[k] - xs[k-1],
+                                                   zs[k] - zs[k-1]));
+
+            fp.xmin = std::min(fp.xmin, point.x());
+            fp.xmax = std::max(fp.xmax, point.x());
+            fp.zmin = std::min(fp.zmin, point.z());
+            fp.zmax = std::max(fp.zmax, point.z());
+          }
+      }
+
+      fp.xmin = std::max(fp.xmin - margin, plane_.xmin);
+      fp.xmax = std::min(fp.xmax + margin, plane_.xmax);
+      fp.zmin = std::max(fp.zmin - margin, plane_.zmin);
+      fp.zmax = std::min(fp.zmax + margin, plane_.zmax);
+    }
+
+    // Bins whose muons never reach the detector
+    if (fp.xmax <= fp.xmin || fp.zmax <= fp.zmin) continue;
+
+    // Only part of the muons of the footprint cross the detector,
+    // and the vertices are generated until one does: the fraction
+    // of them that hit it is estimated with random muons of the bin
+    footprints_.push_back(fp);
+    G4int hits = 0;
+    for (G4int i=0; i<num_hit_trials; ++i)
+      if (CheckOverlap(FootprintVertex(footprints_.size() - 1), BinDirection(b)))
+        ++hits;
+
+    if (hits == 0) {
+      footprints_.pop_back();
+      continue;
+    }
+
+    kept += content;
+    bin_x.push_back(bin_x_[b]);
+    bin_y.push_back(bin_y_[b]);
+    acceptance_.push_back((fp.xmax - fp.xmin) * (fp.zmax - fp.zmin) / plane_area *
+                          hits / num_hit_trials);
+  }
+
+  if (footprints_.empty())
+    G4Exception("[MuonAngleGenerator]", "SetupFootprints()", FatalException,
+                "No muon of the distribution reaches the detector.");
+
+  // The weight of an event is the probability that a muon
+  // generated in the whole plane reaches the detector
+  for (size_t b=0; b<acceptance_.size(); ++b)
+    acceptance_[b] *= kept / total;
+
+  bin_x_.swap(bin_x);
+  bin_y_.swap(bin_y);
 }
 
 
 void MuonAngleGenerator::GeneratePrimaryVertex(G4Event* event)
 {
+  // The footprints of the importance sampling are
+  // computed for the directions of the distribution
+  if (importance_sampling_ && !angular_generation_)
+    G4Exception("[MuonAngleGenerator]", "GeneratePrimaryVertex()", FatalException,
+                "The importance sampling requires the angular distribution "
+                "(angles_on true).");
 
   if (angular_generation_ && rPhi_ == NULL)
     SetupAngles();
 
-  particle_definition_ =
-    G4ParticleTable::GetParticleTable()->FindParticle(MuonCharge());
-  if (!particle_definition_)
-    G4Exception("[MuonAngleGenerator]", "SetParticleDefinition()",
-                FatalException, " can not create a muon ");
+  particle_definition_ = MuonCharge();
 
   // Generate uniform random energy in [E_min, E_max]
   G4double kinetic_energy = RandomEnergy();
@@ -122,12 +307,23 @@ void MuonAngleGenerator::GeneratePrimaryVertex(G4Event* event)
   G4double energy = kinetic_energy + mass;
   G4double pmod   = std::sqrt(energy*energy - mass*mass);
 
-  G4ThreeVector position = geom_->GenerateVertex(region_);
+  G4ThreeVector position;
   G4ThreeVector p_dir(0., -1., 0.);
-  if (angular_generation_){
-    GetDirection(p_dir);
+  G4double weight = 1.;
+  if (angular_generation_ && importance_sampling_){
+    size_t bin = GetDirection(p_dir);
+    position = FootprintVertex(bin);
     while ( !CheckOverlap(position, p_dir) )
-      position = geom_->GenerateVertex(region_);
+      position = FootprintVertex(bin);
+    weight = acceptance_[bin];
+  }
+  else {
+    position = geom_->GenerateVertex(region_);
+    if (angular_generation_){
+      GetDirection(p_dir);
+      while ( !CheckOverlap(position, p_dir) )
+        position = geom_->GenerateVertex(region_);
+    }
   }
 
   G4double px = pmod * p_dir.x();
@@ -138,6 +334,7 @@ void MuonAngleGenerator::GeneratePrimaryVertex(G4Event* event)
   G4double time = 0.;
   // Create a new vertex
   G4PrimaryVertex* vertex = new G4PrimaryVertex(position, time);
+  vertex->SetWeight(weight);
 
   // Create the new primary particle and set it some properties
   G4PrimaryParticle* particle =
@@ -158,32 +355,61 @@ G4double MuonAngleGenerator::RandomEnergy() const
 }
 
 
-G4String MuonAngleGenerator::MuonCharge() const
+G4ParticleDefinition* MuonAngleGenerator::MuonCharge() const
 {
   G4double rndCh = 2.3 *G4UniformRand(); //From PDG cosmic muons  mu+/mu- = 1.3
   if (rndCh <1.3)
-    return "mu+";
+    return mu_plus_;
   else
-    return "mu-";
+    return mu_minus_;
 }
 
 
-void MuonAngleGenerator::GetDirection(G4ThreeVector& dir)
+size_t MuonAngleGenerator::GetDirection(G4ThreeVector& dir)
+{
+  size_t bin = angle_sampler_->Shoot();
+  dir = BinDirection(bin);
+
+  return bin;
+}
+
+
+G4ThreeVector MuonAngleGenerator::BinDirection(size_t bin) const
 {
   // GetAngles from file?? Azimuth defined anticlockwise
-  // From north
-  G4double zenith  = 0.;
-  G4double azimuth = 0.;
-  distribution_->GetRandom2(azimuth, zenith);
+  // From north. Uniform within the bin, as in TH2::GetRandom2
+  const TAxis* az_axis = distribution_->GetXaxis();
+  const TAxis* ze_axis = distribution_->GetYaxis();
+  G4double azimuth = az_axis->GetBinLowEdge(bin_x_[bin]) +
+    az_axis->GetBinWidth(bin_x_[bin]) * G4UniformRand();
+  G4double zenith  = ze_axis->GetBinLowEdge(bin_y_[bin]) +
+    ze_axis->GetBinWidth(bin_y_[bin]) * G4UniformRand();
+
   // !! Current distribution in units of pi
-  zenith  *= pi;
-  azimuth *= pi;
+  return Direction(zenith * pi, azimuth * pi);
+}
+
 
-  dir.setX(sin(zenith) * sin(azimuth));
-  dir.setY(-cos(zenith));
-  dir.setZ(-sin(zenith) * cos(azimuth));
+G4ThreeVector MuonAngleGenerator::Direction(G4double zenith,
+                                            G4double azimuth) const
+{
+  G4ThreeVector dir(sin(zenith) * sin(azimuth),
+                    -cos(zenith),
+                    -sin(zenith) * cos(azimuth));
 
   dir *= *rPhi_;
+
+  return dir;
+}
+
+
+G4ThreeVector MuonAngleGenerator::FootprintVertex(size_t bin) const
+{
+  const Footprint& fp = footprints_[bin];
+  G4double x = fp.xmin + (fp.xmax - fp.xmin) * G4UniformRand();
+  G4double z = fp.zmin + (fp.zmax - fp.zmin) * G4UniformRand();
+
+  return G4ThreeVector(x, plane_y_, z);
 }
 
 
@@ -193,7 +419,8 @@ G4bool MuonAngleGenerator::CheckOverlap(const G4ThreeVector& vtx,
   // Check for overlap between generated vertex+direction
   // and the geometry.
 
-  if (geom_solid_->DistanceToIn(vtx, dir) == kInfinity)
+  if (geom_solid_->DistanceToIn(geom_transform_.TransformPoint(vtx),
+                                geom_transform_.TransformAxis(dir)) == kInfinity)
     return false;
 
   return true;
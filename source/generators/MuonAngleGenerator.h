@@ -12,6 +12,9 @@
 
 #include <G4VPrimaryGenerator.hh>
 #include <G4RotationMatrix.hh>
+#include <G4AffineTransform.hh>
+
+#include <vector>
 
 class G4GenericMessenger;
 class G4Event;
@@ -24,6 +27,7 @@ class TH2F;
 namespace nexus {
 
   class BaseGeometry;
+  class AliasSampler;
 
   class MuonAngleGenerator: public G4VPrimaryGenerator
   {
@@ -45,12 +49,27 @@ namespace nexus {
     // setting the overlap volume for filtering.
     void SetupAngles();
 
+    /// Find the horizontal generation plane and the footprint on it
+    /// of the detector envelope for each bin of the angular distribution
+    void SetupFootprints();
+
     /// Generate a random kinetic energy with flat probability in
     //  the interval [energy_min, energy_max].
     G4double RandomEnergy() const;
-    G4String MuonCharge() const;
+    G4ParticleDefinition* MuonCharge() const;
+
+    /// Sets a random direction of the angular distribution
+    /// and returns the index of its bin
+    size_t GetDirection(G4ThreeVector& dir);
+
+    /// Random direction within a bin of the angular distribution
+    G4ThreeVector BinDirection(size_t bin) const;
 
-    void GetDirection(G4ThreeVector& dir);
+    /// Direction of a muon given its zenith and azimuth angles
+    G4ThreeVector Direction(G4double zenith, G4double azimuth) const;
+
+    /// Random vertex in the footprint of a bin
+    G4ThreeVector FootprintVertex(size_t bin) const;
 
     G4bool CheckOverlap(const G4ThreeVector& vtx,
     			const G4ThreeVector& dir);
@@ -59,8 +78,11 @@ namespace nexus {
     G4GenericMessenger* msg_;
 
     G4ParticleDefinition* particle_definition_;
+    G4ParticleDefinition* mu_plus_;
+    G4ParticleDefinition* mu_minus_;
 
     G4bool angular_generation_; ///< Distribution or all downwards
+    G4bool importance_sampling_; ///< Vertices only where the detector is reached
     G4double axis_rotation_; ///< Angle between North and +z
     G4RotationMatrix *rPhi_; ///< Rotation to adjust axes
 
@@ -73,9 +95,22 @@ namespace nexus {
 
     TH2F * distribution_; ///< Anglular distribution
 
+    AliasSampler* angle_sampler_; ///< Sampler of the bins of the distribution
+    std::vector<G4int> bin_x_; ///< Azimuth bin of each index of the sampler
+    std::vector<G4int> bin_y_; ///< Zenith bin of each index of the sampler
+
+    /// Rectangle of the generation plane, in x and z
+    struct Footprint { G4double xmin, xmax, zmin, zmax; };
+
+    G4double plane_y_; ///< Height of the generation plane
+    Footprint plane_;  ///< Extent of the generation plane
+    std::vector<Footprint> footprints_; ///< Footprint of each bin
+    std::vector<G4double> acceptance_;  ///< Weight of the events of each bin
+
     const BaseGeometry* geom_; ///< Pointer to the detector geometry
 
     G4VSolid * geom_solid_;
+    G4AffineTransform geom_transform_; ///< From the world to the frame of the solid
 
   };
 
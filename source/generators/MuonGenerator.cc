@@ -13,7 +13,6 @@
 #include <G4GenericMessenger.hh>
 #include <G4ParticleDefinition.hh>
 #include <G4RunManager.hh>
-#include <G4ParticleTable.hh>
 #include <G4PrimaryVertex.hh>
 #include <G4Event.hh>
 #include <G4RandomDirection.hh>
@@ -21,20 +20,24 @@
 #include <G4OpticalPhoton.hh>
 #include "MuonsPointSampler.h"
 #include "AddUserInfoToPV.h"
+#include "InverseCDFSampler.h"
 
-#include "TF1.h"
+#include <G4MuonPlus.hh>
+#include <G4MuonMinus.hh>
 
-#include <TMath.h>
 #include "CLHEP/Units/SystemOfUnits.h"
 
+#include <cmath>
+
 using namespace nexus;
 using namespace CLHEP;
 
 
 MuonGenerator::MuonGenerator():
   G4VPrimaryGenerator(), msg_(0), particle_definition_(0),
+  mu_plus_(0), mu_minus_(0),
   energy_min_(0.), energy_max_(0.), geom_(0), momentum_X_(0.),
-  momentum_Y_(0.), momentum_Z_(0.)
+  momentum_Y_(0.), momentum_Z_(0.), theta_sampler_(0)
 {
   msg_ = new G4GenericMessenger(this, "/Generator/MuonGenerator/",
 				"Control commands of muongenerator.");
@@ -62,6 +65,13 @@ MuonGenerator::MuonGenerator():
   DetectorConstruction* detconst = (DetectorConstruction*) G4RunManager::GetRunManager()->GetUserDetectorConstruction();
   geom_ = detconst->GetGeometry();
 
+  mu_plus_  = G4MuonPlus::Definition();
+  mu_minus_ = G4MuonMinus::Definition();
+
+  // Zenith angle distribution at sea level, tabulated once for all events
+  theta_sampler_ =
+    new InverseCDFSampler([](G4double x) { return std::pow(std::cos(x), 2); },
+                          0., pi/2);
 }
 
 
@@ -69,15 +79,13 @@ MuonGenerator::MuonGenerator():
 MuonGenerator::~MuonGenerator()
 {
 
+  delete theta_sampler_;
   delete msg_;
 }
 
 void MuonGenerator::GeneratePrimaryVertex(G4Event* event)
 {
-  particle_definition_ = G4ParticleTable::GetParticleTable()->FindParticle(MuonCharge());
-  if (!particle_definition_)
-    G4Exception("[MuonGenerator]", "SetParticleDefinition()",
-                FatalException, " can not create a muon ");
+  particle_definition_ = MuonCharge();
 
   // Generate an initial position for the particle using the geometry
   G4ThreeVector position = geom_->GenerateVertex(region_);
@@ -145,21 +153,19 @@ G4double MuonGenerator::RandomEnergy() const
     return G4UniformRand()*(energy_max_ - energy_min_) + energy_min_;
 }
 
-G4String MuonGenerator::MuonCharge() const
+G4ParticleDefinition* MuonGenerator::MuonCharge() const
 {
   G4double rndCh = 2.3 *G4UniformRand(); //From PDG cosmic muons  mu+/mu- = 1.3
   if (rndCh <1.3)
-    return "mu+";
+    return mu_plus_;
   else
-    return "mu-";
+    return mu_minus_;
 }
 
 
 G4double MuonGenerator::GetTheta() const
 {
-  TF1 *f1 = new TF1("f1","pow(cos(x),2)",0,pi/2);
-  G4double theta = f1->GetRandom();
-  return theta;
+  return theta_sampler_->Shoot();
 }
 
 
@@ -20,6 +20,7 @@ class G4ParticleDefinition;
 namespace nexus {
 
   class BaseGeometry;
+  class InverseCDFSampler;
 
   class MuonGenerator: public G4VPrimaryGenerator
   {
@@ -39,7 +40,7 @@ namespace nexus {
     /// Generate a random kinetic energy with flat probability in
     //  the interval [energy_min, energy_max].
     G4double RandomEnergy() const;
-    G4String MuonCharge() const;
+    G4ParticleDefinition* MuonCharge() const;
     G4double GetPhi() const;
     G4double GetTheta() const;
 
@@ -47,6 +48,8 @@ namespace nexus {
     G4GenericMessenger* msg_;
 
     G4ParticleDefinition* particle_definition_;
+    G4ParticleDefinition* mu_plus_;  ///< Muon definitions, looked up once
+    G4ParticleDefinition* mu_minus_;
 
     G4double energy_min_; ///< Minimum kinetic energy
     G4double energy_max_; ///< Maximum kinetic energy
@@ -59,6 +62,8 @@ namespace nexus {
     G4double momentum_Y_;
     G4double momentum_Z_;
 
+    InverseCDFSampler* theta_sampler_; ///< Sampler of the cos^2 distribution
+
   };
 
 } // end namespace nexus
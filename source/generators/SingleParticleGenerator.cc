@@ -16,6 +16,7 @@
 #include "DetectorConstruction.h"
 #include "BaseGeometry.h"
 #include "RandomUtils.h"
+#include "GeneratorFilter.h"
 
 #include <G4GenericMessenger.hh>
 #include <G4ParticleDefinition.hh>
@@ -37,7 +38,7 @@ SingleParticleGenerator::SingleParticleGenerator():
 G4VPrimaryGenerator(), msg_(0), particle_definition_(0),
 energy_min_(0.), energy_max_(0.), geom_(0), momentum_X_(0.),
 momentum_Y_(0.), momentum_Z_(0.), costheta_min_(-1.),
-costheta_max_(1.), phi_min_(0.), phi_max_(2.*pi)
+costheta_max_(1.), phi_min_(0.), phi_max_(2.*pi), filter_(0)
 {
   msg_ = new G4GenericMessenger(this, "/Generator/SingleParticle/",
     "Control commands of single-particle generator.");
@@ -81,12 +82,16 @@ costheta_max_(1.), phi_min_(0.), phi_max_(2.*pi)
 
   DetectorConstruction* detconst = (DetectorConstruction*) G4RunManager::GetRunManager()->GetUserDetectorConstruction();
   geom_ = detconst->GetGeometry();
+
+  filter_ = new GeneratorFilter("/Generator/SingleParticle/",
+    GeneratorFilter::kEnergy | GeneratorFilter::kVolume | GeneratorFilter::kDirection);
 }
 
 
 
 SingleParticleGenerator::~SingleParticleGenerator()
 {
+  delete filter_;
   delete msg_;
 }
 
@@ -106,8 +111,45 @@ void SingleParticleGenerator::SetParticleDefinition(G4String particle_name)
 
 void SingleParticleGenerator::GeneratePrimaryVertex(G4Event* event)
 {
-  // Generate an initial position for the particle using the geometry
-  G4ThreeVector position = geom_->GenerateVertex(region_);
+  G4ThreeVector position;
+  G4double kinetic_energy;
+  G4double px, py, pz;
+
+  // Generate candidates until one passes the filter of the generator
+  do {
+    // Generate an initial position for the particle using the geometry
+    position = geom_->GenerateVertex(region_);
+
+    // Generate uniform random energy in [E_min, E_max]
+    kinetic_energy = nexus::RandomEnergy(energy_max_,energy_min_); //////////////////////changes here
+
+    // Generate random direction by default
+    G4ThreeVector _momentum_direction = G4RandomDirection();
+
+    // Calculate cartesian components of momentum
+    G4double mass   = particle_definition_->GetPDGMass();
+    G4double energy = kinetic_energy + mass;
+    G4double pmod = std::sqrt(energy*energy - mass*mass);
+    px = pmod * _momentum_direction.x();
+    py = pmod * _momentum_direction.y();
+    pz = pmod * _momentum_direction.z();
+
+    // If user provides a momentum direction, this one is used
+    if (momentum_X_ != 0. || momentum_Y_ != 0. || momentum_Z_ != 0.) {
+      // Normalize if needed
+      G4double mom_mod = std::sqrt(momentum_X_ * momentum_X_ +
+                                   momentum_Y_ * momentum_Y_ +
+                                   momentum_Z_ * momentum_Z_);
+      px = pmod * momentum_X_/mom_mod;
+      py = pmod * momentum_Y_/mom_mod;
+      pz = pmod * momentum_Z_/mom_mod;
+    }else if (costheta_min_ != -1. || costheta_max_ != 1. || phi_min_ != 0. || phi_max_ !=2.*pi) {
+      G4ThreeVector p = nexus::Direction(costheta_min_, costheta_max_, phi_min_, phi_max_);
+      px = p.x() * pmod;
+      py = p.y() * pmod;
+      pz = p.z() * pmod;
+    }
+  } while (!filter_->Accept(kinetic_energy, position, G4ThreeVector(px, py, pz)));
 
   // Particle generated at start-of-event
   G4double time = 0.;
@@ -115,36 +157,6 @@ void SingleParticleGenerator::GeneratePrimaryVertex(G4Event* event)
   // Create a new vertex
   G4PrimaryVertex* vertex = new G4PrimaryVertex(position, time);
 
-  // Generate uniform random energy in [E_min, E_max]
-  G4double kinetic_energy = nexus::RandomEnergy(energy_max_,energy_min_); //////////////////////changes here
-
-  // Generate random direction by default
-  G4ThreeVector _momentum_direction = G4RandomDirection();
-
-    // Calculate cartesian components of momentum
-  G4double mass   = particle_definition_->GetPDGMass();
-  G4double energy = kinetic_energy + mass;
-  G4double pmod = std::sqrt(energy*energy - mass*mass);
-  G4double px = pmod * _momentum_direction.x();
-  G4double py = pmod * _momentum_direction.y();
-  G4double pz = pmod * _momentum_direction.z();
-
-  // If user provides a momentum direction, this one is used
-  if (momentum_X_ != 0. || momentum_Y_ != 0. || momentum_Z_ != 0.) {
-    // Normalize if needed
-    G4double mom_mod = std::sqrt(momentum_X_ * momentum_X_ +
-				 momentum_Y_ * momentum_Y_ +
-				 momentum_Z_ * momentum_Z_);
-    px = pmod * momentum_X_/mom_mod;
-    py = pmod * momentum_Y_/mom_mod;
-    pz = pmod * momentum_Z_/mom_mod;
-  }else if (costheta_min_ != -1. || costheta_max_ != 1. || phi_min_ != 0. || phi_max_ !=2.*pi) {
-    G4ThreeVector p = nexus::Direction(costheta_min_, costheta_max_, phi_min_, phi_max_);
-    px = p.x() * pmod;
-    py = p.y() * pmod;
-    pz = p.z() * pmod;
-  }
-
   // Create the new primary particle and set it some properties
   G4PrimaryParticle* particle =
     new G4PrimaryParticle(particle_definition_, px, py, pz);
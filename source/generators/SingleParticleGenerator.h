@@ -24,6 +24,7 @@ class G4ParticleDefinition;
 namespace nexus {
 
   class BaseGeometry;
+  class GeneratorFilter;
 
   class SingleParticleGenerator: public G4VPrimaryGenerator
   {
@@ -67,6 +68,7 @@ namespace nexus {
     G4double phi_min_;
     G4double phi_max_;
 
+    GeneratorFilter* filter_; ///< Selection of the generated particles
 
   };
 
@@ -10,7 +10,9 @@
 
 #include <cfloat>
 #include <complex>
+#include <algorithm>
 #include "decay0.h"
+#include "AliasSampler.h"
 #include <G4RandomDirection.hh>
 #include <Randomize.hh>
 
@@ -46,6 +48,9 @@ modebbOld_(0)
   ebb1_ = 0.;
   ebb2_ = 4.3; // original code, line 628
   gwk_=0;
+  engine_ = G4Random::getTheEngine();
+  e1Sampler_ = 0;
+  tabulated_ = true;
   fillInfo();
 }
 decay0::decay0(const std::string nuclide, int finalStateNumber,
@@ -60,6 +65,9 @@ modebbOld_(decayModeNumber)
   ebb1_ = eRangeLow;
   ebb2_ = eRangeHigh; // for mode 4, 2nbbdecay.
   gwk_=0;
+  engine_ = G4Random::getTheEngine();
+  e1Sampler_ = 0;
+  tabulated_ = true;
   // Screwy stuff: The original author reorganized his decay mode table:
   // line 617
   if (decayModeNumber == 6) modebb_ = 14;
@@ -69,6 +77,7 @@ modebbOld_(decayModeNumber)
   fillInfo();
 }
 decay0::~decay0() {
+  delete e1Sampler_;
   if (gwk_ == 0) return;
   gsl_integration_workspace_free (gwk_);
 }
@@ -381,9 +390,151 @@ void decay0::initSpectrum() {
 	   }
 	   toallevents_ = r1/r2;
      }
+     this->initTables();
      std::cout << " .... starting the generation " << std::endl;
 }
 //
+// Tabulation of the spectra, so that each event samples the energies
+// directly instead of by acceptance/rejection, which for the second
+// e-/e+ required evaluating its spectrum in every 1 keV bin to find
+// the maximum. The first energy is distributed exactly as in the
+// original code, and the second one up to the 1 keV binning.
+//
+double decay0::e1Low(size_t k) const {
+  const double eMin = (modebb_ == 10) ? ebb1_ : 0.;
+  return std::max(eMin, static_cast<double>(k+1)/1000.);
+}
+double decay0::e1High(size_t k) const {
+  return std::min(ebb2_, static_cast<double>(k+2)/1000.);
+}
+void decay0::initTables() {
+  // Bin k of spthe1_ holds e1 in [(k+1), (k+2)) keV, sampled
+  // uniformly within the bin in the original code
+  std::vector<double> weights(spthe1_.size(), 0.);
+  for (size_t k=0; k != spthe1_.size(); k++) {
+    const double width = e1High(k) - e1Low(k);
+    if (width > 0.) weights[k] = spthe1_[k]*width;
+  }
+  delete e1Sampler_;
+  e1Sampler_ = new nexus::AliasSampler(weights);
+
+  e2RowFirst_.clear();
+  e2RowOffset_.assign(1, 0);
+  e2Cdf_.clear();
+  if ((modebb_ != 4) && (modebb_ != 5) && (modebb_ != 6) && (modebb_ != 8) &&
+      (modebb_ != 13) && (modebb_ != 14) && (modebb_ != 15) && (modebb_ != 16)) return;
+
+  std::vector<double> params(10, 0.);
+  params[0] = emass_;
+  params[1] = bbNucl_.Zdbb_;
+  params[2] = e0_;
+  // Spectrum of e2 at the centre of each bin of e1, over the bins of
+  // e2 in [re2s, re2f]. Rows without entries are left empty.
+  for (size_t k=0; k != spthe1_.size(); k++) {
+    const double e1 = 0.5*(e1Low(k) + e1High(k));
+    params[3] = e1;
+    const double re2s = std::max(0., (ebb1_ - e1));
+    const double re2f = ebb2_ - e1;
+    const size_t first = static_cast<size_t>(re2s*1000.);
+    const size_t last = (re2f > re2s) ? static_cast<size_t>(std::ceil(re2f*1000.)) : first;
+    double total = 0.;
+    std::vector<double> cdf;
+    for (size_t ke2 = first; ke2 < last; ke2++) {
+      const double lo = std::max(re2s, static_cast<double>(ke2)/1000.);
+      const double hi = std::min(re2f, static_cast<double>(ke2+1)/1000.);
+      if (hi > lo) total += std::max(0., fe2(modebb_, 0.5*(lo+hi), &params[0]))*(hi - lo);
+      cdf.push_back(total);
+    }
+    e2RowFirst_.push_back(first);
+    if (total > 0.) {
+      for (size_t i=0; i != cdf.size(); i++) e2Cdf_.push_back(cdf[i]/total);
+    }
+    e2RowOffset_.push_back(e2Cdf_.size());
+  }
+}
+bool decay0::sampleE2FromTable(size_t k, double &e2) const {
+  if (k + 1 >= e2RowOffset_.size()) return false;
+  const float *cdf = &e2Cdf_[0] + e2RowOffset_[k];
+  const size_t n = e2RowOffset_[k+1] - e2RowOffset_[k];
+  if (n == 0) return false;
+  // The table is for the centre of the bin of e1: energies beyond
+  // the limits for the actual e1 are sampled again
+  const double re2s = std::max(0., (ebb1_ - e1_));
+  const double re2f = std::min(ebb2_ - e1_, e0_ - e1_);
+  for (int numThrow = 0; numThrow != 1000; numThrow++) {
+    const double u = engine_->flat();
+    size_t j = std::upper_bound(cdf, cdf + n, static_cast<float>(u)) - cdf;
+    if (j >= n) j = n - 1;
+    const double c0 = (j > 0) ? cdf[j-1] : 0.;
+    const double frac = (cdf[j] > c0) ? (u - c0)/(cdf[j] - c0) : 0.5;
+    e2 = (static_cast<double>(e2RowFirst_[k] + j) + std::min(std::max(frac, 0.), 1.))/1000.;
+    if ((e2 >= re2s) && (e2 <= re2f)) return true;
+  }
+  return false;
+}
+double decay0::fe2(size_t mode, double e2, void *p) {
+  switch(mode) {
+    case 4 :
+      return fe2_mod4(e2, p);
+    case 5 :
+      return fe2_mod5(e2, p);
+    case 6 :
+      return fe2_mod6(e2, p);
+    case 8 :
+      return fe2_mod8(e2, p);
+    case 13 :
+      return fe2_mod13(e2, p);
+    case 14 :
+      return fe2_mod14(e2, p);
+    case 15 :
+      return fe2_mod15(e2, p);
+    case 16 :
+      return fe2_mod16(e2, p);
+    default :
+      return 0.;
+  }
+}
+size_t decay0::sampleE1ByRejection() const {
+// Sampling of the energy of the first e-/e+ of the original code:
+// acceptance/rejection method (Von Neumann). Returns its bin in spthe1_.
+  int numThrow = 0;
+  while(true) {
+     if (modebb_ != 10) e1_ = ebb2_*engine_->flat();
+     else e1_ = ebb1_ + (ebb2_ - ebb1_)*engine_->flat();
+     const size_t k = static_cast<size_t>(static_cast<int>(e1_*1000.) - 1);
+     if (k >= spthe1_.size()) continue;
+     if(spmax_*engine_->flat() < spthe1_[k]) return k;
+     numThrow++;
+     if (numThrow%1000 == 0) std::cerr << " Thrwing e1 ... " << numThrow
+                                       << " times ... " << std::endl;
+  }
+}
+double decay0::sampleE2ByRejection(void *p) const {
+// Sampling of the energy of the second e-/e+ of the original code:
+// acceptance/rejection method (Von Neumann), with the maximum of the
+// spectrum searched in 1 keV steps
+	double *params = static_cast<double*>(p);
+	double e2 = 0.;
+	double re2s = std::max(0., (ebb1_ - e1_));
+	double re2f = ebb2_ - e1_;
+	double f2max = -1;
+	params[3] = e1_;
+	int ke2s = std::max(0, static_cast<int>(re2s*1000.)-1);
+	int ke2f= static_cast<int>(re2f*1000.) -1;
+	for (int ke2 = ke2s; ke2 != ke2f; ke2++) {
+	   e2 = 0.0005 + static_cast<double>(ke2)/1000.; // add 1/2 a bin...
+	   size_t kke2 = static_cast<size_t>(ke2) -1;
+	   if (kke2 >= spthe2_.size()) continue; // Should not occur often..
+	   spthe2_[kke2] = fe2(modebb_, e2, p);
+	   f2max = std::max(f2max, spthe2_[kke2]);
+	}
+	while(true) {
+	 e2 = re2s + (re2f-re2s)*engine_->flat();
+	 if ( f2max*engine_->flat() < fe2(modebb_, e2, p)) break;
+	}
+	return e2;
+}
+//
 // Subroutine GENBBsub generates the events of decay of natural
 // radioactive nuclides and various modes of double beta decay.
 // GENBB units: energy and moment - MeV and MeV/c; time - sec.
@@ -446,21 +597,16 @@ void decay0::decay0DoItbb(std::vector<decay0Part> &outPart) const {
     return;
   }
 
-// sampling the energies: first e-/e+ Acceptance/rejection method (Von Neumann), as far as I can tell.
+// sampling the energies: first e-/e+ from the tabulated spectrum, which
+// replaces the original acceptance/rejection method (Von Neumann)
   double e2=0.;
   int numThrow = 0;
-//  std::cerr << " ebb1 " << ebb1_  <<  " ebb2 " << ebb2_ << std::endl;
-  while(true) {
-     if (modebb_ != 10) e1_ = ebb2_*G4UniformRand();
-     else e1_ = ebb1_ + (ebb2_ - ebb1_)*G4UniformRand();
-//     if ((e0_ - e1_) < 0.) continue; //not needed if energy range are set properly.
-     const size_t k = static_cast<size_t>(static_cast<int>(e1_*1000.) - 1);
-     if (k >= spthe1_.size()) continue;
-     if(spmax_*G4UniformRand() < spthe1_[k]) break;
-     numThrow++;
-     if (numThrow%1000 == 0) std::cerr << " Thrwing e1 ... " << numThrow
-                                       << " times ... " << std::endl;
+  size_t k;
+  if (tabulated_) {
+    k = e1Sampler_->Index(engine_->flat());
+    e1_ = e1Low(k) + (e1High(k) - e1Low(k))*engine_->flat();
   }
+  else k = this->sampleE1ByRejection();
 //  second e-/e+ or X-ray
    if    ((modebb_ == 1) || (modebb_ == 2) || (modebb_ == 3 ) ||
           (modebb_ == 7) || (modebb_ == 17) || (modebb_==18)) {
@@ -470,69 +616,10 @@ void decay0::decay0DoItbb(std::vector<decay0Part> &outPart) const {
    } else if ((modebb_ == 4) || (modebb_ == 5) || (modebb_ == 6) ||
             (modebb_ == 8) || (modebb_ == 13) || (modebb_ == 14) ||
             (modebb_ == 15) || (modebb_ == 16))  {
-// something else is emitted - energy of second e-/e+ is random
-	double re2s = std::max(0., (ebb1_ - e1_));
-	double re2f = ebb2_ - e1_;
-	double f2max = -1;
-	params[3] = e1_;
-	int ke2s = std::max(0, static_cast<int>(re2s*1000.)-1);
-	int ke2f= static_cast<int>(re2f*1000.) -1;
-	for (int ke2 = ke2s; ke2 != ke2f; ke2++) {
-	   e2 = 0.0005 + static_cast<double>(ke2)/1000.; // add 1/2 a bin...
-	   size_t kke2 = static_cast<size_t>(ke2) -1;
-	   if (kke2 >= spthe2_.size()) continue; // Should not occur often..
-	   switch(modebb_) {
-	   case 4 :
-	      spthe2_[kke2] = fe2_mod4(e2, p); break;
-	   case 5 :
-	      spthe2_[kke2] = fe2_mod5(e2, p); break;
-	   case 6 :
-	      spthe2_[kke2] = fe2_mod6(e2, p); break;
-	   case  8 :
-	       spthe2_[kke2] = fe2_mod8(e2, p); break;
-	   case 13 :
-	       spthe2_[kke2] = fe2_mod13(e2, p); break;
-	   case 14 :
-	     spthe2_[kke2] = fe2_mod14(e2, p); break;
-	   case 15 :
-	     spthe2_[kke2] = fe2_mod15(e2, p); break;
-	   case 16 :
-	     spthe2_[kke2] = fe2_mod16(e2, p); break;
-	   default:
-	     spthe2_[kke2] = 0.;
-	   }
-	   f2max = std::max(f2max, spthe2_[kke2]);
-	}
-//	std::cerr << " real f2max= "  << f2max << std::endl;
-
-// c2	   e2=(e0-e1)*rnd1(d)
-// sampling the energies: second e-/e+ Acceptance/rejection method (Von Neumann), again
-//
-        while(true) {
-	 e2 = re2s + (re2f-re2s)*G4UniformRand();
-	 double fe2=0.;
-	 switch(modebb_) {
-	   case 4 :
-	     fe2 = fe2_mod4(e2, p); break;
-	   case 5 :
-	     fe2 = fe2_mod5(e2, p); break;
-	   case 6 :
-	     fe2 = fe2_mod6(e2, p); break;
-	   case 8 :
-	     fe2 = fe2_mod8(e2, p); break;
-	   case 13 :
-	     fe2 = fe2_mod13(e2, p); break;
-	   case 14 :
-	     fe2 = fe2_mod14(e2, p); break;
-	   case 15 :
-	     fe2 = fe2_mod15(e2, p); break;
-	   case 16 :
-	     fe2 = fe2_mod16(e2, p); break;
-	   default :
-	     fe2 = 0.; break;
-	 }
-	 if ( f2max*G4UniformRand() < fe2) break;
-        }
+// something else is emitted - energy of second e-/e+ is random,
+// from the table of the bin of e1 when it has entries
+        if (!tabulated_ || !this->sampleE2FromTable(k, e2))
+          e2 = this->sampleE2ByRejection(p);
       } else if( modebb_ == 10) {
 // energy of X-ray is fixed; no angular correlation
            this->timedParticle(outPart, 2, e1_, e1_, 0., M_PI, 0., twopi, 0., 0.);
@@ -605,14 +692,14 @@ void decay0::decay0DoItbb(std::vector<decay0Part> &outPart) const {
       double ctet2 = 1.0; double stet2 = 0.0;
       numThrow = 0;
       while(true) {
-	  phi1 = twopi * G4UniformRand();
-	  ctet1 = 1. - 2.* G4UniformRand();
+	  phi1 = twopi * engine_->flat();
+	  ctet1 = 1. - 2.* engine_->flat();
 	  stet1 = std::sqrt(1. - ctet1*ctet1);
-	  phi2= twopi * G4UniformRand();
-	  ctet2 = 1. - 2.*G4UniformRand();
+	  phi2= twopi * engine_->flat();
+	  ctet2 = 1. - 2.*engine_->flat();
 	  stet2=std::sqrt(1. - ctet2*ctet2);
 	  const double ctet = ctet1*ctet2 + stet1*stet2*std::cos(phi1-phi2);
-	  if((romaxt*G4UniformRand()) < (a + b*ctet + c*ctet*ctet)) break;
+	  if((romaxt*engine_->flat()) < (a + b*ctet + c*ctet*ctet)) break;
 	  numThrow++;
 	  if (numThrow%10000 == 0) {
 	     std::cerr << " Angular distribution Von Neumann accp/rej numThrow " << numThrow << std::endl;
@@ -679,7 +766,7 @@ void decay0::Ba136low(std::vector<decay0Part> &outPart) const {   // Baryum 136
 	this->nucltransK(outPart, 0.819,0.037,2.9e-3,0.,tclev,thlev) ;
 	break;
      case 2223:
-        p = 100.0*G4UniformRand();
+        p = 100.0*engine_->flat();
 	if (p <= 4.3) {
 	  this->nucltransK(outPart, 2.223,0.037,7.8e-4,4.0e-4,tclev,thlev) ;
 	  return;
@@ -690,7 +777,7 @@ void decay0::Ba136low(std::vector<decay0Part> &outPart) const {   // Baryum 136
 	} else {
 	  this->nucltransK(outPart, 0.672,0.037,6.5e-3,0.,tclev,thlev) ;
 	  thlev=1.01e-12;
-	  p = 100.0*G4UniformRand();
+	  p = 100.0*engine_->flat();
 	  if (p < 52.1) this->nucltransK(outPart, 1.551,0.037,8.4e-4,9.7e-5,tclev,thlev) ;
 	  else nucltransK(outPart, 0.733,0.037,4.5e-3,0.,tclev,thlev) ;
 	}
@@ -702,7 +789,7 @@ void decay0::Ba136low(std::vector<decay0Part> &outPart) const {   // Baryum 136
 	break;
      case 2129:
        thlev=0.051e-12;
-       p = 100.0*G4UniformRand();
+       p = 100.0*engine_->flat();
        if (p < 33.3) this->nucltransK(outPart, 2.129,0.037,7.7e-4,3.6e-4,tclev,thlev) ;
        else {
           this->nucltransK(outPart, 1.310,0.037,1.4e-3,2.3e-5,tclev,thlev) ;
@@ -712,7 +799,7 @@ void decay0::Ba136low(std::vector<decay0Part> &outPart) const {   // Baryum 136
        break;
      case 2080:
         thlev=0.6e-12;
-        p = 100.0*G4UniformRand();
+        p = 100.0*engine_->flat();
         if (p < 35.4) {
 	  this->nucltransK(outPart, 2.080,0.037,7.6e-4,3.3e-4,tclev,thlev) ;
 	  return;
@@ -723,7 +810,7 @@ void decay0::Ba136low(std::vector<decay0Part> &outPart) const {   // Baryum 136
 	} else {
 	  this->nucltransK(outPart, 0.529,0.037,1.0e-2,0.,tclev,thlev) ;
 	   thlev=1.01e-12;
-           p = 100.0*G4UniformRand();
+           p = 100.0*engine_->flat();
 	   if(p < 52.1) {
 	    this->nucltransK(outPart, 1.551,0.037,8.4e-4,9.7e-5,tclev,thlev) ;
 	    return;
@@ -740,7 +827,7 @@ void decay0::Ba136low(std::vector<decay0Part> &outPart) const {   // Baryum 136
 	 break;
      case 1551:
  	  thlev=1.01e-12;
-          p = 100.0*G4UniformRand();
+          p = 100.0*engine_->flat();
 	   if(p < 52.1) {
 	    this->nucltransK(outPart, 1.551,0.037,8.4e-4,9.7e-5,tclev,thlev) ;
 	    return;
@@ -784,7 +871,7 @@ void decay0::nucltransK(std::vector<decay0Part> &outPart, const double Egamma,
 //		  emitted (sec);
 //	 thlev  - level halflife (sec).
 
-   const double p=(1.+ conve + convp)*G4UniformRand();
+   const double p=(1.+ conve + convp)*engine_->flat();
    if (p < 1.) this->outGamma(outPart, Egamma,tclev,thlev);
    else if (p < (1.+conve) ) {
      this->outElectron(outPart, Egamma-Ebinde, tclev, thlev);
@@ -820,8 +907,8 @@ void decay0::outPair(std::vector<decay0Part> &outPart, const double ePair,
 // 	  tclev - time of creation of level from which pair will be
 //		  emitted (sec);
 //
-     const double phi =2.*M_PI*G4UniformRand();
-     const double ctet = -1.+ 2.*G4UniformRand();
+     const double phi =2.*M_PI*engine_->flat();
+     const double ctet = -1.+ 2.*engine_->flat();
      const double teta=std::acos(ctet);
      const double e=0.5*ePair;
      this->timedParticle(outPart, 2,e,e,teta,teta,phi,phi,tclev, thlev);
@@ -861,19 +948,19 @@ double decay0::timedParticle (std::vector<decay0Part> &outPart, int np,
        std::cerr << " decay0::timedParticle Unrecognized particle, nothing stored.. " << std::endl;
        return 0.;
    }
-   const double phi = phi1 + (phi2 - phi1)*G4UniformRand();
+   const double phi = phi1 + (phi2 - phi1)*engine_->flat();
    const double ctet1 = std::cos(teta1);
    const double ctet2 = std::cos(teta2);
-   const double ctet =  ctet1 + (ctet2 - ctet1)*G4UniformRand();
+   const double ctet =  ctet1 + (ctet2 - ctet1)*engine_->flat();
    const double stet = std::sqrt(1.0 - ctet*ctet);
    aP.energy_ = E1;
-   if (std::abs(E2 - E1) > 1.0e-10) aP.energy_ = E1 + (E2-E1)*G4UniformRand();
+   if (std::abs(E2 - E1) > 1.0e-10) aP.energy_ = E1 + (E2-E1)*engine_->flat();
    const double p = std::sqrt(aP.energy_ * (aP.energy_ + 2.*pMass));
    aP.pmom_[0] = p*stet*std::cos(phi);
    aP.pmom_[1] = p*stet*std::sin(phi);
    aP.pmom_[2] = p*ctet;
    double t = tclev;
-   if (thlev > 1.0e-100) t = tclev - thlev/std::log(2.0) * std::log(G4UniformRand());
+   if (thlev > 1.0e-100) t = tclev - thlev/std::log(2.0) * std::log(engine_->flat());
    aP.time_ = t;
    outPart.push_back(aP);
    return t;
@@ -16,6 +16,9 @@
 #include <string>
 #include <gsl/gsl_integration.h>
 
+namespace CLHEP { class HepRandomEngine; }
+namespace nexus { class AliasSampler; }
+
 struct decay0Part {
   int pdgCode_;
   double pmom_[3];
@@ -59,6 +62,12 @@ class decay0 {
     void decay0DoIt(std::vector<decay0Part> &outPart) const ;
     void fillInfo(); // to be used if the Nuclide, final state or decay mode is changed...Not advised..
      void printDecayModeList(); // For reference
+    // Engine used for all the random numbers of the decays, not owned.
+    // By default, the Geant4 engine of the thread creating the object.
+    void SetRandomEngine(CLHEP::HepRandomEngine* engine) { engine_ = engine; }
+    // Sample the energies of the e-/e+ from the tabulated spectra (default)
+    // or by acceptance/rejection, as the original code, for reference.
+    void SetTabulatedSampling(bool tabulated) { tabulated_ = tabulated; }
 
 
   private:
@@ -82,6 +91,18 @@ class decay0 {
 //                               (for modes 4,5,6,8,10 and 13).
     int mode_; //  in common/denrange/
     gsl_integration_workspace *gwk_;  // For integration..
+    CLHEP::HepRandomEngine *engine_; // Random numbers
+    //
+    // Spectra tabulated at initialization, replacing the acceptance/rejection
+    // sampling of the original code: alias table of the spectrum of the first
+    // e-/e+ (spthe1_ over its 1 keV bins), and for the modes where the energy
+    // of the second e-/e+ is random, cumulative distribution of that energy
+    // in 1 keV bins for each 1 keV bin of the first one.
+    nexus::AliasSampler *e1Sampler_;
+    std::vector<size_t> e2RowFirst_;  // First e2 bin of each row
+    std::vector<size_t> e2RowOffset_; // Start of each row in e2Cdf_
+    std::vector<float> e2Cdf_;
+    bool tabulated_; // Sample from the tables?
 //    eta_nme  .. not supported yet...
     //
     // Internal variable, volatile all declared mutable. Filled and used in DoIt (subroutine bb in decay 0)
@@ -93,6 +114,13 @@ class decay0 {
     mutable std::vector<double> spthe2_;
 
     void initSpectrum(); // Called from fillInfo, initialize array for matrix element, kinematics and so forth.
+    void initTables(); // Called from initSpectrum, tabulate the spectra for sampling.
+    double e1Low(size_t k) const; // Range of the first e-/e+ energy in bin k of spthe1_
+    double e1High(size_t k) const;
+    size_t sampleE1ByRejection() const; // First e-/e+ energy, as in the original code
+    bool sampleE2FromTable(size_t k, double &e2) const; // Second e-/e+ energy from the table
+    double sampleE2ByRejection(void *p) const; // Second e-/e+ energy, as in the original code
+    static double fe2(size_t mode, double e2, void *p); // Spectrum of the second e-/e+
     void decay0DoItbb(std::vector<decay0Part> &outPart) const; // Main method, generate the two electrons.
     void Ba136low(std::vector<decay0Part> &outPart) const;  // Baryum 136 de-excitation.
 //    void Xe130low(std::vector<decay0Part> &outPart) const;  // Xenon de-excitation. // we (NEXT) don't care...
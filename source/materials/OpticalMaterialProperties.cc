@@ -540,6 +540,8 @@ G4MaterialPropertiesTable* OpticalMaterialProperties::GAr(G4double sc_yield,
   mpt->AddConstProperty("YIELDRATIO",         .52);
   mpt->AddConstProperty("RESOLUTIONSCALE",    1.0);
   mpt->AddConstProperty("ATTACHMENT",         e_lifetime);
+  mpt->AddConstProperty("IONIZATIONENERGY",   26.4 * eV);
+  mpt->AddConstProperty("FANOFACTOR",         .2);
 
   return mpt;
 }
@@ -602,6 +604,8 @@ G4MaterialPropertiesTable* OpticalMaterialProperties::GXe(G4double pressure,
   mpt->AddConstProperty("SLOWTIMECONSTANT",   100. * ns);
   mpt->AddConstProperty("YIELDRATIO",         .1);
   mpt->AddConstProperty("ATTACHMENT",         e_lifetime);
+  mpt->AddConstProperty("IONIZATIONENERGY",   22.4 * eV);
+  mpt->AddConstProperty("FANOFACTOR",         .15);
 
   return mpt;
 }
@@ -632,6 +636,8 @@ G4MaterialPropertiesTable* OpticalMaterialProperties::FakeGrid(G4double pressure
   mpt->AddConstProperty("SLOWTIMECONSTANT",   xenon_pt->GetConstProperty("SLOWTIMECONSTANT"));
   mpt->AddConstProperty("YIELDRATIO",         xenon_pt->GetConstProperty("YIELDRATIO"));
   mpt->AddConstProperty("ATTACHMENT",         xenon_pt->GetConstProperty("ATTACHMENT"));
+  mpt->AddConstProperty("IONIZATIONENERGY",   xenon_pt->GetConstProperty("IONIZATIONENERGY"));
+  mpt->AddConstProperty("FANOFACTOR",         xenon_pt->GetConstProperty("FANOFACTOR"));
 
   // ABSORPTION LENGTH
   G4double abs_length   = -thickness/log(transparency);
@@ -0,0 +1,112 @@
+// ----------------------------------------------------------------------------
+// nexus | AsyncEventWriter.cc
+//
+// This class writes event records to file from a dedicated thread,
+// so that the output of one event is written while the next one is
+// being simulated. Records are handed over through a bounded queue:
+// the simulation blocks when the queue is full.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#include "AsyncEventWriter.h"
+
+#include "EventRecord.h"
+#include "HDF5Writer.h"
+
+using namespace nexus;
+
+
+AsyncEventWriter::AsyncEventWriter(HDF5Writer* writer, size_t capacity):
+  writer_(writer), capacity_(capacity), busy_(false), stop_(false),
+  file_size_(0)
+{
+  thread_ = std::thread(&AsyncEventWriter::Run, this);
+}
+
+
+
+AsyncEventWriter::~AsyncEventWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  not_empty_.notify_all();
+
+  // The thread empties the queue before finishing
+  thread_.join();
+
+  for (size_t i=0; i<records_.size(); ++i)
+    delete records_[i];
+}
+
+
+
+void AsyncEventWriter::Push(EventRecord& record)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  not_full_.wait(lock, [this]{ return queue_.size() < capacity_; });
+
+  EventRecord* slot = nullptr;
+  if (pool_.empty()) {
+    slot = new EventRecord();
+    records_.push_back(slot);
+  } else {
+    slot = pool_.back();
+    pool_.pop_back();
+  }
+
+  // The caller gets back the (empty) buffers of a written record
+  slot->Swap(record);
+
+  queue_.push_back(slot);
+  lock.unlock();
+  not_empty_.notify_one();
+}
+
+
+
+void AsyncEventWriter::Drain()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this]{ return queue_.empty() && !busy_; });
+}
+
+
+
+unsigned long long AsyncEventWriter::GetFileSize() const
+{
+  return file_size_;
+}
+
+
+
+void AsyncEventWriter::Run()
+{
+  while (true) {
+
+    EventRecord* record = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      not_empty_.wait(lock, [this]{ return !queue_.empty() || stop_; });
+      if (queue_.empty()) break;
+
+      record = queue_.front();
+      queue_.pop_front();
+      busy_ = true;
+    }
+    not_full_.notify_one();
+
+    record->Write(writer_);
+    record->Clear();
+    file_size_ = writer_->GetFileSize();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pool_.push_back(record);
+      busy_ = false;
+    }
+    idle_.notify_all();
+  }
+}
@@ -0,0 +1,73 @@
+// ----------------------------------------------------------------------------
+// nexus | AsyncEventWriter.h
+//
+// This class writes event records to file from a dedicated thread,
+// so that the output of one event is written while the next one is
+// being simulated. Records are handed over through a bounded queue:
+// the simulation blocks when the queue is full.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#ifndef ASYNC_EVENT_WRITER_H
+#define ASYNC_EVENT_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace nexus {
+
+  class HDF5Writer;
+  class EventRecord;
+
+  class AsyncEventWriter
+  {
+  public:
+    /// Constructor. Starts the writer thread.
+    AsyncEventWriter(HDF5Writer* writer, size_t capacity);
+    /// Destructor. Writes all pending records and stops the thread.
+    ~AsyncEventWriter();
+
+    /// Hand over the content of a record to the writer thread, leaving
+    /// the record empty. Blocks while the queue is full.
+    void Push(EventRecord& record);
+
+    /// Block until all the queued records have been written
+    void Drain();
+
+    /// Size of the file after writing the last record
+    unsigned long long GetFileSize() const;
+
+  private:
+    /// Main loop of the writer thread
+    void Run();
+
+  private:
+    HDF5Writer* writer_; ///< Writer used by the thread
+    size_t capacity_;    ///< Maximum number of queued records
+
+    std::deque<EventRecord*>  queue_; ///< Records waiting to be written
+    std::vector<EventRecord*> pool_;  ///< Written records, ready to be reused
+    std::vector<EventRecord*> records_; ///< All the records allocated
+
+    bool busy_; ///< Is the thread writing a record?
+    bool stop_; ///< Should the thread finish?
+
+    std::atomic<unsigned long long> file_size_; ///< Updated by the thread
+
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::condition_variable idle_;
+
+    std::thread thread_;
+  };
+
+} // namespace nexus
+
+#endif
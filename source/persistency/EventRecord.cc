@@ -0,0 +1,263 @@
+// ----------------------------------------------------------------------------
+// nexus | EventRecord.cc
+//
+// Compact in-memory copy of all the output of one event. It is filled
+// by the persistency manager and later written to file by the HDF5Writer,
+// possibly from a different thread.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#include "EventRecord.h"
+
+#include "HDF5Writer.h"
+
+#include <cstring>
+#include <utility>
+
+using namespace nexus;
+
+
+EventRecord::EventRecord(): evt_number_(0), weight_(1.), end_event_(false), last_string_(0)
+{
+}
+
+
+
+EventRecord::~EventRecord()
+{
+}
+
+
+
+void EventRecord::AddSensorDataInfo(int evt_number, unsigned int sensor_id,
+                                    unsigned int time_bin, unsigned int charge)
+{
+  SensorData data;
+  data.evt_number = evt_number;
+  data.sensor_id  = sensor_id;
+  data.time_bin   = time_bin;
+  data.charge     = charge;
+  sns_data_.push_back(data);
+}
+
+
+
+void EventRecord::AddHitInfo(int evt_number, int particle_indx, int hit_indx,
+                             float hit_position_x, float hit_position_y,
+                             float hit_position_z, float hit_time,
+                             float hit_energy, const char* label)
+{
+  Hit hit;
+  hit.evt_number    = evt_number;
+  hit.particle_indx = particle_indx;
+  hit.hit_indx      = hit_indx;
+  hit.x      = hit_position_x;
+  hit.y      = hit_position_y;
+  hit.z      = hit_position_z;
+  hit.time   = hit_time;
+  hit.energy = hit_energy;
+  hit.label  = AddString(label);
+  hits_.push_back(hit);
+}
+
+
+
+void EventRecord::AddParticleInfo(int evt_number, int particle_indx,
+                                  const char* particle_name,
+                                  char primary, int mother_id,
+                                  float initial_vertex_x, float initial_vertex_y,
+                                  float initial_vertex_z, float initial_vertex_t,
+                                  float final_vertex_x, float final_vertex_y,
+                                  float final_vertex_z, float final_vertex_t,
+                                  const char* initial_volume, const char* final_volume,
+                                  float ini_momentum_x, float ini_momentum_y,
+                                  float ini_momentum_z, float final_momentum_x,
+                                  float final_momentum_y, float final_momentum_z,
+                                  float kin_energy, float length,
+                                  const char* creator_proc, const char* final_proc)
+{
+  Particle p;
+  p.evt_number    = evt_number;
+  p.particle_indx = particle_indx;
+  p.mother_id     = mother_id;
+  p.primary       = primary;
+  p.ini_x = initial_vertex_x;
+  p.ini_y = initial_vertex_y;
+  p.ini_z = initial_vertex_z;
+  p.ini_t = initial_vertex_t;
+  p.fin_x = final_vertex_x;
+  p.fin_y = final_vertex_y;
+  p.fin_z = final_vertex_z;
+  p.fin_t = final_vertex_t;
+  p.ini_px = ini_momentum_x;
+  p.ini_py = ini_momentum_y;
+  p.ini_pz = ini_momentum_z;
+  p.fin_px = final_momentum_x;
+  p.fin_py = final_momentum_y;
+  p.fin_pz = final_momentum_z;
+  p.kin_energy = kin_energy;
+  p.length     = length;
+  p.particle_name  = AddString(particle_name);
+  p.initial_volume = AddString(initial_volume);
+  p.final_volume   = AddString(final_volume);
+  p.creator_proc   = AddString(creator_proc);
+  p.final_proc     = AddString(final_proc);
+  particles_.push_back(p);
+}
+
+
+
+void EventRecord::AddSensorPosInfo(unsigned int sensor_id, const char* sensor_name,
+                                   float x, float y, float z)
+{
+  SensorPos pos;
+  pos.sensor_id   = sensor_id;
+  pos.sensor_name = AddString(sensor_name);
+  pos.x = x;
+  pos.y = y;
+  pos.z = z;
+  sns_pos_.push_back(pos);
+}
+
+
+
+void EventRecord::AddStep(int evt_number,
+                          int particle_id, const char* particle_name,
+                          int step_id,
+                          const char* initial_volume,
+                          const char*   final_volume,
+                          const char*      proc_name,
+                          float initial_x, float initial_y, float initial_z,
+                          float   final_x, float   final_y, float   final_z)
+{
+  Step step;
+  step.evt_number  = evt_number;
+  step.particle_id = particle_id;
+  step.step_id     = step_id;
+  step.particle_name  = AddString(particle_name);
+  step.initial_volume = AddString(initial_volume);
+  step.  final_volume = AddString(  final_volume);
+  step.     proc_name = AddString(     proc_name);
+  step.ini_x = initial_x;
+  step.ini_y = initial_y;
+  step.ini_z = initial_z;
+  step.fin_x =   final_x;
+  step.fin_y =   final_y;
+  step.fin_z =   final_z;
+  steps_.push_back(step);
+}
+
+
+
+void EventRecord::EndEvent(int evt_number, double weight)
+{
+  evt_number_ = evt_number;
+  weight_     = weight;
+  end_event_  = true;
+}
+
+
+
+void EventRecord::Write(HDF5Writer* writer) const
+{
+  for (size_t i=0; i<steps_.size(); ++i) {
+    const Step& s = steps_[i];
+    writer->WriteStep(s.evt_number, s.particle_id, GetString(s.particle_name),
+                      s.step_id,
+                      GetString(s.initial_volume),
+                      GetString(s.final_volume),
+                      GetString(s.proc_name),
+                      s.ini_x, s.ini_y, s.ini_z,
+                      s.fin_x, s.fin_y, s.fin_z);
+  }
+
+  for (size_t i=0; i<particles_.size(); ++i) {
+    const Particle& p = particles_[i];
+    writer->WriteParticleInfo(p.evt_number, p.particle_indx,
+                              GetString(p.particle_name),
+                              p.primary, p.mother_id,
+                              p.ini_x, p.ini_y, p.ini_z, p.ini_t,
+                              p.fin_x, p.fin_y, p.fin_z, p.fin_t,
+                              GetString(p.initial_volume),
+                              GetString(p.final_volume),
+                              p.ini_px, p.ini_py, p.ini_pz,
+                              p.fin_px, p.fin_py, p.fin_pz,
+                              p.kin_energy, p.length,
+                              GetString(p.creator_proc),
+                              GetString(p.final_proc));
+  }
+
+  for (size_t i=0; i<hits_.size(); ++i) {
+    const Hit& h = hits_[i];
+    writer->WriteHitInfo(h.evt_number, h.particle_indx, h.hit_indx,
+                         h.x, h.y, h.z, h.time, h.energy,
+                         GetString(h.label));
+  }
+
+  for (size_t i=0; i<sns_data_.size(); ++i) {
+    const SensorData& d = sns_data_[i];
+    writer->WriteSensorDataInfo(d.evt_number, d.sensor_id,
+                                d.time_bin, d.charge);
+  }
+
+  for (size_t i=0; i<sns_pos_.size(); ++i) {
+    const SensorPos& p = sns_pos_[i];
+    writer->WriteSensorPosInfo(p.sensor_id, GetString(p.sensor_name),
+                               p.x, p.y, p.z);
+  }
+
+  if (end_event_)
+    writer->WriteEventIndex(evt_number_, weight_);
+}
+
+
+
+void EventRecord::Clear()
+{
+  sns_data_.clear();
+  hits_.clear();
+  particles_.clear();
+  sns_pos_.clear();
+  steps_.clear();
+  strings_.clear();
+  last_string_ = 0;
+  end_event_ = false;
+}
+
+
+
+void EventRecord::Swap(EventRecord& other)
+{
+  sns_data_.swap(other.sns_data_);
+  hits_.swap(other.hits_);
+  particles_.swap(other.particles_);
+  sns_pos_.swap(other.sns_pos_);
+  steps_.swap(other.steps_);
+  strings_.swap(other.strings_);
+  std::swap(last_string_, other.last_string_);
+  std::swap(evt_number_, other.evt_number_);
+  std::swap(weight_, other.weight_);
+  std::swap(end_event_, other.end_event_);
+}
+
+
+
+size_t EventRecord::AddString(const char* str)
+{
+  // Consecutive rows often repeat the same string (e.g., the label
+  // of all the hits of a collection), so it is stored only once
+  if (!strings_.empty() && strcmp(&strings_[last_string_], str) == 0)
+    return last_string_;
+
+  last_string_ = strings_.size();
+  strings_.insert(strings_.end(), str, str + strlen(str) + 1);
+  return last_string_;
+}
+
+
+
+const char* EventRecord::GetString(size_t offset) const
+{
+  return &strings_[offset];
+}
@@ -0,0 +1,128 @@
+// ----------------------------------------------------------------------------
+// nexus | EventRecord.h
+//
+// Compact in-memory copy of all the output of one event. It is filled
+// by the persistency manager and later written to file by the HDF5Writer,
+// possibly from a different thread.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#ifndef EVENT_RECORD_H
+#define EVENT_RECORD_H
+
+#include <vector>
+#include <cstddef>
+
+
+namespace nexus {
+
+  class HDF5Writer;
+
+  class EventRecord
+  {
+  public:
+    /// Constructor
+    EventRecord();
+    /// Destructor
+    ~EventRecord();
+
+    void AddSensorDataInfo(int evt_number, unsigned int sensor_id,
+                           unsigned int time_bin, unsigned int charge);
+    void AddHitInfo(int evt_number, int particle_indx, int hit_indx,
+                    float hit_position_x, float hit_position_y, float hit_position_z,
+                    float hit_time, float hit_energy, const char* label);
+    void AddParticleInfo(int evt_number, int particle_indx, const char* particle_name,
+                         char primary, int mother_id,
+                         float initial_vertex_x, float initial_vertex_y,
+                         float initial_vertex_z, float initial_vertex_t,
+                         float final_vertex_x, float final_vertex_y,
+                         float final_vertex_z, float final_vertex_t,
+                         const char* initial_volume, const char* final_volume,
+                         float ini_momentum_x, float ini_momentum_y, float ini_momentum_z,
+                         float final_momentum_x, float final_momentum_y, float final_momentum_z,
+                         float kin_energy, float length,
+                         const char* creator_proc, const char* final_proc);
+    void AddSensorPosInfo(unsigned int sensor_id, const char* sensor_name,
+                          float x, float y, float z);
+    void AddStep(int evt_number,
+                 int particle_id, const char* particle_name,
+                 int step_id,
+                 const char* initial_volume,
+                 const char*   final_volume,
+                 const char*      proc_name,
+                 float initial_x, float initial_y, float initial_z,
+                 float   final_x, float   final_y, float   final_z);
+
+    /// Mark the record as a complete event, to be added to the
+    /// event index with its generator weight when written
+    void EndEvent(int evt_number, double weight=1.);
+
+    /// Write the content of the record with the given writer
+    void Write(HDF5Writer* writer) const;
+
+    /// Remove the content of the record, keeping the allocated memory
+    void Clear();
+
+    /// Exchange the content of two records
+    void Swap(EventRecord& other);
+
+  private:
+    /// Copy a string into the string pool and return its offset
+    size_t AddString(const char* str);
+    const char* GetString(size_t offset) const;
+
+  private:
+    struct SensorData {
+      int evt_number;
+      unsigned int sensor_id, time_bin, charge;
+    };
+
+    struct Hit {
+      int evt_number, particle_indx, hit_indx;
+      float x, y, z, time, energy;
+      size_t label;
+    };
+
+    struct Particle {
+      int evt_number, particle_indx, mother_id;
+      char primary;
+      float ini_x, ini_y, ini_z, ini_t;
+      float fin_x, fin_y, fin_z, fin_t;
+      float ini_px, ini_py, ini_pz;
+      float fin_px, fin_py, fin_pz;
+      float kin_energy, length;
+      size_t particle_name, initial_volume, final_volume;
+      size_t creator_proc, final_proc;
+    };
+
+    struct SensorPos {
+      unsigned int sensor_id;
+      size_t sensor_name;
+      float x, y, z;
+    };
+
+    struct Step {
+      int evt_number, particle_id, step_id;
+      size_t particle_name, initial_volume, final_volume, proc_name;
+      float ini_x, ini_y, ini_z;
+      float fin_x, fin_y, fin_z;
+    };
+
+    std::vector<SensorData> sns_data_;
+    std::vector<Hit>        hits_;
+    std::vector<Particle>   particles_;
+    std::vector<SensorPos>  sns_pos_;
+    std::vector<Step>       steps_;
+
+    int  evt_number_; ///< Event ID, if the record is a complete event
+    double weight_;   ///< Generator weight of the event
+    bool end_event_;  ///< Is the record a complete event?
+
+    std::vector<char> strings_; ///< Pool of null-terminated strings
+    size_t last_string_; ///< Offset of the last string added to the pool
+  };
+
+} // namespace nexus
+
+#endif
@@ -8,20 +8,23 @@
 
 #include "HDF5Writer.h"
 
+#include <G4ios.hh>
+
 #include <sstream>
 #include <cstring>
 #include <stdlib.h>
 #include <vector>
 
 #include <stdint.h>
-#include <iostream>
 
 using namespace nexus;
 
 
 HDF5Writer::HDF5Writer():
-  file_(0), irun_(0), ismp_(0), ihit_(0),
-  ipart_(0), ipos_(0), istep_(0)
+  file_(0), irun_(0), ismp_(0), iwvf_(0), ihit_(0),
+  ipart_(0), ipos_(0), istep_(0), ievt_(0), buffer_rows_(10000),
+  deflate_level_(0), shuffle_(false), filter_id_(0),
+  sparse_sns_data_(false), encode_strings_(false), verbose_(false)
 {
 }
 
@@ -39,43 +42,269 @@ void HDF5Writer::Open(std::string fileName, bool debug)
   std::string group_name = "/MC";
   size_t group = createGroup(file_, group_name);
 
+  hid_t filters = createFilters(deflate_level_, shuffle_,
+                                filter_id_, filter_values_);
+
   std::string run_table_name = "configuration";
   memtypeRun_ = createRunType();
-  runTable_ = createTable(group, run_table_name, memtypeRun_);
+  runTable_ = createTable(group, run_table_name, memtypeRun_,
+                          ChunkSize(run_table_name), filters);
 
   std::string sns_data_table_name = "sns_response";
-  memtypeSnsData_ = createSensorDataType();
-  snsDataTable_ = createTable(group, sns_data_table_name, memtypeSnsData_);
+  if (sparse_sns_data_) {
+    std::string sns_group_name = group_name + "/" + sns_data_table_name;
+    size_t sns_group = createGroup(file_, sns_group_name);
+
+    std::string sns_index_table_name = "index";
+    memtypeSnsIndex_ = createSensorIndexType();
+    snsIndexTable_ = createTable(sns_group, sns_index_table_name, memtypeSnsIndex_,
+                                 ChunkSize(sns_data_table_name), filters);
+
+    std::string sns_time_bin_table_name = "time_bin";
+    snsTimeBinTable_ = createTable(sns_group, sns_time_bin_table_name, H5T_NATIVE_UINT32,
+                                   ChunkSize(sns_data_table_name), filters);
+
+    std::string sns_charge_table_name = "charge";
+    snsChargeTable_ = createTable(sns_group, sns_charge_table_name, H5T_NATIVE_UINT32,
+                                  ChunkSize(sns_data_table_name), filters);
+
+    snsIndex_.length = 0;
+  } else {
+    memtypeSnsData_ = createSensorDataType();
+    snsDataTable_ = createTable(group, sns_data_table_name, memtypeSnsData_,
+                                ChunkSize(sns_data_table_name), filters);
+  }
 
   std::string hit_info_table_name = "hits";
-  memtypeHitInfo_ = createHitInfoType();
-  hitInfoTable_ = createTable(group, hit_info_table_name, memtypeHitInfo_);
+  memtypeHitInfo_ = encode_strings_ ? createHitInfoCodedType() : createHitInfoType();
+  hitInfoTable_ = createTable(group, hit_info_table_name, memtypeHitInfo_,
+                              ChunkSize(hit_info_table_name), filters);
 
   std::string particle_info_table_name = "particles";
-  memtypeParticleInfo_ = createParticleInfoType();
-  particleInfoTable_ = createTable(group, particle_info_table_name, memtypeParticleInfo_);
+  memtypeParticleInfo_ = encode_strings_ ? createParticleInfoCodedType()
+                                         : createParticleInfoType();
+  particleInfoTable_ = createTable(group, particle_info_table_name, memtypeParticleInfo_,
+                                   ChunkSize(particle_info_table_name), filters);
 
   std::string sns_pos_table_name = "sns_positions";
   memtypeSnsPos_ = createSensorPosType();
-  snsPosTable_ = createTable(group, sns_pos_table_name, memtypeSnsPos_);
+  snsPosTable_ = createTable(group, sns_pos_table_name, memtypeSnsPos_,
+                             ChunkSize(sns_pos_table_name), filters);
+
+  std::string event_index_table_name = "event_index";
+  memtypeEventIndex_ = createEventIndexType();
+  eventIndexTable_ = createTable(group, event_index_table_name, memtypeEventIndex_,
+                                 ChunkSize(event_index_table_name), filters);
+  eventIndex_.hits_offset         = 0;
+  eventIndex_.particles_offset    = 0;
+  eventIndex_.sns_response_offset = 0;
+  eventIndex_.steps_offset        = 0;
+
+  if (encode_strings_) {
+    std::string string_map_table_name = "string_map";
+    memtypeStringMap_ = createStringMapType();
+    stringMapTable_ = createTable(group, string_map_table_name, memtypeStringMap_,
+                                  ChunkSize(string_map_table_name), filters);
+  }
 
   if (debug) {
     std::string debug_group_name = "/DEBUG";
     size_t debug_group = createGroup(file_, debug_group_name);
     std::string step_table_name = "steps";
     memtypeStep_ = createStepType();
-    stepTable_   = createTable(debug_group, step_table_name, memtypeStep_);
+    stepTable_   = createTable(debug_group, step_table_name, memtypeStep_,
+                               ChunkSize(step_table_name), filters);
   }
 
+  H5Pclose(filters);
+
   isOpen_ = true;
 }
 
 void HDF5Writer::Close()
 {
+  Flush();
+
+  // The lookup table of the encoded strings is written once per file
+  if (encode_strings_) {
+    writeRows(stringMap_.data(), stringMap_.size(),
+              stringMapTable_, memtypeStringMap_, 0);
+  }
+
+  H5Fflush(file_, H5F_SCOPE_LOCAL);
+
+  // Report the compression achieved on the tables written
+  hsize_t raw_size = 0, stored_size = 0;
+  ReportStorage("configuration", runTable_,          memtypeRun_,          irun_,  raw_size, stored_size);
+  if (sparse_sns_data_) {
+    ReportStorage("sns_response/index",    snsIndexTable_,   memtypeSnsIndex_,  iwvf_, raw_size, stored_size);
+    ReportStorage("sns_response/time_bin", snsTimeBinTable_, H5T_NATIVE_UINT32, ismp_, raw_size, stored_size);
+    ReportStorage("sns_response/charge",   snsChargeTable_,  H5T_NATIVE_UINT32, ismp_, raw_size, stored_size);
+  } else {
+    ReportStorage("sns_response",  snsDataTable_,      memtypeSnsData_,      ismp_,  raw_size, stored_size);
+  }
+  ReportStorage("hits",          hitInfoTable_,      memtypeHitInfo_,      ihit_,  raw_size, stored_size);
+  ReportStorage("particles",     particleInfoTable_, memtypeParticleInfo_, ipart_, raw_size, stored_size);
+  ReportStorage("sns_positions", snsPosTable_,       memtypeSnsPos_,       ipos_,  raw_size, stored_size);
+  ReportStorage("string_map",    stringMapTable_,    memtypeStringMap_,    stringMap_.size(), raw_size, stored_size);
+  ReportStorage("event_index",   eventIndexTable_,   memtypeEventIndex_,   ievt_,  raw_size, stored_size);
+  ReportStorage("steps",         stepTable_,         memtypeStep_,         istep_, raw_size, stored_size);
+  if (stored_size > 0)
+    G4cout << "[HDF5Writer] Total compression ratio: "
+           << (double)raw_size / stored_size << G4endl;
+
   isOpen_=false;
   H5Fclose(file_);
 }
 
+unsigned long long HDF5Writer::GetFileSize() const
+{
+  hsize_t size = 0;
+  H5Fget_filesize(file_, &size);
+  return size;
+}
+
+void HDF5Writer::SetChunkSize(std::string table_name, size_t nrows)
+{
+  chunk_sizes_[table_name] = nrows;
+}
+
+bool HDF5Writer::IsTableName(const std::string& table_name)
+{
+  static const char* table_names[] = {"configuration", "sns_response", "hits",
+                                      "particles", "sns_positions", "event_index",
+                                      "string_map", "steps"};
+  for (size_t i=0; i<sizeof(table_names)/sizeof(table_names[0]); ++i)
+    if (table_name == table_names[i]) return true;
+  return false;
+}
+
+void HDF5Writer::SetCompression(int deflate_level, bool shuffle)
+{
+  deflate_level_ = deflate_level;
+  shuffle_       = shuffle;
+}
+
+void HDF5Writer::SetFilter(unsigned int filter_id,
+                           const std::vector<unsigned int>& filter_values)
+{
+  filter_id_     = filter_id;
+  filter_values_ = filter_values;
+}
+
+size_t HDF5Writer::ChunkSize(const std::string& table_name) const
+{
+  std::map<std::string, size_t>::const_iterator it =
+    chunk_sizes_.find(table_name);
+  return (it != chunk_sizes_.end()) ? it->second : 32768;
+}
+
+void HDF5Writer::ReportStorage(const std::string& table_name,
+                               size_t dataset, size_t memtype, size_t nrows,
+                               hsize_t& raw_size, hsize_t& stored_size) const
+{
+  if (nrows == 0) return;
+
+  hsize_t raw    = nrows * H5Tget_size(memtype);
+  hsize_t stored = H5Dget_storage_size(dataset);
+  raw_size    += raw;
+  stored_size += stored;
+
+  if (verbose_ && stored > 0)
+    G4cout << "[HDF5Writer] Compression ratio for table " << table_name
+           << ": " << (double)raw / stored << G4endl;
+}
+
+void HDF5Writer::Flush()
+{
+  Flush(snsDataBuffer_,      snsDataTable_,      memtypeSnsData_,      ismp_);
+
+  if (sparse_sns_data_) {
+    FlushSensorSamples();
+    if (snsIndex_.length > 0) {
+      snsIndexBuffer_.push_back(snsIndex_);
+      snsIndex_.length = 0;
+    }
+    Flush(snsIndexBuffer_, snsIndexTable_, memtypeSnsIndex_, iwvf_);
+  }
+  Flush(hitInfoBuffer_,      hitInfoTable_,      memtypeHitInfo_,      ihit_);
+  Flush(particleInfoBuffer_, particleInfoTable_, memtypeParticleInfo_, ipart_);
+  Flush(hitCodedBuffer_,      hitInfoTable_,      memtypeHitInfo_,      ihit_);
+  Flush(particleCodedBuffer_, particleInfoTable_, memtypeParticleInfo_, ipart_);
+  Flush(stepBuffer_,         stepTable_,         memtypeStep_,         istep_);
+  Flush(eventIndexBuffer_,   eventIndexTable_,   memtypeEventIndex_,   ievt_);
+}
+
+void HDF5Writer::SetBufferRows(size_t nrows)
+{
+  buffer_rows_ = nrows;
+}
+
+void HDF5Writer::SetSparseSensorData(bool sparse)
+{
+  sparse_sns_data_ = sparse;
+}
+
+void HDF5Writer::FlushSensorSamples()
+{
+  writeRows(snsTimeBinBuffer_.data(), snsTimeBinBuffer_.size(),
+            snsTimeBinTable_, H5T_NATIVE_UINT32, ismp_);
+  writeRows(snsChargeBuffer_.data(), snsChargeBuffer_.size(),
+            snsChargeTable_, H5T_NATIVE_UINT32, ismp_);
+  ismp_ += snsTimeBinBuffer_.size();
+  snsTimeBinBuffer_.clear();
+  snsChargeBuffer_.clear();
+}
+
+void HDF5Writer::SetEncodeStrings(bool encode)
+{
+  encode_strings_ = encode;
+}
+
+void HDF5Writer::SetVerbose(bool verbose)
+{
+  verbose_ = verbose;
+}
+
+int32_t HDF5Writer::StringCode(const char* name)
+{
+  std::unordered_map<std::string, int32_t>::const_iterator it =
+    string_codes_.find(name);
+  if (it != string_codes_.end())
+    return it->second;
+
+  int32_t code = string_codes_.size();
+  string_codes_.insert(std::make_pair(std::string(name), code));
+
+  string_map_t entry;
+  entry.code = code;
+  memset(entry.name, 0, STRLEN);
+  strncpy(entry.name, name, STRLEN-1);
+  stringMap_.push_back(entry);
+
+  return code;
+}
+
+template <typename T>
+void HDF5Writer::Buffer(std::vector<T>& buffer, const T& row,
+                        size_t dataset, size_t memtype, size_t& counter)
+{
+  buffer.push_back(row);
+  if (buffer.size() >= buffer_rows_)
+    Flush(buffer, dataset, memtype, counter);
+}
+
+template <typename T>
+void HDF5Writer::Flush(std::vector<T>& buffer,
+                       size_t dataset, size_t memtype, size_t& counter)
+{
+  if (buffer.empty()) return;
+
+  writeRows(buffer.data(), buffer.size(), dataset, memtype, counter);
+  counter += buffer.size();
+  buffer.clear();
+}
+
 void HDF5Writer::WriteRunInfo(const char* param_key, const char* param_value)
 {
   run_info_t runData;
@@ -83,7 +312,7 @@ void HDF5Writer::WriteRunInfo(const char* param_key, const char* param_value)
   memset(runData.param_value, 0, CONFLEN);
   strcpy(runData.param_key, param_key);
   strcpy(runData.param_value, param_value);
-  writeRun(&runData, runTable_, memtypeRun_, irun_);
+  writeRows(&runData, 1, runTable_, memtypeRun_, irun_);
 
   irun_++;
 }
@@ -91,18 +320,52 @@ void HDF5Writer::WriteRunInfo(const char* param_key, const char* param_value)
 
 void HDF5Writer::WriteSensorDataInfo(int evt_number, unsigned int sensor_id, unsigned int time_bin, unsigned int charge)
 {
+  if (sparse_sns_data_) {
+    // Samples of the same sensor and event arrive consecutively:
+    // start a new waveform whenever any of them changes
+    if (snsIndex_.length == 0 || snsIndex_.event_id != evt_number ||
+        snsIndex_.sensor_id != sensor_id) {
+      if (snsIndex_.length > 0)
+        Buffer(snsIndexBuffer_, snsIndex_, snsIndexTable_, memtypeSnsIndex_, iwvf_);
+      snsIndex_.event_id  = evt_number;
+      snsIndex_.sensor_id = sensor_id;
+      snsIndex_.offset    = ismp_ + snsTimeBinBuffer_.size();
+      snsIndex_.length    = 0;
+    }
+
+    snsIndex_.length++;
+    snsTimeBinBuffer_.push_back(time_bin);
+    snsChargeBuffer_.push_back(charge);
+    if (snsTimeBinBuffer_.size() >= buffer_rows_)
+      FlushSensorSamples();
+    return;
+  }
+
   sns_data_t snsData;
   snsData.event_id = evt_number;
   snsData.sensor_id = sensor_id;
   snsData.time_bin = time_bin;
   snsData.charge = charge;
-  writeSnsData(&snsData, snsDataTable_, memtypeSnsData_, ismp_);
-
-  ismp_++;
+  Buffer(snsDataBuffer_, snsData, snsDataTable_, memtypeSnsData_, ismp_);
 }
 
 void HDF5Writer::WriteHitInfo(int evt_number, int particle_indx, int hit_indx, float hit_position_x, float hit_position_y, float hit_position_z, float hit_time, float hit_energy, const char* label)
 {
+  if (encode_strings_) {
+    hit_info_coded_t codedInfo;
+    codedInfo.event_id = evt_number;
+    codedInfo.x = hit_position_x;
+    codedInfo.y = hit_position_y;
+    codedInfo.z = hit_position_z;
+    codedInfo.time = hit_time;
+    codedInfo.energy = hit_energy;
+    codedInfo.label = StringCode(label);
+    codedInfo.particle_id = particle_indx;
+    codedInfo.hit_id = hit_indx;
+    Buffer(hitCodedBuffer_, codedInfo, hitInfoTable_, memtypeHitInfo_, ihit_);
+    return;
+  }
+
   hit_info_t trueInfo;
   trueInfo.event_id = evt_number;
   trueInfo.x = hit_position_x;
@@ -114,13 +377,43 @@ void HDF5Writer::WriteHitInfo(int evt_number, int particle_indx, int hit_indx, f
   strcpy(trueInfo.label, label);
   trueInfo.particle_id = particle_indx;
   trueInfo.hit_id = hit_indx;
-  writeHit(&trueInfo,  hitInfoTable_, memtypeHitInfo_, ihit_);
-
-  ihit_++;
+  Buffer(hitInfoBuffer_, trueInfo, hitInfoTable_, memtypeHitInfo_, ihit_);
 }
 
 void HDF5Writer::WriteParticleInfo(int evt_number, int particle_indx, const char* particle_name, char primary, int mother_id, float initial_vertex_x, float initial_vertex_y, float initial_vertex_z, float initial_vertex_t, float final_vertex_x, float final_vertex_y, float final_vertex_z, float final_vertex_t, const char* initial_volume, const char* final_volume, float ini_momentum_x, float ini_momentum_y, float ini_momentum_z, float final_momentum_x, float final_momentum_y, float final_momentum_z, float kin_energy, float length, const char* creator_proc, const char* final_proc)
 {
+  if (encode_strings_) {
+    particle_info_coded_t codedInfo;
+    codedInfo.event_id = evt_number;
+    codedInfo.particle_id = particle_indx;
+    codedInfo.particle_name = StringCode(particle_name);
+    codedInfo.primary = primary;
+    codedInfo.mother_id = mother_id;
+    codedInfo.initial_x = initial_vertex_x;
+    codedInfo.initial_y = initial_vertex_y;
+    codedInfo.initial_z = initial_vertex_z;
+    codedInfo.initial_t = initial_vertex_t;
+    codedInfo.final_x = final_vertex_x;
+    codedInfo.final_y = final_vertex_y;
+    codedInfo.final_z = final_vertex_z;
+    codedInfo.final_t = final_vertex_t;
+    codedInfo.initial_volume = StringCode(initial_volume);
+    codedInfo.final_volume = StringCode(final_volume);
+    codedInfo.initial_momentum_x = ini_momentum_x;
+    codedInfo.initial_momentum_y = ini_momentum_y;
+    codedInfo.initial_momentum_z = ini_momentum_z;
+    codedInfo.final_momentum_x = final_momentum_x;
+    codedInfo.final_momentum_y = final_momentum_y;
+    codedInfo.final_momentum_z = final_momentum_z;
+    codedInfo.kin_energy = kin_energy;
+    codedInfo.length = length;
+    codedInfo.creator_proc = StringCode(creator_proc);
+    codedInfo.final_proc = StringCode(final_proc);
+    Buffer(particleCodedBuffer_, codedInfo,
+           particleInfoTable_, memtypeParticleInfo_, ipart_);
+    return;
+  }
+
   particle_info_t trueInfo;
   trueInfo.event_id = evt_number;
   trueInfo.particle_id = particle_indx;
@@ -152,9 +445,35 @@ void HDF5Writer::WriteParticleInfo(int evt_number, int particle_indx, const char
   strcpy(trueInfo.creator_proc, creator_proc);
   memset(trueInfo.final_proc, 0, STRLEN);
   strcpy(trueInfo.final_proc, final_proc);
-  writeParticle(&trueInfo,  particleInfoTable_, memtypeParticleInfo_, ipart_);
+  Buffer(particleInfoBuffer_, trueInfo,
+         particleInfoTable_, memtypeParticleInfo_, ipart_);
+}
 
-  ipart_++;
+void HDF5Writer::WriteEventIndex(int evt_number, double weight)
+{
+  // Rows of each table written so far, including the buffered ones.
+  // In the sparse layout, the sensor response rows are those of the
+  // waveform index.
+  uint64_t nhits = ihit_  + hitInfoBuffer_.size()      + hitCodedBuffer_.size();
+  uint64_t npart = ipart_ + particleInfoBuffer_.size() + particleCodedBuffer_.size();
+  uint64_t nstep = istep_ + stepBuffer_.size();
+  uint64_t nsns  = sparse_sns_data_ ?
+    iwvf_ + snsIndexBuffer_.size() + (snsIndex_.length > 0 ? 1 : 0) :
+    ismp_ + snsDataBuffer_.size();
+
+  eventIndex_.event_id            = evt_number;
+  eventIndex_.weight              = weight;
+  eventIndex_.hits_length         = nhits - eventIndex_.hits_offset;
+  eventIndex_.particles_length    = npart - eventIndex_.particles_offset;
+  eventIndex_.sns_response_length = nsns  - eventIndex_.sns_response_offset;
+  eventIndex_.steps_length        = nstep - eventIndex_.steps_offset;
+  Buffer(eventIndexBuffer_, eventIndex_, eventIndexTable_, memtypeEventIndex_, ievt_);
+
+  // The next event starts where this one ends
+  eventIndex_.hits_offset         = nhits;
+  eventIndex_.particles_offset    = npart;
+  eventIndex_.sns_response_offset = nsns;
+  eventIndex_.steps_offset        = nstep;
 }
 
 void HDF5Writer::WriteSensorPosInfo(unsigned int sensor_id, const char* sensor_name, float x, float y, float z)
@@ -166,7 +485,7 @@ void HDF5Writer::WriteSensorPosInfo(unsigned int sensor_id, const char* sensor_n
   snsPos.x = x;
   snsPos.y = y;
   snsPos.z = z;
-  writeSnsPos(&snsPos, snsPosTable_, memtypeSnsPos_, ipos_);
+  writeRows(&snsPos, 1, snsPosTable_, memtypeSnsPos_, ipos_);
 
   ipos_++;
 }
@@ -199,7 +518,5 @@ void HDF5Writer::WriteStep(int evt_number,
   step.  final_y   =   final_y;
   step.  final_z   =   final_z;
 
-  writeStep(&step, stepTable_, memtypeStep_, istep_);
-
-  istep_++;
+  Buffer(stepBuffer_, step, stepTable_, memtypeStep_, istep_);
 }
@@ -13,6 +13,9 @@
 
 #include <hdf5.h>
 #include <iostream>
+#include <map>
+#include <unordered_map>
+#include <vector>
 
 namespace nexus {
 
@@ -30,10 +33,47 @@ namespace nexus {
     /// close file
     void Close();
 
+    /// write all the buffered rows to file
+    void Flush();
+
+    /// current size of the file, not including the buffered rows
+    unsigned long long GetFileSize() const;
+
+    /// set the number of rows kept in memory per table before writing
+    void SetBufferRows(size_t nrows);
+
+    /// set the chunk size (in rows) of a table; it must be set before
+    /// the file is opened
+    void SetChunkSize(std::string table_name, size_t nrows);
+
+    /// true if the writer has a table of that name (for the sensor
+    /// response in sparse layout, the name of its group)
+    static bool IsTableName(const std::string& table_name);
+
+    /// enable the deflate (level > 0) and shuffle filters on all tables
+    void SetCompression(int deflate_level, bool shuffle);
+
+    /// write string columns of the hits and particles tables as codes
+    /// of the string_map table; it must be set before the file is opened
+    void SetEncodeStrings(bool encode);
+
+    /// write the sensor response as an index of waveforms plus flat
+    /// time_bin and charge arrays; it must be set before the file is opened
+    void SetSparseSensorData(bool sparse);
+
+    /// report the compression ratio of each table, not only the total
+    void SetVerbose(bool verbose);
+
+    /// enable a registered HDF5 filter on all tables
+    void SetFilter(unsigned int filter_id,
+                   const std::vector<unsigned int>& filter_values);
+
     void WriteRunInfo(const char* param_key, const char* param_value);
     void WriteSensorDataInfo(int evt_number, unsigned int sensor_id, unsigned int time_bin, unsigned int charge);
     void WriteHitInfo(int evt_number, int particle_indx, int hit_indx, float hit_position_x, float hit_position_y, float hit_position_z, float hit_time, float hit_energy, const char* label);
     void WriteParticleInfo(int evt_number, int particle_indx, const char* particle_name, char primary, int mother_id, float initial_vertex_x, float initial_vertex_y, float initial_vertex_z, float initial_vertex_t, float final_vertex_x, float final_vertex_y, float final_vertex_z, float final_vertex_t, const char* initial_volume, const char* final_volume, float ini_momentum_x, float ini_momentum_y, float ini_momentum_z, float final_momentum_x, float final_momentum_y, float final_momentum_z, float kin_energy, float length, const char* creator_proc, const char* final_proc);
+    /// add to the event index the rows written since the previous event
+    void WriteEventIndex(int evt_number, double weight);
     void WriteSensorPosInfo(unsigned int sensor_id, const char* sensor_name, float x, float y, float z);
     void WriteStep(int evt_number,
                    int particle_id, const char* particle_name,
@@ -44,6 +84,21 @@ namespace nexus {
                    float initial_x, float initial_y, float initial_z,
                    float   final_x, float   final_y, float   final_z);
 
+  private:
+    int32_t StringCode(const char* name);
+    void FlushSensorSamples();
+    size_t ChunkSize(const std::string& table_name) const;
+    void ReportStorage(const std::string& table_name,
+                       size_t dataset, size_t memtype, size_t nrows,
+                       hsize_t& raw_size, hsize_t& stored_size) const;
+
+    template <typename T>
+    void Buffer(std::vector<T>& buffer, const T& row,
+                size_t dataset, size_t memtype, size_t& counter);
+    template <typename T>
+    void Flush(std::vector<T>& buffer,
+               size_t dataset, size_t memtype, size_t& counter);
+
   private:
     size_t file_; ///< HDF5 file
 
@@ -53,25 +108,65 @@ namespace nexus {
     //Datasets
     size_t runTable_;
     size_t snsDataTable_;
+    size_t snsIndexTable_;
+    size_t snsTimeBinTable_;
+    size_t snsChargeTable_;
     size_t hitInfoTable_;
     size_t particleInfoTable_;
     size_t snsPosTable_;
     size_t stepTable_;
+    size_t stringMapTable_;
+    size_t eventIndexTable_;
 
     size_t memtypeRun_;
     size_t memtypeSnsData_;
+    size_t memtypeSnsIndex_;
     size_t memtypeHitInfo_;
     size_t memtypeParticleInfo_;
     size_t memtypeSnsPos_;
     size_t memtypeStep_;
+    size_t memtypeStringMap_;
+    size_t memtypeEventIndex_;
 
     size_t irun_; ///< counter for configuration parameters
     size_t ismp_; ///< counter for written waveform samples
+    size_t iwvf_; ///< counter for written waveforms (sparse layout)
     size_t ihit_; ///< counter for true information
     size_t ipart_; ///< counter for particle information
     size_t ipos_; ///< counter for sensor positions
     size_t istep_; ///< counter for steps
-
+    size_t ievt_; ///< counter for event index rows
+
+    event_index_t eventIndex_; ///< first rows of the current event
+    std::vector<event_index_t> eventIndexBuffer_;
+
+    size_t buffer_rows_; ///< rows kept in memory per table before writing
+
+    std::map<std::string, size_t> chunk_sizes_; ///< chunk size per table
+    int deflate_level_; ///< deflate level (0 means no deflate)
+    bool shuffle_; ///< apply shuffle filter
+    unsigned int filter_id_; ///< registered HDF5 filter (0 means none)
+    std::vector<unsigned int> filter_values_; ///< filter parameters
+
+    //Row buffers
+    std::vector<sns_data_t>      snsDataBuffer_;
+    std::vector<hit_info_t>      hitInfoBuffer_;
+    std::vector<particle_info_t> particleInfoBuffer_;
+    std::vector<step_info_t>     stepBuffer_;
+    std::vector<hit_info_coded_t>      hitCodedBuffer_;
+    std::vector<particle_info_coded_t> particleCodedBuffer_;
+
+    bool sparse_sns_data_; ///< write the sensor response in sparse layout
+    sns_index_t snsIndex_; ///< index row of the waveform being filled
+    std::vector<sns_index_t> snsIndexBuffer_;
+    std::vector<uint32_t>    snsTimeBinBuffer_;
+    std::vector<uint32_t>    snsChargeBuffer_;
+
+    bool encode_strings_; ///< write strings as codes of string_map
+    std::unordered_map<std::string, int32_t> string_codes_; ///< code of each string
+    std::vector<string_map_t> stringMap_; ///< rows of the string_map table
+
+    bool verbose_; ///< report the compression of every table
   };
 
 } // namespace nexus
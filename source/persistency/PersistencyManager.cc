@@ -13,24 +13,31 @@
 #include "TrajectoryMap.h"
 #include "IonizationSD.h"
 #include "PmtSD.h"
+#include "SensorRegistry.h"
 #include "NexusApp.h"
 #include "DetectorConstruction.h"
 #include "SaveAllSteppingAction.h"
 #include "BaseGeometry.h"
 #include "HDF5Writer.h"
+#include "AsyncEventWriter.h"
+#include "HitCompactor.h"
 
 #include <G4GenericMessenger.hh>
 #include <G4Event.hh>
+#include <G4PrimaryVertex.hh>
 #include <G4TrajectoryContainer.hh>
 #include <G4Trajectory.hh>
 #include <G4SDManager.hh>
 #include <G4HCtable.hh>
 #include <G4RunManager.hh>
 #include <G4Run.hh>
+#include <G4VPhysicalVolume.hh>
+#include <G4VProcess.hh>
 
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <iomanip>
 #include <string>
 
 using namespace nexus;
@@ -44,7 +51,16 @@ PersistencyManager::PersistencyManager(G4String init_macro,
   store_evt_(true), store_steps_(false),
   interacting_evt_(false), event_type_("other"), saved_evts_(0),
   interacting_evts_(0), pmt_bin_size_(-1), sipm_bin_size_(-1),
-  nevt_(0), start_id_(0), first_evt_(true), h5writer_(0)
+  buffer_rows_(10000), deflate_level_(0), shuffle_(false), filter_id_(0),
+  encode_strings_(false), sparse_sns_response_(false), verbose_(false), async_(false),
+  async_queue_size_(8), max_evts_per_file_(0), max_file_size_(0.),
+  file_index_(0), processed_evts_(0),
+  hit_time_window_(0.), hit_merge_tracks_(false), hit_compactor_(0),
+  ionization_deposits_(0), ionization_hits_(0),
+  filter_generated_(0), filter_accepted_(0),
+  evt_generated_(0), evt_accepted_(0),
+  nevt_(0), start_id_(0), first_evt_(true), sns_pos_stored_(false),
+  h5writer_(0), async_writer_(0)
 {
   msg_ = new G4GenericMessenger(this, "/nexus/persistency/");
   msg_->DeclareMethod("outputFile", &PersistencyManager::OpenFile, "");
@@ -52,6 +68,51 @@ PersistencyManager::PersistencyManager(G4String init_macro,
                         "Type of event: bb0nu, bb2nu, background.");
   msg_->DeclareProperty("start_id", start_id_,
                         "Starting event ID for this job.");
+  msg_->DeclareMethod("buffer_rows", &PersistencyManager::SetBufferRows,
+                      "Number of rows per table kept in memory before writing to file.");
+  msg_->DeclareMethod("chunk_size", &PersistencyManager::SetChunkSize,
+                      "Chunk size of a table, as 'table_name rows'. Must precede outputFile.");
+  msg_->DeclareMethod("deflate", &PersistencyManager::SetDeflate,
+                      "Deflate compression level of the tables (0-9). Must precede outputFile.");
+  msg_->DeclareProperty("verbose", verbose_,
+                        "Report the compression ratio of each table, "
+                        "not only the total.");
+  msg_->DeclareProperty("shuffle", shuffle_,
+                        "Apply the shuffle filter to the tables. Must precede outputFile.");
+  msg_->DeclareMethod("filter", &PersistencyManager::SetFilter,
+                      "Registered HDF5 filter applied to the tables, as 'id [values]'. "
+                      "Must precede outputFile.");
+  msg_->DeclareProperty("encode_strings", encode_strings_,
+                        "Write particle, volume, process and hit label names "
+                        "as integer codes of the /MC/string_map table. "
+                        "Must precede outputFile.");
+  msg_->DeclareProperty("sparse_sns_response", sparse_sns_response_,
+                        "Write /MC/sns_response as a per-sensor index of "
+                        "waveforms plus flat time_bin and charge arrays. "
+                        "Must precede outputFile.");
+  msg_->DeclareProperty("max_events_per_file", max_evts_per_file_,
+                        "Start a new output file after this number of saved "
+                        "events (0 means no limit). Files are named "
+                        "<outputFile>_NNN.h5. Must precede outputFile.");
+  msg_->DeclareProperty("max_file_size", max_file_size_,
+                        "Start a new output file when the current one reaches "
+                        "this size in MB (0 means no limit). Files are named "
+                        "<outputFile>_NNN.h5. Must precede outputFile.");
+  msg_->DeclareProperty("async", async_,
+                        "Write events to file from a background thread. "
+                        "Must precede outputFile.");
+  msg_->DeclareProperty("async_queue_size", async_queue_size_,
+                        "Maximum number of events waiting to be written "
+                        "in async mode. Must precede outputFile.");
+  msg_->DeclarePropertyWithUnit("hit_voxel_size", "mm", hit_voxel_size_,
+                                "Merge the ionization hits in voxels of this "
+                                "size (0 0 0 means no merging).");
+  msg_->DeclarePropertyWithUnit("hit_time_window", "ns", hit_time_window_,
+                                "Merge the ionization hits of a voxel only within "
+                                "time windows of this width (0 means no limit).");
+  msg_->DeclareProperty("hit_merge_tracks", hit_merge_tracks_,
+                        "Merge the ionization hits of different tracks "
+                        "in the same voxel.");
 
   secondary_macros_.clear();
 }
@@ -61,7 +122,9 @@ PersistencyManager::PersistencyManager(G4String init_macro,
 PersistencyManager::~PersistencyManager()
 {
   delete msg_;
+  delete async_writer_;
   delete h5writer_;
+  delete hit_compactor_;
 }
 
 
@@ -89,9 +152,8 @@ void PersistencyManager::OpenFile(G4String filename)
 {
   // If the output file was not set yet, do so
   if (!h5writer_) {
-    h5writer_ = new HDF5Writer();
-    G4String hdf5file = filename + ".h5";
-    h5writer_->Open(hdf5file, store_steps_);
+    filename_ = filename;
+    OpenWriter();
     return;
   } else {
     G4Exception("[PersistencyManager]", "OpenFile()",
@@ -101,21 +163,208 @@ void PersistencyManager::OpenFile(G4String filename)
 
 
 
+void PersistencyManager::OpenWriter()
+{
+  h5writer_ = new HDF5Writer();
+  h5writer_->SetBufferRows(buffer_rows_);
+  h5writer_->SetCompression(deflate_level_, shuffle_);
+  h5writer_->SetFilter(filter_id_, filter_values_);
+  h5writer_->SetEncodeStrings(encode_strings_);
+  h5writer_->SetSparseSensorData(sparse_sns_response_);
+  h5writer_->SetVerbose(verbose_);
+  for (auto it = chunk_sizes_.begin(); it != chunk_sizes_.end(); ++it)
+    h5writer_->SetChunkSize(it->first, it->second);
+
+  // When the output is split in several files, all of them are numbered
+  G4String hdf5file = filename_;
+  if (RolloverEnabled()) {
+    std::ostringstream suffix;
+    suffix << "_" << std::setw(3) << std::setfill('0') << file_index_;
+    hdf5file += suffix.str();
+  }
+  hdf5file += ".h5";
+  h5writer_->Open(hdf5file, store_steps_);
+
+  if (async_) {
+    if (async_queue_size_ < 1) {
+      G4Exception("[PersistencyManager]", "OpenFile()", FatalException,
+                  "The async queue size must be positive.");
+    }
+    async_writer_ = new AsyncEventWriter(h5writer_, async_queue_size_);
+  }
+}
+
+
+
+void PersistencyManager::NextFile()
+{
+  // Close the current file with its own configuration table
+  StoreRunInfo();
+  CloseFile();
+  delete h5writer_;
+  h5writer_ = 0;
+
+  // Counters and sensor positions refer to the current file
+  saved_evts_       = 0;
+  interacting_evts_ = 0;
+  processed_evts_   = 0;
+  sns_pos_stored_   = false;
+  ionization_deposits_ = 0;
+  ionization_hits_     = 0;
+  filter_generated_ = 0;
+  filter_accepted_  = 0;
+
+  file_index_++;
+  OpenWriter();
+}
+
+
+
+G4bool PersistencyManager::FileIsFull() const
+{
+  if (max_evts_per_file_ > 0 && saved_evts_ >= max_evts_per_file_)
+    return true;
+
+  if (max_file_size_ > 0.) {
+    // The size of the file does not include the rows still buffered
+    unsigned long long size = async_writer_ ?
+      async_writer_->GetFileSize() : h5writer_->GetFileSize();
+    if (size >= max_file_size_ * 1024. * 1024.)
+      return true;
+  }
+
+  return false;
+}
+
+
+
 void PersistencyManager::CloseFile()
 {
   if (!h5writer_) return;
 
+  // Write all the pending events and stop the writer thread
+  delete async_writer_;
+  async_writer_ = 0;
+
   h5writer_->Close();
 }
 
 
 
+void PersistencyManager::SetBufferRows(G4int nrows)
+{
+  if (nrows < 1) {
+    G4Exception("[PersistencyManager]", "SetBufferRows()", FatalException,
+                "The number of buffered rows must be positive.");
+  }
+
+  buffer_rows_ = nrows;
+  if (h5writer_) h5writer_->SetBufferRows(buffer_rows_);
+}
+
+
+
+void PersistencyManager::SetChunkSize(G4String args)
+{
+  std::istringstream iss(args);
+  G4String table_name;
+  G4int nrows = 0;
+  iss >> table_name >> nrows;
+
+  if (iss.fail() || nrows < 1) {
+    G4Exception("[PersistencyManager]", "SetChunkSize()", FatalException,
+                "Usage: chunk_size <table_name> <rows>, with rows > 0.");
+  }
+
+  if (!HDF5Writer::IsTableName(table_name)) {
+    G4Exception("[PersistencyManager]", "SetChunkSize()", JustWarning,
+                ("Unknown table " + table_name + "; chunk size not applied.").c_str());
+    return;
+  }
+
+  if (h5writer_) {
+    G4Exception("[PersistencyManager]", "SetChunkSize()", JustWarning,
+                "The output file is already open; chunk size not applied.");
+    return;
+  }
+
+  chunk_sizes_[table_name] = nrows;
+}
+
+
+
+void PersistencyManager::SetDeflate(G4int level)
+{
+  if (level < 0 || level > 9) {
+    G4Exception("[PersistencyManager]", "SetDeflate()", FatalException,
+                "The deflate level must be between 0 and 9.");
+  }
+
+  if (h5writer_) {
+    G4Exception("[PersistencyManager]", "SetDeflate()", JustWarning,
+                "The output file is already open; compression not applied.");
+    return;
+  }
+
+  deflate_level_ = level;
+}
+
+
+
+void PersistencyManager::SetFilter(G4String args)
+{
+  std::istringstream iss(args);
+  G4int filter_id = 0;
+  iss >> filter_id;
+
+  if (iss.fail() || filter_id <= 0) {
+    G4Exception("[PersistencyManager]", "SetFilter()", FatalException,
+                "Usage: filter <filter_id> [values], with filter_id > 0.");
+  }
+
+  if (h5writer_) {
+    G4Exception("[PersistencyManager]", "SetFilter()", JustWarning,
+                "The output file is already open; filter not applied.");
+    return;
+  }
+
+  // Plugin filters are looked up in HDF5_PLUGIN_PATH at runtime
+  if (H5Zfilter_avail(filter_id) <= 0) {
+    G4String msg = "HDF5 filter " + std::to_string(filter_id)
+      + " is not available and will not be applied.";
+    G4Exception("[PersistencyManager]", "SetFilter()", JustWarning, msg);
+    return;
+  }
+
+  filter_id_ = filter_id;
+  filter_values_.clear();
+  unsigned int value;
+  while (iss >> value)
+    filter_values_.push_back(value);
+}
+
+
+
 G4bool PersistencyManager::Store(const G4Event* event)
 {
+  // Start a new file if the current one is full. This is checked
+  // before counting and storing the event, so that the event is
+  // counted in the file it is written to and no file is left empty.
+  if (store_evt_ && RolloverEnabled() && saved_evts_ > 0 && FileIsFull())
+    NextFile();
+
+  processed_evts_++;
+
   if (interacting_evt_) {
     interacting_evts_++;
   }
 
+  // Candidates drawn by the primary generator for this event
+  filter_generated_ += evt_generated_;
+  filter_accepted_  += evt_accepted_;
+  evt_generated_ = 0;
+  evt_accepted_  = 0;
+
   if (!store_evt_) {
     TrajectoryMap::Clear();
     if (store_steps_) {
@@ -128,6 +377,9 @@ G4bool PersistencyManager::Store(const G4Event* event)
 
   saved_evts_++;
 
+  if (!sns_pos_stored_)
+    StoreSensorPositions();
+
   if (first_evt_) {
     first_evt_ = false;
     nevt_ = start_id_;
@@ -142,6 +394,21 @@ G4bool PersistencyManager::Store(const G4Event* event)
   // Store ionization hits and sensor hits
   StoreHits(event->GetHCofThisEvent());
 
+  // The weight of the event is that of its primary vertices,
+  // set by generators that bias the sampling
+  G4double weight = 1.;
+  for (G4int i=0; i<event->GetNumberOfPrimaryVertex(); ++i)
+    weight *= event->GetPrimaryVertex(i)->GetWeight();
+
+  // Write the event, or hand it over to the writer thread
+  record_.EndEvent(nevt_, weight);
+  if (async_writer_) {
+    async_writer_->Push(record_);
+  } else {
+    record_.Write(h5writer_);
+    record_.Clear();
+  }
+
   nevt_++;
 
   TrajectoryMap::Clear();
@@ -187,19 +454,19 @@ void PersistencyManager::StoreTrajectories(G4TrajectoryContainer* tc)
     } else {
       mother_id = trj->GetParentID();
     }
-    h5writer_->WriteParticleInfo(nevt_, trackid, trj->GetParticleName().c_str(),
-				 primary, mother_id,
-				 (float)ini_xyz.x(), (float)ini_xyz.y(),
-                                 (float)ini_xyz.z(), (float)ini_t,
-				 (float)final_xyz.x(), (float)final_xyz.y(),
-                                 (float)final_xyz.z(), (float)final_t,
-				 ini_volume.c_str(), final_volume.c_str(),
-				 (float)ini_mom.x(), (float)ini_mom.y(),
-                                 (float)ini_mom.z(), (float)final_mom.x(),
-                                 (float)final_mom.y(), (float)final_mom.z(),
-				 kin_energy, length,
-                                 trj->GetCreatorProcess().c_str(),
-				 trj->GetFinalProcess().c_str());
+    record_.AddParticleInfo(nevt_, trackid, trj->GetParticleName().c_str(),
+                            primary, mother_id,
+                            (float)ini_xyz.x(), (float)ini_xyz.y(),
+                            (float)ini_xyz.z(), (float)ini_t,
+                            (float)final_xyz.x(), (float)final_xyz.y(),
+                            (float)final_xyz.z(), (float)final_t,
+                            ini_volume.c_str(), final_volume.c_str(),
+                            (float)ini_mom.x(), (float)ini_mom.y(),
+                            (float)ini_mom.z(), (float)final_mom.x(),
+                            (float)final_mom.y(), (float)final_mom.z(),
+                            kin_energy, length,
+                            trj->GetCreatorProcess().c_str(),
+                            trj->GetFinalProcess().c_str());
 
   }
 }
@@ -247,6 +514,11 @@ void PersistencyManager::StoreIonizationHits(G4VHitsCollection* hc)
     dynamic_cast<IonizationHitsCollection*>(hc);
   if (!hits) return;
 
+  if (HitCompactionEnabled()) {
+    StoreCompactedIonizationHits(hits);
+    return;
+  }
+
   hit_map_.clear();
 
   double evt_energy = 0.;
@@ -271,10 +543,10 @@ void PersistencyManager::StoreIonizationHits(G4VHitsCollection* hc)
     ihits->push_back(1);
 
     G4ThreeVector xyz = hit->GetPosition();
-    h5writer_->WriteHitInfo(nevt_, trackid,  ihits->size() - 1,
-			    xyz[0], xyz[1], xyz[2],
-			    hit->GetTime(), hit->GetEnergyDeposit(),
-			    sdname.c_str());
+    record_.AddHitInfo(nevt_, trackid,  ihits->size() - 1,
+                       xyz[0], xyz[1], xyz[2],
+                       hit->GetTime(), hit->GetEnergyDeposit(),
+                       sdname.c_str());
 
     evt_energy += hit->GetEnergyDeposit();
   }
@@ -282,57 +554,85 @@ void PersistencyManager::StoreIonizationHits(G4VHitsCollection* hc)
 
 
 
-void PersistencyManager::StorePmtHits(G4VHitsCollection* hc)
+void PersistencyManager::StoreCompactedIonizationHits(IonizationHitsCollection* hits)
 {
-  PmtHitsCollection* hits = dynamic_cast<PmtHitsCollection*>(hc);
-  if (!hits) return;
+  if (!hit_compactor_) {
+    if (hit_voxel_size_.x() <= 0. || hit_voxel_size_.y() <= 0. ||
+        hit_voxel_size_.z() <= 0.) {
+      G4Exception("[PersistencyManager]", "StoreIonizationHits()", FatalException,
+                  "All the dimensions of hit_voxel_size must be positive.");
+    }
+    hit_compactor_ = new HitCompactor(hit_voxel_size_, hit_time_window_,
+                                      !hit_merge_tracks_);
+  }
 
+  hit_compactor_->Clear();
+  for (size_t i=0; i<hits->entries(); i++) {
+    IonizationHit* hit = (*hits)[i];
+    hit_compactor_->Add(hit->GetTrackID(), hit->GetPosition(),
+                        hit->GetTime(), hit->GetEnergyDeposit());
+  }
+
+  const std::vector<HitCompactor::Hit>& voxels = hit_compactor_->GetHits();
   std::string sdname = hits->GetSDname();
 
-  std::map<G4String, G4double>::const_iterator sensdet_it = sensdet_bin_.find(sdname);
-  if (sensdet_it == sensdet_bin_.end()) {
-    for (size_t j=0; j<hits->entries(); j++) {
-      PmtHit* hit = dynamic_cast<PmtHit*>(hits->GetHit(j));
-      if (!hit) continue;
-      G4double bin_size = hit->GetBinSize();
-      sensdet_bin_[sdname] = bin_size;
-      break;
-    }
+  // Hits are numbered within each track, as the original ones
+  std::map<G4int, G4int> nhits;
+  for (size_t i=0; i<voxels.size(); i++) {
+    const HitCompactor::Hit& hit = voxels[i];
+    G4int hit_indx = nhits[hit.track_id]++;
+    record_.AddHitInfo(nevt_, hit.track_id, hit_indx,
+                       hit.position.x(), hit.position.y(), hit.position.z(),
+                       hit.time, hit.energy, sdname.c_str());
   }
 
-  for (size_t i=0; i<hits->entries(); i++) {
+  ionization_deposits_ += hit_compactor_->GetNumberOfDeposits();
+  ionization_hits_     += voxels.size();
+}
 
-    PmtHit* hit = dynamic_cast<PmtHit*>(hits->GetHit(i));
-    if (!hit) continue;
 
-    G4ThreeVector xyz = hit->GetPosition();
-    G4double binsize = hit->GetBinSize();
 
-    const std::map<G4double, G4int>& wvfm = hit->GetHistogram();
-    std::map<G4double, G4int>::const_iterator it;
-    std::vector< std::pair<unsigned int,float> > data;
-    G4double amplitude = 0.;
+void PersistencyManager::StorePmtHits(G4VHitsCollection* hc)
+{
+  PmtHitsCollection* hits = dynamic_cast<PmtHitsCollection*>(hc);
+  if (!hits) return;
 
-    for (it = wvfm.begin(); it != wvfm.end(); ++it) {
-      unsigned int time_bin = (unsigned int)((*it).first/binsize+0.5);
-      unsigned int charge = (unsigned int)((*it).second+0.5);
+  for (size_t i=0; i<hits->entries(); i++) {
 
-      data.push_back(std::make_pair(time_bin, charge));
-      amplitude = amplitude + (*it).second;
+    PmtHit* hit = dynamic_cast<PmtHit*>(hits->GetHit(i));
+    if (!hit) continue;
+
+    // Bins are read directly as integers, in time order
+    EventRecord& record = record_;
+    G4int evt = nevt_;
+    unsigned int sensor_id = (unsigned int)hit->GetPmtID();
+    hit->ForEachBin([&record, evt, sensor_id](G4long bin, G4int counts) {
+        record.AddSensorDataInfo(evt, sensor_id,
+                                 (unsigned int)bin, (unsigned int)counts);
+      });
+  }
+}
 
-      h5writer_->WriteSensorDataInfo(nevt_, (unsigned int)hit->GetPmtID(),
-                                     time_bin, charge);
-    }
 
-    std::vector<G4int>::iterator pos_it =
-      std::find(sns_posvec_.begin(), sns_posvec_.end(), hit->GetPmtID());
-    if (pos_it == sns_posvec_.end()) {
-      h5writer_->WriteSensorPosInfo((unsigned int)hit->GetPmtID(), sdname.c_str(),
-				    (float)xyz.x(), (float)xyz.y(), (float)xyz.z());
-      sns_posvec_.push_back(hit->GetPmtID());
-    }
 
+void PersistencyManager::StoreSensorPositions()
+{
+  // All the sensors of the geometry are written at once, whether
+  // they detect light or not, together with the binning of their
+  // sensitive detectors
+  std::vector<SensorRegistry::Sensor> sensors = SensorRegistry::FindSensors();
+
+  for (size_t i=0; i<sensors.size(); ++i) {
+    const SensorRegistry::Sensor& sensor = sensors[i];
+    const G4String& sdname = sensor.sd->GetName();
+    record_.AddSensorPosInfo((unsigned int)sensor.id, sdname.c_str(),
+                             (float)sensor.position.x(),
+                             (float)sensor.position.y(),
+                             (float)sensor.position.z());
+    sensdet_bin_[sdname] = sensor.sd->GetTimeBinning();
   }
+
+  sns_pos_stored_ = true;
 }
 
 
@@ -341,43 +641,57 @@ void PersistencyManager::StoreSteps()
   SaveAllSteppingAction* sa = (SaveAllSteppingAction*)
     G4RunManager::GetRunManager()->GetUserSteppingAction();
 
-  StepContainer<G4String> initial_volumes = sa->get_initial_volumes();
-  StepContainer<G4String>   final_volumes = sa->get_final_volumes  ();
-  StepContainer<G4String>      proc_names = sa->get_proc_names     ();
-
-  StepContainer<G4ThreeVector> initial_poss = sa->get_initial_poss();
-  StepContainer<G4ThreeVector>   final_poss = sa->get_final_poss  ();
-
-  for (auto it = initial_volumes.begin(); it != initial_volumes.end(); ++it) {
-    std::pair<G4int, G4String> key           = it->first;
-    G4int                      track_id      = key.first;
-    G4String                   particle_name = key.second;
-
-    for (size_t step_id=0; step_id < it->second.size(); ++step_id) {
-      h5writer_->WriteStep(nevt_, track_id, particle_name, step_id,
-                           initial_volumes[key][step_id],
-                             final_volumes[key][step_id],
-                                proc_names[key][step_id],
-                           initial_poss   [key][step_id].x(),
-                           initial_poss   [key][step_id].y(),
-                           initial_poss   [key][step_id].z(),
-                             final_poss   [key][step_id].x(),
-                             final_poss   [key][step_id].y(),
-                             final_poss   [key][step_id].z());
-    }
+  const StepColumns& steps = sa->GetSteps();
+
+  for (size_t i=0; i<steps.size(); ++i) {
+    const G4VPhysicalVolume* final_volume = steps.final_volumes[i];
+
+    record_.AddStep(nevt_, steps.track_ids[i],
+                    steps.particles[i]->GetParticleName().c_str(),
+                    steps.step_ids[i],
+                    steps.initial_volumes[i]->GetName().c_str(),
+                    final_volume ? final_volume->GetName().c_str() : "OUT_OF_WORLD",
+                    steps.procs[i]->GetProcessName().c_str(),
+                    steps.initial_poss[i].x(),
+                    steps.initial_poss[i].y(),
+                    steps.initial_poss[i].z(),
+                    steps.  final_poss[i].x(),
+                    steps.  final_poss[i].y(),
+                    steps.  final_poss[i].z());
   }
   sa->Reset();
 }
 
 G4bool PersistencyManager::Store(const G4Run*)
 {
+  StoreRunInfo();
+  return true;
+}
+
+
+
+void PersistencyManager::StoreRunInfo()
+{
+  // The run information is written from this thread
+  if (async_writer_) async_writer_->Drain();
+
+  // Sensor positions are written even if no event was saved
+  if (!sns_pos_stored_) {
+    StoreSensorPositions();
+    record_.Write(h5writer_);
+    record_.Clear();
+  }
+
   // Store the event type
   G4String key = "event_type";
   h5writer_->WriteRunInfo(key, event_type_.c_str());
 
-  // Store the number of events to be processed
+  // Store the number of events to be processed. When the output is
+  // split in several files, each one stores the events processed
+  // while it was open, so that they add up to the total.
   NexusApp* app = (NexusApp*) G4RunManager::GetRunManager();
   G4int num_events = app->GetNumberOfEventsToBeProcessed();
+  if (RolloverEnabled()) num_events = processed_evts_;
 
   key = "num_events";
   h5writer_->WriteRunInfo(key,  std::to_string(num_events).c_str());
@@ -386,12 +700,37 @@ G4bool PersistencyManager::Store(const G4Run*)
   key = "interacting_events";
   h5writer_->WriteRunInfo(key,  std::to_string(interacting_evts_).c_str());
 
+  // Reduction of the ionization hits written by the compaction
+  if (HitCompactionEnabled()) {
+    key = "hit_compaction_deposits";
+    h5writer_->WriteRunInfo(key, std::to_string(ionization_deposits_).c_str());
+    key = "hit_compaction_hits";
+    h5writer_->WriteRunInfo(key, std::to_string(ionization_hits_).c_str());
+    G4double ratio = ionization_hits_ > 0 ?
+      (G4double) ionization_deposits_ / ionization_hits_ : 0.;
+    key = "hit_compaction_ratio";
+    h5writer_->WriteRunInfo(key, std::to_string(ratio).c_str());
+  }
+
+  // Efficiency of the selection applied by the primary generator,
+  // counting the candidates of the events of the current file
+  if (filter_generated_ > 0) {
+    key = "generated_candidates";
+    h5writer_->WriteRunInfo(key, std::to_string(filter_generated_).c_str());
+    key = "accepted_candidates";
+    h5writer_->WriteRunInfo(key, std::to_string(filter_accepted_).c_str());
+    G4double efficiency = (G4double) filter_accepted_ / filter_generated_;
+    key = "filter_efficiency";
+    h5writer_->WriteRunInfo(key, std::to_string(efficiency).c_str());
+  }
+
   std::map<G4String, G4double>::const_iterator it;
   for (it = sensdet_bin_.begin(); it != sensdet_bin_.end(); ++it) {
     h5writer_->WriteRunInfo((it->first + "_binning").c_str(),
                            (std::to_string(it->second/microsecond)+" mus").c_str());
   }
 
+  secondary_macros_.clear();
   SaveConfigurationInfo(init_macro_);
   for (unsigned long i=0; i<macros_.size(); i++) {
     SaveConfigurationInfo(macros_[i]);
@@ -402,8 +741,6 @@ G4bool PersistencyManager::Store(const G4Run*)
   for (unsigned long i=0; i<secondary_macros_.size(); i++) {
     SaveConfigurationInfo(secondary_macros_[i]);
   }
-
-  return true;
 }
 
 void PersistencyManager::SaveConfigurationInfo(G4String file_name)
@@ -10,7 +10,11 @@
 #ifndef PERSISTENCY_MANAGER_H
 #define PERSISTENCY_MANAGER_H
 
+#include "EventRecord.h"
+#include "IonizationHit.h"
+
 #include <G4VPersistencyManager.hh>
+#include <G4ThreeVector.hh>
 #include <map>
 #include <vector>
 
@@ -22,7 +26,8 @@ class G4VHitsCollection;
 
 namespace nexus {
   class HDF5Writer;
-  class IonizationHit;
+  class AsyncEventWriter;
+  class HitCompactor;
 }
 
 namespace nexus {
@@ -38,6 +43,9 @@ namespace nexus {
     void StoreCurrentEvent(G4bool);
     void InteractingEvent(G4bool);
     void StoreSteps(G4bool);
+    /// Count candidates drawn by the primary generator for
+    /// the current event (see GeneratorFilter)
+    void CountCandidates(G4long generated, G4long accepted);
 
     ///
     virtual G4bool Store(const G4Event*);
@@ -51,6 +59,10 @@ namespace nexus {
   public:
     void OpenFile(G4String);
     void CloseFile();
+    void SetBufferRows(G4int);
+    void SetChunkSize(G4String);
+    void SetDeflate(G4int);
+    void SetFilter(G4String);
 
 
   private:
@@ -59,12 +71,21 @@ namespace nexus {
     ~PersistencyManager();
     PersistencyManager(const PersistencyManager&);
 
+    void OpenWriter();
+    void NextFile();
+    G4bool FileIsFull() const;
+    G4bool RolloverEnabled() const;
+    G4bool HitCompactionEnabled() const;
+
     void StoreTrajectories(G4TrajectoryContainer*);
     void StoreHits(G4HCofThisEvent*);
     void StoreIonizationHits(G4VHitsCollection*);
+    void StoreCompactedIonizationHits(IonizationHitsCollection*);
     void StorePmtHits(G4VHitsCollection*);
     void StoreSteps();
+    void StoreSensorPositions();
 
+    void StoreRunInfo();
     void SaveConfigurationInfo(G4String history);
 
 
@@ -83,18 +104,48 @@ namespace nexus {
 
     G4String event_type_; ///< event type: bb0nu, bb2nu, background or not set
 
-    G4int saved_evts_; ///< number of events to be saved
-    G4int interacting_evts_; ///< number of events interacting in ACTIVE
+    G4int saved_evts_; ///< number of events saved in the current file
+    G4int interacting_evts_; ///< number of events interacting in ACTIVE in the current file
     G4double pmt_bin_size_, sipm_bin_size_; ///< bin width of sensors
+    G4int buffer_rows_; ///< rows per table kept in memory before writing
+    std::map<G4String, G4int> chunk_sizes_; ///< chunk size per table
+    G4int deflate_level_; ///< deflate compression level (0 means off)
+    G4bool shuffle_; ///< apply the shuffle filter before compression
+    G4int filter_id_; ///< registered HDF5 filter (0 means none)
+    std::vector<unsigned int> filter_values_; ///< parameters of the filter
+    G4bool encode_strings_; ///< write names as codes of a lookup table
+    G4bool sparse_sns_response_; ///< write sensor waveforms in sparse layout
+    G4bool verbose_; ///< report the compression of every table
+    G4bool async_; ///< write events from a background thread
+    G4int async_queue_size_; ///< maximum number of events waiting to be written
+
+    G4String filename_; ///< base name of the output files
+    G4int max_evts_per_file_; ///< saved events per file (0 means no limit)
+    G4double max_file_size_; ///< size in MB per file (0 means no limit)
+    G4int file_index_; ///< index of the current output file
+    G4int processed_evts_; ///< events processed while the current file is open
+
+    G4ThreeVector hit_voxel_size_; ///< voxel size for merging ionization hits
+    G4double hit_time_window_; ///< time window for merging ionization hits
+    G4bool hit_merge_tracks_; ///< merge the hits of different tracks
+    HitCompactor* hit_compactor_; ///< merger of ionization hits
+    G4long ionization_deposits_; ///< ionization hits before merging, in the current file
+    G4long ionization_hits_; ///< ionization hits written to the current file
+    G4long filter_generated_; ///< generator candidates of the events of the current file
+    G4long filter_accepted_; ///< generator candidates accepted in the current file
+    G4long evt_generated_; ///< generator candidates of the current event
+    G4long evt_accepted_; ///< generator candidates accepted for the current event
 
     G4int nevt_; ///< Event ID
     G4int start_id_; ///< ID for the first event in file
     G4bool first_evt_; ///< true only for the first event of the run
+    G4bool sns_pos_stored_; ///< sensor positions written to the current file?
 
     HDF5Writer* h5writer_;  ///< Event writer to hdf5 file
+    AsyncEventWriter* async_writer_; ///< Background writer thread (async mode)
+    EventRecord record_; ///< Output of the current event
 
     std::map<G4int, std::vector<G4int>* > hit_map_;
-    std::vector<G4int> sns_posvec_;
 
     std::map<G4String, G4double> sensdet_bin_;
   };
@@ -108,6 +159,12 @@ namespace nexus {
   { store_steps_ = ss; }
   inline void PersistencyManager::InteractingEvent(G4bool ie)
   { interacting_evt_ = ie; }
+  inline void PersistencyManager::CountCandidates(G4long generated, G4long accepted)
+  { evt_generated_ += generated; evt_accepted_ += accepted; }
+  inline G4bool PersistencyManager::RolloverEnabled() const
+  { return max_evts_per_file_ > 0 || max_file_size_ > 0.; }
+  inline G4bool PersistencyManager::HitCompactionEnabled() const
+  { return hit_voxel_size_.mag2() > 0.; }
   inline G4bool PersistencyManager::Store(const G4VPhysicalVolume*)
   { return false; }
   inline G4bool PersistencyManager::Retrieve(G4Event*&)
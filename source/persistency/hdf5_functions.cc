@@ -8,6 +8,8 @@
 
 #include "hdf5_functions.h"
 
+#include <algorithm>
+
 hsize_t createRunType()
 {
   hid_t strtype = H5Tcopy(H5T_C_S1);
@@ -33,6 +35,18 @@ hsize_t createSensorDataType()
 }
 
 
+hsize_t createSensorIndexType()
+{
+  //Create compound datatype for the table
+  hsize_t memtype = H5Tcreate (H5T_COMPOUND, sizeof (sns_index_t));
+  H5Tinsert (memtype, "event_id", HOFFSET (sns_index_t, event_id), H5T_NATIVE_INT32);
+  H5Tinsert (memtype, "sensor_id", HOFFSET (sns_index_t, sensor_id), H5T_NATIVE_UINT32);
+  H5Tinsert (memtype, "offset", HOFFSET (sns_index_t, offset), H5T_NATIVE_UINT64);
+  H5Tinsert (memtype, "length", HOFFSET (sns_index_t, length), H5T_NATIVE_UINT32);
+  return memtype;
+}
+
+
 hsize_t createHitInfoType()
 {
   hid_t strtype = H5Tcopy(H5T_C_S1);
@@ -92,6 +106,87 @@ hsize_t createParticleInfoType()
 }
 
 
+hsize_t createHitInfoCodedType()
+{
+  //Create compound datatype for the table
+  hsize_t memtype = H5Tcreate (H5T_COMPOUND, sizeof (hit_info_coded_t));
+  H5Tinsert (memtype, "event_id", HOFFSET (hit_info_coded_t, event_id), H5T_NATIVE_INT32);
+  H5Tinsert (memtype, "x", HOFFSET (hit_info_coded_t, x), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "y", HOFFSET (hit_info_coded_t, y), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "z", HOFFSET (hit_info_coded_t, z), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "time", HOFFSET (hit_info_coded_t, time), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "energy", HOFFSET (hit_info_coded_t, energy), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "label", HOFFSET (hit_info_coded_t, label), H5T_NATIVE_INT32);
+  H5Tinsert (memtype, "particle_id", HOFFSET (hit_info_coded_t, particle_id), H5T_NATIVE_INT);
+  H5Tinsert (memtype, "hit_id", HOFFSET (hit_info_coded_t, hit_id), H5T_NATIVE_INT);
+  return memtype;
+}
+
+
+hsize_t createParticleInfoCodedType()
+{
+  //Create compound datatype for the table
+  hsize_t memtype = H5Tcreate (H5T_COMPOUND, sizeof (particle_info_coded_t));
+  H5Tinsert (memtype, "event_id", HOFFSET (particle_info_coded_t, event_id), H5T_NATIVE_INT32);
+  H5Tinsert (memtype, "particle_id", HOFFSET (particle_info_coded_t, particle_id), H5T_NATIVE_INT);
+  H5Tinsert (memtype, "particle_name", HOFFSET (particle_info_coded_t, particle_name), H5T_NATIVE_INT32);
+  H5Tinsert (memtype, "primary", HOFFSET (particle_info_coded_t, primary), H5T_NATIVE_CHAR);
+  H5Tinsert (memtype, "mother_id", HOFFSET (particle_info_coded_t, mother_id),H5T_NATIVE_INT);
+  H5Tinsert (memtype, "initial_x", HOFFSET (particle_info_coded_t, initial_x), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "initial_y", HOFFSET (particle_info_coded_t, initial_y), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "initial_z", HOFFSET (particle_info_coded_t, initial_z), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "initial_t", HOFFSET (particle_info_coded_t, initial_t), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "final_x", HOFFSET (particle_info_coded_t, final_x), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "final_y", HOFFSET (particle_info_coded_t, final_y), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "final_z", HOFFSET (particle_info_coded_t, final_z), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "final_t", HOFFSET (particle_info_coded_t, final_t), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "initial_volume", HOFFSET (particle_info_coded_t, initial_volume), H5T_NATIVE_INT32);
+  H5Tinsert (memtype, "final_volume", HOFFSET (particle_info_coded_t, final_volume), H5T_NATIVE_INT32);
+  H5Tinsert (memtype, "initial_momentum_x", HOFFSET (particle_info_coded_t, initial_momentum_x), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "initial_momentum_y", HOFFSET (particle_info_coded_t, initial_momentum_y), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "initial_momentum_z", HOFFSET (particle_info_coded_t, initial_momentum_z), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "final_momentum_x", HOFFSET (particle_info_coded_t, final_momentum_x), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "final_momentum_y", HOFFSET (particle_info_coded_t, final_momentum_y), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "final_momentum_z", HOFFSET (particle_info_coded_t, final_momentum_z), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "kin_energy", HOFFSET (particle_info_coded_t, kin_energy), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "length", HOFFSET (particle_info_coded_t, length), H5T_NATIVE_FLOAT);
+  H5Tinsert (memtype, "creator_proc", HOFFSET (particle_info_coded_t, creator_proc), H5T_NATIVE_INT32);
+  H5Tinsert (memtype, "final_proc", HOFFSET (particle_info_coded_t, final_proc), H5T_NATIVE_INT32);
+  return memtype;
+}
+
+
+hsize_t createStringMapType()
+{
+  hid_t strtype = H5Tcopy(H5T_C_S1);
+  H5Tset_size (strtype, STRLEN);
+
+  //Create compound datatype for the table
+  hsize_t memtype = H5Tcreate (H5T_COMPOUND, sizeof (string_map_t));
+  H5Tinsert (memtype, "code", HOFFSET (string_map_t, code), H5T_NATIVE_INT32);
+  H5Tinsert (memtype, "name", HOFFSET (string_map_t, name), strtype);
+  return memtype;
+}
+
+
+hsize_t createEventIndexType()
+{
+  //Create compound datatype for the table
+  hsize_t memtype = H5Tcreate (H5T_COMPOUND, sizeof (event_index_t));
+  H5Tinsert (memtype, "event_id", HOFFSET (event_index_t, event_id), H5T_NATIVE_INT32);
+  H5Tinsert (memtype, "weight", HOFFSET (event_index_t, weight), H5T_NATIVE_DOUBLE);
+  H5Tinsert (memtype, "hits_offset", HOFFSET (event_index_t, hits_offset), H5T_NATIVE_UINT64);
+  H5Tinsert (memtype, "hits_length", HOFFSET (event_index_t, hits_length), H5T_NATIVE_UINT64);
+  H5Tinsert (memtype, "particles_offset", HOFFSET (event_index_t, particles_offset), H5T_NATIVE_UINT64);
+  H5Tinsert (memtype, "particles_length", HOFFSET (event_index_t, particles_length), H5T_NATIVE_UINT64);
+  H5Tinsert (memtype, "sns_response_offset", HOFFSET (event_index_t, sns_response_offset), H5T_NATIVE_UINT64);
+  H5Tinsert (memtype, "sns_response_length", HOFFSET (event_index_t, sns_response_length), H5T_NATIVE_UINT64);
+  H5Tinsert (memtype, "steps_offset", HOFFSET (event_index_t, steps_offset), H5T_NATIVE_UINT64);
+  H5Tinsert (memtype, "steps_length", HOFFSET (event_index_t, steps_length), H5T_NATIVE_UINT64);
+  return memtype;
+}
+
+
 hsize_t createSensorPosType()
 {
   hid_t strtype = H5Tcopy(H5T_C_S1);
@@ -134,7 +229,29 @@ hsize_t createStepType()
   return memtype;
 }
 
-hid_t createTable(hid_t group, std::string& table_name, hsize_t memtype)
+hid_t createFilters(int deflate_level, bool shuffle, H5Z_filter_t filter_id,
+                    const std::vector<unsigned int>& filter_values)
+{
+  // Create a dataset creation property list holding the filter pipeline.
+  // Filters are applied in the order they are set: the shuffle must come
+  // before any compressor to be useful.
+  hid_t plist = H5Pcreate(H5P_DATASET_CREATE);
+
+  if (shuffle)
+    H5Pset_shuffle(plist);
+
+  if (deflate_level > 0)
+    H5Pset_deflate(plist, deflate_level);
+
+  if (filter_id > 0)
+    H5Pset_filter(plist, filter_id, H5Z_FLAG_OPTIONAL,
+                  filter_values.size(), filter_values.data());
+
+  return plist;
+}
+
+hid_t createTable(hid_t group, std::string& table_name, hsize_t memtype,
+                  hsize_t chunk_size, hid_t filters)
 {
   //Create 1D dataspace (evt number). First dimension is unlimited (initially 0)
   const hsize_t ndims = 1;
@@ -142,20 +259,29 @@ hid_t createTable(hid_t group, std::string& table_name, hsize_t memtype)
   hsize_t max_dims[ndims] = {H5S_UNLIMITED};
   hsize_t file_space = H5Screate_simple(ndims, dims, max_dims);
 
-  // Create a dataset creation property list
+  // Create a dataset creation property list from the filter pipeline
   // The layout of the dataset have to be chunked when using unlimited dimensions
-  hid_t plist = H5Pcreate(H5P_DATASET_CREATE);
+  hid_t plist = H5Pcopy(filters);
   H5Pset_layout(plist, H5D_CHUNKED);
-  hsize_t chunk_dims[ndims] = {32768};
+  hsize_t chunk_dims[ndims] = {chunk_size};
   H5Pset_chunk(plist, ndims, chunk_dims);
 
-  //Set compression
-  //  int clevel = 0;
-  //  H5Pset_deflate (plist, clevel);
+  // Make the chunk cache large enough to hold a full chunk, so that
+  // partial writes to a filtered chunk do not force it to be
+  // compressed and read back again.
+  size_t chunk_bytes = chunk_size * H5Tget_size(memtype);
+  hid_t access_plist = H5Pcreate(H5P_DATASET_ACCESS);
+  H5Pset_chunk_cache(access_plist, H5D_CHUNK_CACHE_NSLOTS_DEFAULT,
+                     std::max(chunk_bytes + chunk_bytes/2, (size_t)1048576),
+                     H5D_CHUNK_CACHE_W0_DEFAULT);
 
   // Create dataset
   hid_t dataset = H5Dcreate(group, table_name.c_str(), memtype, file_space,
-                            H5P_DEFAULT, plist, H5P_DEFAULT);
+                            H5P_DEFAULT, plist, access_plist);
+
+  H5Pclose(access_plist);
+  H5Pclose(plist);
+  H5Sclose(file_space);
 
   return dataset;
 }
@@ -169,126 +295,26 @@ hid_t createGroup(hid_t file, std::string& groupName)
   return wfgroup;
 }
 
-void writeRun(run_info_t* runData, hid_t dataset, hid_t memtype, hsize_t counter)
-{
-  hid_t memspace, file_space;
-  hsize_t dims[1] = {1};
-  memspace = H5Screate_simple(1, dims, NULL);
-
-  //Extend dataset
-  dims[0] = counter+1;
-  H5Dset_extent(dataset, dims);
-
-  file_space = H5Dget_space(dataset);
-  hsize_t start[1] = {counter};
-  hsize_t count[1] = {1};
-  H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, NULL, count, NULL);
-  H5Dwrite(dataset, memtype, memspace, file_space, H5P_DEFAULT, runData);
-  H5Sclose(file_space);
-  H5Sclose(memspace);
-}
-
-
-void writeSnsData(sns_data_t* snsData, hid_t dataset, hid_t memtype, hsize_t counter)
-{
-  hid_t memspace, file_space;
-  //Create memspace for one more row
-  const hsize_t n_dims = 1;
-  hsize_t dims[n_dims] = {1};
-  memspace = H5Screate_simple(n_dims, dims, NULL);
-
-  //Extend dataset
-  dims[0] = counter+1;
-  H5Dset_extent(dataset, dims);
-
-  //Write waveforms
-  file_space = H5Dget_space(dataset);
-  hsize_t start[1] = {counter};
-  hsize_t count[1] = {1};
-  H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, NULL, count, NULL);
-  H5Dwrite(dataset, memtype, memspace, file_space, H5P_DEFAULT, snsData);
-  H5Sclose(file_space);
-  H5Sclose(memspace);
-}
-
-void writeHit(hit_info_t* hitInfo, hid_t dataset, hid_t memtype, hsize_t counter)
-{
-  hid_t memspace, file_space;
-
-  const hsize_t n_dims = 1;
-  hsize_t dims[n_dims] = {1};
-  memspace = H5Screate_simple(n_dims, dims, NULL);
-
-  dims[0] = counter+1;
-  H5Dset_extent(dataset, dims);
-
-  file_space = H5Dget_space(dataset);
-  hsize_t start[1] = {counter};
-  hsize_t count[1] = {1};
-  H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, NULL, count, NULL);
-  H5Dwrite(dataset, memtype, memspace, file_space, H5P_DEFAULT, hitInfo);
-  H5Sclose(file_space);
-  H5Sclose(memspace);
-}
-
-void writeParticle(particle_info_t* particleInfo, hid_t dataset, hid_t memtype, hsize_t counter)
+void writeRows(const void* rows, hsize_t nrows, hid_t dataset, hid_t memtype, hsize_t counter)
 {
-  hid_t memspace, file_space;
-
-  const hsize_t n_dims = 1;
-  hsize_t dims[n_dims] = {1};
-  memspace = H5Screate_simple(n_dims, dims, NULL);
+  if (nrows == 0) return;
 
-  dims[0] = counter+1;
-  H5Dset_extent(dataset, dims);
-
-  file_space = H5Dget_space(dataset);
-  hsize_t start[1] = {counter};
-  hsize_t count[1] = {1};
-  H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, NULL, count, NULL);
-  H5Dwrite(dataset, memtype, memspace, file_space, H5P_DEFAULT, particleInfo);
-  H5Sclose(file_space);
-  H5Sclose(memspace);
-}
-
-void writeSnsPos(sns_pos_t* snsPos, hid_t dataset, hid_t memtype, hsize_t counter)
-{
   hid_t memspace, file_space;
-  //Create memspace for one more row
-  const hsize_t n_dims = 1;
-  hsize_t dims[n_dims] = {1};
-  memspace = H5Screate_simple(n_dims, dims, NULL);
-
-  //Extend dataset
-  dims[0] = counter+1;
-  H5Dset_extent(dataset, dims);
-
-  //Write waveforms
-  file_space = H5Dget_space(dataset);
-  hsize_t start[1] = {counter};
-  hsize_t count[1] = {1};
-  H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, NULL, count, NULL);
-  H5Dwrite(dataset, memtype, memspace, file_space, H5P_DEFAULT, snsPos);
-  H5Sclose(file_space);
-  H5Sclose(memspace);
-}
-
-void writeStep(step_info_t* step, hid_t dataset, hid_t memtype, hsize_t counter)
-{
-  hid_t memspace, file_space;
-
+  //Create memspace for the block of rows
   const hsize_t n_dims = 1;
-  hsize_t dims[n_dims] = {1};
+  hsize_t dims[n_dims] = {nrows};
   memspace = H5Screate_simple(n_dims, dims, NULL);
 
-  dims[0] = counter + 1;
+  //Extend dataset once for the whole block
+  dims[0] = counter + nrows;
   H5Dset_extent(dataset, dims);
 
+  //Write the rows contiguously after the last written one
   file_space = H5Dget_space(dataset);
   hsize_t start[1] = {counter};
-  hsize_t count[1] = {1};
+  hsize_t count[1] = {nrows};
   H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, NULL, count, NULL);
-  H5Dwrite(dataset, memtype, memspace, file_space, H5P_DEFAULT, step);
+  H5Dwrite(dataset, memtype, memspace, file_space, H5P_DEFAULT, rows);
   H5Sclose(file_space);
   H5Sclose(memspace);
 }
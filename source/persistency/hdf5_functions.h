@@ -11,6 +11,7 @@
 
 #include <hdf5.h>
 #include <iostream>
+#include <vector>
 
 #define CONFLEN 300
 #define STRLEN 100
@@ -27,6 +28,16 @@
     unsigned int charge;
   } sns_data_t;
 
+  // Index of the sparse layout of the sensor response: the samples
+  // of one sensor in one event are stored in the rows
+  // [offset, offset+length) of the time_bin and charge arrays
+  typedef struct{
+    int32_t  event_id;
+    uint32_t sensor_id;
+    uint64_t offset;
+    uint32_t length;
+  } sns_index_t;
+
   typedef struct{
         int32_t event_id;
 	float x;
@@ -67,6 +78,67 @@
 	char final_proc[STRLEN];
   } particle_info_t;
 
+  // Versions of the hit and particle rows where strings are replaced
+  // by their code in the string_map table
+  typedef struct{
+        int32_t event_id;
+	float x;
+	float y;
+	float z;
+	float time;
+	float energy;
+        int32_t label;
+        int particle_id;
+        int hit_id;
+  } hit_info_coded_t;
+
+  typedef struct{
+        int32_t event_id;
+	int particle_id;
+	int32_t particle_name;
+        char primary;
+	int mother_id;
+	float initial_x;
+	float initial_y;
+	float initial_z;
+	float initial_t;
+	float final_x;
+	float final_y;
+	float final_z;
+	float final_t;
+        int32_t initial_volume;
+        int32_t final_volume;
+	float initial_momentum_x;
+	float initial_momentum_y;
+	float initial_momentum_z;
+	float final_momentum_x;
+	float final_momentum_y;
+	float final_momentum_z;
+	float kin_energy;
+	float length;
+        int32_t creator_proc;
+	int32_t final_proc;
+  } particle_info_coded_t;
+
+  // Rows of each table belonging to one event: [offset, offset+length)
+  typedef struct{
+    int32_t  event_id;
+    double   weight; ///< Weight of the event given by the generator
+    uint64_t hits_offset;
+    uint64_t hits_length;
+    uint64_t particles_offset;
+    uint64_t particles_length;
+    uint64_t sns_response_offset;
+    uint64_t sns_response_length;
+    uint64_t steps_offset;
+    uint64_t steps_length;
+  } event_index_t;
+
+  typedef struct{
+    int32_t code;
+    char    name[STRLEN];
+  } string_map_t;
+
   typedef struct{
     unsigned int sensor_id;
     char sensor_name[STRLEN];
@@ -93,20 +165,28 @@
 
   hsize_t createRunType();
   hsize_t createSensorDataType();
+  hsize_t createSensorIndexType();
   hsize_t createHitInfoType();
   hsize_t createParticleInfoType();
+  hsize_t createHitInfoCodedType();
+  hsize_t createParticleInfoCodedType();
+  hsize_t createStringMapType();
+  hsize_t createEventIndexType();
   hsize_t createSensorPosType();
   hsize_t createStepType();
 
-  hid_t createTable(hid_t group, std::string& table_name, hsize_t memtype);
+  /// Create the dataset creation property list with the filter
+  /// pipeline shared by all tables
+  hid_t createFilters(int deflate_level, bool shuffle, H5Z_filter_t filter_id,
+                      const std::vector<unsigned int>& filter_values);
+
+  hid_t createTable(hid_t group, std::string& table_name, hsize_t memtype,
+                    hsize_t chunk_size, hid_t filters);
   hid_t createGroup(hid_t file, std::string& groupName);
 
-  void writeRun(run_info_t* runData, hid_t dataset, hid_t memtype, hsize_t counter);
-  void writeSnsData(sns_data_t* snsData, hid_t dataset, hid_t memtype, hsize_t counter);
-  void writeHit(hit_info_t* hitInfo, hid_t dataset, hid_t memtype, hsize_t counter);
-  void writeParticle(particle_info_t* particleInfo, hid_t dataset, hid_t memtype, hsize_t counter);
-  void writeSnsPos(sns_pos_t* snsPos, hid_t dataset, hid_t memtype, hsize_t counter);
-  void writeStep(step_info_t* step, hid_t dataset, hid_t memtype, hsize_t counter);
+  /// Append nrows contiguous rows of type memtype to dataset,
+  /// starting at row counter
+  void writeRows(const void* rows, hsize_t nrows, hid_t dataset, hid_t memtype, hsize_t counter);
 
 
 #endif
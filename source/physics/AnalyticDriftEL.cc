@@ -0,0 +1,238 @@
+// ----------------------------------------------------------------------------
+// nexus | AnalyticDriftEL.cc
+//
+// This class drifts an ionization electron through a uniform drift field
+// and across the EL gap that follows it in a single step, computing the
+// attachment, the diffusion and the EL light analytically instead of
+// tracking the electron through the geometry.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#include "AnalyticDriftEL.h"
+
+#include "IonizationElectron.h"
+#include "UniformElectricDriftField.h"
+#include "Electroluminescence.h"
+#include "ELParamSimulation.h"
+#include "ClusterDiffusion.h"
+
+#include <G4ParticleChange.hh>
+#include <G4RegionStore.hh>
+#include <G4Region.hh>
+#include <G4LogicalVolume.hh>
+#include <G4Material.hh>
+#include <G4MaterialPropertiesTable.hh>
+#include <G4SystemOfUnits.hh>
+#include <Randomize.hh>
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace nexus {
+
+
+  AnalyticDriftEL::AnalyticDriftEL(const G4String& process_name,
+                                   G4ProcessType type):
+    G4VDiscreteProcess(process_name, type), el_(0), el_param_(0)
+  {
+    ParticleChange_ = new G4ParticleChange();
+    pParticleChange = ParticleChange_;
+  }
+
+
+
+  AnalyticDriftEL::~AnalyticDriftEL()
+  {
+    delete ParticleChange_;
+  }
+
+
+
+  G4bool AnalyticDriftEL::IsApplicable(const G4ParticleDefinition& pdef)
+  {
+    return (pdef == *IonizationElectron::Definition());
+  }
+
+
+
+  void AnalyticDriftEL::BuildPhysicsTable(const G4ParticleDefinition&)
+  {
+    G4RegionStore* store = G4RegionStore::GetInstance();
+
+    // Uniform fields with a light yield define EL regions
+    std::vector<G4Region*> el_regions;
+    for (size_t i=0; i<store->size(); ++i) {
+      UniformElectricDriftField* field =
+        dynamic_cast<UniformElectricDriftField*>((*store)[i]->GetUserInformation());
+      if (field && field->LightYield() > 0. &&
+          (*store)[i]->GetNumberOfRootVolumes() > 0)
+        el_regions.push_back((*store)[i]);
+    }
+
+    paths_.clear();
+
+    for (size_t i=0; i<store->size(); ++i) {
+      G4Region* region = (*store)[i];
+      UniformElectricDriftField* field =
+        dynamic_cast<UniformElectricDriftField*>(region->GetUserInformation());
+      if (!field) continue;
+
+      Path path = {0, 0, 0};
+
+      if (std::find(el_regions.begin(), el_regions.end(), region) != el_regions.end()) {
+        path.el = field;
+        path.el_material = (*region->GetRootLogicalVolumeIterator())->GetMaterial();
+      }
+      else {
+        // The drift field ends where the EL field starts
+        for (size_t j=0; j<el_regions.size(); ++j) {
+          UniformElectricDriftField* el =
+            static_cast<UniformElectricDriftField*>(el_regions[j]->GetUserInformation());
+          if (el->GetAxis() == field->GetAxis() &&
+              std::abs(el->GetCathodePosition() - field->GetAnodePosition()) < 1.*micrometer) {
+            path.drift = field;
+            path.el = el;
+            path.el_material =
+              (*el_regions[j]->GetRootLogicalVolumeIterator())->GetMaterial();
+            break;
+          }
+        }
+      }
+
+      size_t id = region->GetInstanceID();
+      if (id >= paths_.size()) {
+        Path none = {0, 0, 0};
+        paths_.resize(id+1, none);
+      }
+      paths_[id] = path;
+    }
+
+    const G4MaterialTable* materials = G4Material::GetMaterialTable();
+    attachment_.assign(materials->size(), -1.);
+
+    for (size_t i=0; i<materials->size(); ++i) {
+      G4MaterialPropertiesTable* mpt = (*materials)[i]->GetMaterialPropertiesTable();
+      if (mpt && mpt->ConstPropertyExists("ATTACHMENT"))
+        attachment_[(*materials)[i]->GetIndex()] = mpt->GetConstProperty("ATTACHMENT");
+    }
+  }
+
+
+
+  G4double AnalyticDriftEL::PostStepGetPhysicalInteractionLength(const G4Track& track,
+    G4double, G4ForceCondition* condition)
+  {
+    size_t id = track.GetVolume()->GetLogicalVolume()->GetRegion()->GetInstanceID();
+
+    if (id < paths_.size() && paths_[id].el) {
+      *condition = ExclusivelyForced;
+      return 0.;
+    }
+
+    *condition = NotForced;
+    return DBL_MAX;
+  }
+
+
+
+  G4VParticleChange*
+  AnalyticDriftEL::PostStepDoIt(const G4Track& track, const G4Step& step)
+  {
+    ParticleChange_->Initialize(track);
+    ParticleChange_->ProposeTrackStatus(fStopAndKill);
+
+    const Path& path =
+      paths_[track.GetVolume()->GetLogicalVolume()->GetRegion()->GetInstanceID()];
+
+    G4LorentzVector xyzt(track.GetPosition(), track.GetGlobalTime());
+
+    // Electrons carried by the track (more than one for clusters)
+    G4int num_electrons = std::max(1, G4int(track.GetWeight() + .5));
+
+    // Clusters follow the mean drift line, keeping the diffusion of
+    // their electrons to spread them when they produce EL light
+    ClusterDiffusion* diffusion =
+      dynamic_cast<ClusterDiffusion*>(track.GetUserInformation());
+
+    // Drift to the anode, as IonizationDrift would do in one step
+    if (path.drift) {
+      if (Drift(path.drift, xyzt, diffusion) <= 0.)
+        return G4VDiscreteProcess::PostStepDoIt(track, step);
+      num_electrons = Survivors(track.GetMaterial(), xyzt.t(), num_electrons);
+      if (num_electrons == 0)
+        return G4VDiscreteProcess::PostStepDoIt(track, step);
+    }
+
+    // Cross the EL gap. The parametrization takes the light of the
+    // electrons from where they enter the gap, so the diffusion in
+    // the gap is only added for the emission of the EL photons.
+    G4LorentzVector start(xyzt);
+    G4double length = Drift(path.el, xyzt, el_param_ ? 0 : diffusion);
+
+    if (length <= 0.)
+      return G4VDiscreteProcess::PostStepDoIt(track, step);
+
+    num_electrons = Survivors(path.el_material, xyzt.t(), num_electrons);
+    if (num_electrons == 0)
+      return G4VDiscreteProcess::PostStepDoIt(track, step);
+
+    if (el_param_)
+      el_param_->FillSensors(start.vect(), start.t(), num_electrons, diffusion);
+    else if (el_)
+      el_->EmitPhotons(track, path.el, path.el_material, start, xyzt,
+                       length, num_electrons, ParticleChange_);
+
+    return G4VDiscreteProcess::PostStepDoIt(track, step);
+  }
+
+
+
+  G4double AnalyticDriftEL::Drift(UniformElectricDriftField* field,
+                                  G4LorentzVector& xyzt,
+                                  ClusterDiffusion* diffusion) const
+  {
+    if (!diffusion) return field->Drift(xyzt);
+
+    G4ThreeVector start = xyzt.vect();
+    G4double transv_sigma = 0.;
+    G4double length = field->DriftCluster(xyzt, transv_sigma);
+    diffusion->AddDrift(transv_sigma, xyzt.vect() - start);
+    return length;
+  }
+
+
+
+  G4int AnalyticDriftEL::Survivors(const G4Material* material, G4double time,
+                                   G4int num_electrons) const
+  {
+    size_t index = material->GetIndex();
+    G4double attach = (index < attachment_.size()) ? attachment_[index] : -1.;
+
+    if (attach < 0.) {
+      G4Exception("[AnalyticDriftEL]", "Survivors()", JustWarning,
+        "No material properties table found. Assuming no attachment.");
+      return num_electrons;
+    }
+
+    // Same sampling as in IonizationDrift
+    if (num_electrons == 1) {
+      G4double rnd = -attach * log(G4UniformRand());
+      return (time > rnd) ? 0 : 1;
+    }
+
+    return G4int(CLHEP::RandBinomial::shoot(num_electrons, exp(-time / attach)));
+  }
+
+
+
+  G4double AnalyticDriftEL::GetMeanFreePath(const G4Track&, G4double,
+                                            G4ForceCondition* condition)
+  {
+    *condition = NotForced;
+    return DBL_MAX;
+  }
+
+
+} // end namespace nexus
@@ -0,0 +1,99 @@
+// ----------------------------------------------------------------------------
+// nexus | AnalyticDriftEL.h
+//
+// This class drifts an ionization electron through a uniform drift field
+// and across the EL gap that follows it in a single step, computing the
+// attachment, the diffusion and the EL light analytically instead of
+// tracking the electron through the geometry.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#ifndef ANALYTIC_DRIFT_EL_H
+#define ANALYTIC_DRIFT_EL_H
+
+#include <G4VDiscreteProcess.hh>
+#include <G4LorentzVector.hh>
+
+#include <vector>
+
+class G4ParticleChange;
+class G4Material;
+
+
+namespace nexus {
+
+  class UniformElectricDriftField;
+  class Electroluminescence;
+  class ELParamSimulation;
+  class ClusterDiffusion;
+
+  class AnalyticDriftEL: public G4VDiscreteProcess
+  {
+  public:
+    /// Constructor
+    AnalyticDriftEL(const G4String& process_name="AnalyticDriftEL",
+                    G4ProcessType type=fUserDefined);
+    /// Destructor
+    ~AnalyticDriftEL();
+
+    /// The process is applicable only to ionization electrons
+    G4bool IsApplicable(const G4ParticleDefinition&);
+
+    /// Find, for each region with a uniform drift field, the EL region
+    /// whose cathode is its anode, and cache the attachment of each material
+    void BuildPhysicsTable(const G4ParticleDefinition&);
+
+    /// Emit the EL photons through this process
+    void SetElectroluminescence(Electroluminescence*);
+    /// Fill the sensors through the EL parametrization instead
+    void SetELParametrization(ELParamSimulation*);
+
+    /// Forces the process, excluding all the others, for electrons
+    /// in regions with a known path to an EL region
+    G4double PostStepGetPhysicalInteractionLength(const G4Track&, G4double,
+                                                  G4ForceCondition*);
+
+    /// Drift the electron to the end of the EL gap, produce the light
+    /// and kill the electron
+    G4VParticleChange* PostStepDoIt(const G4Track&, const G4Step&);
+
+  private:
+    /// Not used: the step is limited by PostStepGetPhysicalInteractionLength
+    G4double GetMeanFreePath(const G4Track&, G4double, G4ForceCondition*);
+
+    /// Drift through a field, along the mean drift line for a
+    /// cluster, adding the diffusion of its electrons to it
+    G4double Drift(UniformElectricDriftField*, G4LorentzVector& xyzt,
+                   ClusterDiffusion* diffusion) const;
+
+    /// Sample how many of the electrons of a cluster drifting until
+    /// the given time in a material are not attached by impurities
+    G4int Survivors(const G4Material*, G4double time, G4int num_electrons) const;
+
+  private:
+    /// Fields crossed by the electrons of a region
+    struct Path {
+      UniformElectricDriftField* drift; ///< Field of the region (null if EL)
+      UniformElectricDriftField* el;    ///< Field of the EL region
+      const G4Material* el_material;    ///< Material of the EL gap
+    };
+
+    G4ParticleChange* ParticleChange_;
+
+    Electroluminescence* el_;
+    ELParamSimulation* el_param_;
+
+    std::vector<Path> paths_;          ///< Path of each region, by instance ID
+    std::vector<G4double> attachment_; ///< Attachment of each material, by index
+  };
+
+  inline void AnalyticDriftEL::SetElectroluminescence(Electroluminescence* el)
+  { el_ = el; }
+
+  inline void AnalyticDriftEL::SetELParametrization(ELParamSimulation* el_param)
+  { el_param_ = el_param; }
+
+} // end namespace nexus
+
+#endif
@@ -34,6 +34,12 @@ namespace nexus {
     /// drifting under the influence of the field. Returns the step length.
     virtual G4double Drift(G4LorentzVector&) = 0;
 
+    /// Same as Drift for a cluster of charge carriers, which follows the
+    /// mean drift line: the transverse diffusion is not applied to the
+    /// cluster but returned (sigma), to be applied to each of its carriers.
+    /// By default, the cluster diffuses as a single carrier.
+    virtual G4double DriftCluster(G4LorentzVector&, G4double& transv_sigma);
+
     /// Returns a random 4D point (space and time) along a drift line
     virtual G4LorentzVector 
       GeneratePointAlongDriftLine(const G4LorentzVector&, const G4LorentzVector&) = 0;
@@ -50,6 +56,10 @@ namespace nexus {
   
   inline BaseDriftField::~BaseDriftField() {}
 
+  inline G4double BaseDriftField::DriftCluster(G4LorentzVector& xyzt,
+                                               G4double& transv_sigma)
+  { transv_sigma = 0.; return Drift(xyzt); }
+
   inline G4double BaseDriftField::LightYield() const {return 0.;}
 
   inline void BaseDriftField::Print() const {}
@@ -0,0 +1,64 @@
+// ----------------------------------------------------------------------------
+// nexus | ClusterDiffusion.cc
+//
+// This class keeps the transverse diffusion of a cluster of ionization
+// electrons. The cluster drifts along the mean drift line, and each of
+// its electrons is spread around it where it produces EL light.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#include "ClusterDiffusion.h"
+
+#include <Randomize.hh>
+
+#include <cmath>
+
+
+namespace nexus {
+
+
+  ClusterDiffusion::ClusterDiffusion():
+    G4VUserTrackInformation(), variance_(0.), direction_(0., 0., 1.)
+  {
+  }
+
+
+
+  ClusterDiffusion::~ClusterDiffusion()
+  {
+  }
+
+
+
+  void ClusterDiffusion::AddDrift(G4double transv_sigma,
+                                  const G4ThreeVector& direction)
+  {
+    // The diffusion of consecutive drifts is independent
+    variance_ += transv_sigma * transv_sigma;
+    if (direction.mag2() > 0.) direction_ = direction.unit();
+  }
+
+
+
+  G4ThreeVector ClusterDiffusion::Offset() const
+  {
+    if (variance_ <= 0.) return G4ThreeVector();
+
+    // Gaussian displacement in the plane perpendicular to the drift
+    G4ThreeVector u = direction_.orthogonal().unit();
+    G4ThreeVector v = direction_.cross(u);
+    G4double sigma = std::sqrt(variance_);
+
+    return G4RandGauss::shoot(0., sigma) * u + G4RandGauss::shoot(0., sigma) * v;
+  }
+
+
+
+  G4double ClusterDiffusion::GetTransverseSigma() const
+  {
+    return std::sqrt(variance_);
+  }
+
+
+} // end namespace nexus
@@ -0,0 +1,46 @@
+// ----------------------------------------------------------------------------
+// nexus | ClusterDiffusion.h
+//
+// This class keeps the transverse diffusion of a cluster of ionization
+// electrons. The cluster drifts along the mean drift line, and each of
+// its electrons is spread around it where it produces EL light.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#ifndef CLUSTER_DIFFUSION_H
+#define CLUSTER_DIFFUSION_H
+
+#include <G4VUserTrackInformation.hh>
+#include <G4ThreeVector.hh>
+
+
+namespace nexus {
+
+  class ClusterDiffusion: public G4VUserTrackInformation
+  {
+  public:
+    /// Constructor
+    ClusterDiffusion();
+    /// Destructor
+    ~ClusterDiffusion();
+
+    /// Add the transverse diffusion (sigma) of the electrons
+    /// in a drift of the cluster along a direction
+    void AddDrift(G4double transv_sigma, const G4ThreeVector& direction);
+
+    /// Random transverse offset of one electron of the
+    /// cluster from the drift line of the cluster
+    G4ThreeVector Offset() const;
+
+    /// Transverse diffusion (sigma) accumulated by the electrons
+    G4double GetTransverseSigma() const;
+
+  private:
+    G4double variance_;       ///< Sum of the variances of the drifts
+    G4ThreeVector direction_; ///< Direction of the last drift
+  };
+
+} // end namespace nexus
+
+#endif
@@ -0,0 +1,48 @@
+// ----------------------------------------------------------------------------
+// nexus | DriftFieldCache.cc
+//
+// This class keeps the drift field attached to each region, so that
+// processes can find it with an array lookup instead of a dynamic_cast
+// of the region user information at every step.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#include "DriftFieldCache.h"
+
+#include "BaseDriftField.h"
+
+#include <G4RegionStore.hh>
+
+
+namespace nexus {
+
+
+  DriftFieldCache::DriftFieldCache()
+  {
+  }
+
+
+
+  DriftFieldCache::~DriftFieldCache()
+  {
+  }
+
+
+
+  void DriftFieldCache::Build()
+  {
+    fields_.clear();
+
+    G4RegionStore* store = G4RegionStore::GetInstance();
+
+    for (size_t i=0; i<store->size(); ++i) {
+      G4Region* region = (*store)[i];
+      size_t id = region->GetInstanceID();
+      if (id >= fields_.size()) fields_.resize(id+1, 0);
+      fields_[id] = dynamic_cast<BaseDriftField*>(region->GetUserInformation());
+    }
+  }
+
+
+} // end namespace nexus
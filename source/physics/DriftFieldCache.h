@@ -0,0 +1,52 @@
+// ----------------------------------------------------------------------------
+// nexus | DriftFieldCache.h
+//
+// This class keeps the drift field attached to each region, so that
+// processes can find it with an array lookup instead of a dynamic_cast
+// of the region user information at every step.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#ifndef DRIFT_FIELD_CACHE_H
+#define DRIFT_FIELD_CACHE_H
+
+#include <G4Region.hh>
+
+#include <vector>
+
+
+namespace nexus {
+
+  class BaseDriftField;
+
+  class DriftFieldCache
+  {
+  public:
+    /// Constructor
+    DriftFieldCache();
+    /// Destructor
+    ~DriftFieldCache();
+
+    /// Store the drift field of all the regions defined so far.
+    /// Invoked by the processes when their physics tables are built.
+    void Build();
+
+    /// Return the drift field of a region (null if it has none)
+    BaseDriftField* GetField(const G4Region*);
+
+  private:
+    std::vector<BaseDriftField*> fields_; ///< Field of each region, by instance ID
+  };
+
+  inline BaseDriftField* DriftFieldCache::GetField(const G4Region* region)
+  {
+    size_t id = region->GetInstanceID();
+    // Regions created after the last build
+    if (id >= fields_.size()) Build();
+    return (id < fields_.size()) ? fields_[id] : 0;
+  }
+
+} // end namespace nexus
+
+#endif
@@ -1,209 +1,274 @@
 // ----------------------------------------------------------------------------
 // nexus | ELLookupTable.cc
 //
-// This class describes the generation of the EL light.
+// This class holds the EL look-up table: for each point of a square grid
+// in the EL gap, the probability that an EL photon is detected by each
+// sensor in each time bin. Tables are read either from the text format
+// or, memory-mapped, from the binary format described below.
 //
 // The NEXT Collaboration
 // ----------------------------------------------------------------------------
 
 #include "ELLookupTable.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <fstream>
+#include <map>
+#include <sstream>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 
 namespace nexus {
 
+  namespace {
+    const char el_table_magic[8] = {'N','X','E','L','T','A','B','1'};
+  }
+
+
 
-  ELLookupTable::ELLookupTable(G4String filename)
+  ELLookupTable::ELLookupTable(G4String filename):
+    radius_(0.), pitch_(0.), nodes_(0), num_points_(0), num_bins_(0),
+    offsets_(0), sensor_ids_(0), probs_(0), map_(0), map_size_(0)
   {
-    // read the text files and store their content in the transient table
-    ReadFiles(filename);
+    std::ifstream file(filename, std::ifstream::binary);
+    if (!file.is_open()) {
+      G4Exception("[ELLookupTable]", "ELLookupTable()", FatalErrorInArgument,
+                  ("Cannot open EL table file " + filename).c_str());
+    }
+
+    char magic[sizeof(el_table_magic)] = {0};
+    file.read(magic, sizeof(magic));
+    file.close();
+
+    if (std::memcmp(magic, el_table_magic, sizeof(magic)) == 0)
+      MapBinary(filename);
+    else
+      ReadText(filename);
+
+    BuildGridIndex();
   }
 
 
 
   ELLookupTable::~ELLookupTable()
   {
+    if (map_) munmap(map_, map_size_);
   }
 
 
 
-  void ELLookupTable::ReadFiles(G4String filename)
+  void ELLookupTable::ReadText(const G4String& filename)
   {
-    // Open the file containing the light table
-    std::ifstream file(filename, std::ifstream::out);
+    std::ifstream file(filename);
 
-    if (!file.is_open())
-      {}
-      //G4Exception("[ELLookupTable] ERROR: cannot open input file!");
+    // Sensor probabilities of each point
+    std::vector<std::map<int32_t, std::vector<float> > > points;
 
-    // Deal with the header file
-    G4String line;
+    std::string line;
 
-    do {
-      getline(file, line);
-    } while(line[0] == '*');
+    while (std::getline(file, line)) {
 
-    // Read file and store content in the transient table
+      if (line.empty()) continue;
 
-    int num_bins = 5;
-    int last_point_id = 0;
-    std::map<int, std::vector<double> > sensor_map;
+      if (line[0] == '*') {
+        std::istringstream fields(line.substr(1));
+        std::string key;
+        fields >> key;
+        if      (key == "grid_radius") fields >> radius_;
+        else if (key == "grid_pitch")  fields >> pitch_;
+        continue;
+      }
 
-    while (!file.eof()) {
+      std::istringstream fields(line);
 
       G4int point_id, sensor_id;
-      std::vector<double> probs;
+      if (!(fields >> point_id >> sensor_id) || point_id < 0) {
+        G4Exception("[ELLookupTable]", "ReadText()", FatalErrorInArgument,
+                    ("Malformed line in EL table file: " + line).c_str());
+      }
 
-      file >> point_id >> sensor_id;
+      if (points.size() <= (size_t) point_id)
+        points.resize(point_id+1);
 
-      for (G4int i=0; i<num_bins; i++) {
-	G4double prob;
-	file >> prob;
-	probs.push_back(prob);
-      }
+      std::vector<float>& probs = points[point_id][sensor_id];
+      probs.clear();
+      G4double prob;
+      while (fields >> prob)
+        probs.push_back(prob);
 
-      sensor_map.insert(std::make_pair(sensor_id, probs));
+      num_bins_ = std::max(num_bins_, probs.size());
+    }
 
-      if (point_id != last_point_id) {
-	ELtable_.push_back(sensor_map);
+    // Store the table in compressed sparse rows,
+    // padding the missing time bins with zeros
+    num_points_ = points.size();
+    own_offsets_.assign(1, 0);
+
+    for (size_t i=0; i<points.size(); ++i) {
+      std::map<int32_t, std::vector<float> >::const_iterator it;
+      for (it = points[i].begin(); it != points[i].end(); ++it) {
+        own_sensor_ids_.push_back(it->first);
+        own_probs_.insert(own_probs_.end(), it->second.begin(), it->second.end());
+        own_probs_.resize(own_sensor_ids_.size() * num_bins_, 0.);
       }
-
-      last_point_id = point_id;
+      own_offsets_.push_back(own_sensor_ids_.size());
     }
+
+    offsets_    = own_offsets_.data();
+    sensor_ids_ = own_sensor_ids_.data();
+    probs_      = own_probs_.data();
   }
 
 
 
-  const std::map<int, std::vector<double> >&
-  ELLookupTable::GetSensorsMap(const G4ThreeVector& hitpos)
+  void ELLookupTable::MapBinary(const G4String& filename)
   {
-    /// The EL points must be in the middle of the bins.
-    double radius = 92.5; // mm
-    double binning = 5.; // mm
-    int maxidx = radius*2./binning + 1;
-    /// If the number of bins per axis is odd, a different math must be applied
-    bool even = false;
-    if ((maxidx/2.-floor(maxidx/2.)) == 0.){
-      even = true;
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+      G4Exception("[ELLookupTable]", "MapBinary()", FatalErrorInArgument,
+                  ("Cannot open EL table file " + filename).c_str());
     }
-    std::vector<double> bincenters;
-    std::vector<int> content;
-    /// Fill a vector with the coordinates of the center of bins (they are the same in
-    /// x and y, because it is a regular squared grid)
-    for (int i=0; i<maxidx; i++){
-      double bincenter = -binning*(maxidx/2.) + binning/2.+ i*binning;
-      bincenters.push_back(bincenter);
+
+    map_size_ = st.st_size;
+    // The mapping is shared, so all the jobs running on
+    // a machine read the same physical copy of the table
+    map_ = mmap(0, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map_ == MAP_FAILED) {
+      map_ = 0;
+      G4Exception("[ELLookupTable]", "MapBinary()", FatalException,
+                  ("Cannot map EL table file " + filename).c_str());
     }
-    /// For every coordinate in x, a column is built with a number of bins equal
-    /// to the number of EL points which have that x. Remember that only the points
-    /// which falls inside a circle of a fixed radius are taken into account,
-    /// so columns have not all the same number of points
-
-    /// Content of elements for every column in the grid
-    std::vector<int> columns;
-    if (even){
-      for (int i=0; i<maxidx; i++){
-	double y = sqrt(radius*radius - bincenters[i]*bincenters[i]);
-	double col = 0;
-	///If the y coord of the circle falls further than the center of the bin,
-	///that bin is included, otherwise it isn't.
-	if ((y/binning) - floor(y/binning)<0.5){
-	  col = floor(y/binning)*2.;
-	} else {
-	  col = ceil(y/binning)*2.;
-	}
-	columns.push_back(col);
-      }
-    } else {
-      columns.push_back(0);
-      for (int i=1; i<maxidx-1; i++){
-	double y = sqrt(radius*radius - bincenters[i]*bincenters[i]);
-	double col = 0;
-	///If the y coord of the circle falls further than the center of the bin,
-	///that bin is included, otherwise it isn't.
-	if ((y-binning/2.)/binning - floor((y-binning/2.)/binning)<0.5){
-	  col = floor((y-binning/2.)/binning)*2.+1;
-	} else {
-	  if (y < radius){
-	    col = ceil((y-binning/2.)/binning)*2.+1;
-	  } else {
-	    col = ceil((y-binning/2.)/binning)*2.-1;
-	  }
-	}
-	columns.push_back(col);
-      }
-      columns.push_back(0);
+
+    const char* data = static_cast<const char*>(map_);
+    ELTableHeader header;
+    if (map_size_ >= sizeof(header)) std::memcpy(&header, data, sizeof(header));
+
+    if (map_size_ < sizeof(header) || header.version != 1) {
+      G4Exception("[ELLookupTable]", "MapBinary()", FatalErrorInArgument,
+                  ("Unsupported EL table file " + filename).c_str());
     }
 
-    for (unsigned int i=0; i<columns.size(); i++){
-      content.push_back(columns[i]);
+    radius_     = header.radius;
+    pitch_      = header.pitch;
+    num_points_ = header.num_points;
+    num_bins_   = header.num_bins;
+
+    size_t offsets_size = (num_points_ + 1) * sizeof(uint64_t);
+    size_t ids_size     = header.num_entries * sizeof(int32_t);
+    size_t probs_size   = header.num_entries * num_bins_ * sizeof(float);
+
+    if (map_size_ != sizeof(header) + offsets_size + ids_size + probs_size) {
+      G4Exception("[ELLookupTable]", "MapBinary()", FatalErrorInArgument,
+                  ("Truncated EL table file " + filename).c_str());
     }
 
-    int id;
-
-    /// Maths to obtain the right ID number of the points
-    int zero = maxidx/2;
-    int binX = zero + ceil(hitpos[0]/5.);
-    int binY = zero + ceil(hitpos[1]/5.);
-    if (!even) {
-      zero = floor(maxidx/2)+1;
-      if (hitpos[0]/binning-floor(hitpos[0]/binning) >= 0.5){
-	binX = zero + ceil(hitpos[0]/binning);
-      } else {
-	binX = zero + floor(hitpos[0]/binning);
-      }
-      if (hitpos[1]/binning-floor(hitpos[1]/binning) >= 0.5){
-	binY = zero + ceil(hitpos[1]/binning);
-      } else {
-	binY = zero + floor(hitpos[1]/binning);
+    data += sizeof(header);
+    offsets_    = reinterpret_cast<const uint64_t*>(data);
+    sensor_ids_ = reinterpret_cast<const int32_t*>(data + offsets_size);
+    probs_      = reinterpret_cast<const float*>(data + offsets_size + ids_size);
+  }
+
+
+
+  void ELLookupTable::BuildGridIndex()
+  {
+    if (!(radius_ > 0.) || !(pitch_ > 0.)) {
+      G4Exception("[ELLookupTable]", "BuildGridIndex()", FatalErrorInArgument,
+                  "The EL table header does not define the grid radius and pitch.");
+    }
+
+    // Same grid as the vertices generated by the geometries: nodes at
+    // -radius + i*pitch along each axis, numbered by x and then by y,
+    // keeping only those inside the circle
+    nodes_ = floor(2.*radius_/pitch_) + 1;
+    grid_index_.assign(nodes_ * nodes_, -1);
+
+    G4int id = 0;
+    for (G4int i=0; i<nodes_; ++i) {
+      G4double x = -radius_ + i*pitch_;
+      for (G4int j=0; j<nodes_; ++j) {
+        G4double y = -radius_ + j*pitch_;
+        if (sqrt(x*x+y*y) <= radius_)
+          grid_index_[i*nodes_+j] = id++;
       }
     }
-    // "binX-1" is due to the fact that content is a vector (starting from 0),
-    // while binX and binY starts from 1
-
-    // number of empty bins starting from below
-    int base = (maxidx - content[binX-1])/2;
-
-    // Check if the point is in a bin which does not correspond to any
-    // EL point. In this case the closest bin is chosen.
-    if (binY > base + content[binX-1] || binY < base+1){
-      double centerX = bincenters[binX-1];
-      double centerY = bincenters[binY-1];
-      double min_dist = 1.E6;
-      int min_xbin = 100;
-      int min_ybin = 100;
-      for (int i=0; i<maxidx; i++){
-	double x = bincenters[i];
-	for (int j=0; j<maxidx; j++){
-	  double y = bincenters[j];
-	  int bx = zero + ceil(x/5.);
-	  int by = zero + ceil(y/5.);
-	  int ped = (maxidx - content[bx-1])/2;;
-	  if (!(by > ped + content[bx-1] || by < ped+1)){
-	    double dist = sqrt(pow(centerX-x,2)+pow(centerY-y,2));
-	    if (dist < min_dist){
-	      min_dist = dist;
-	      min_xbin = bx;
-	      min_ybin = by;
-	    }
-	  }
-	}
+
+    if (num_points_ > (size_t) id) {
+      G4Exception("[ELLookupTable]", "BuildGridIndex()", FatalErrorInArgument,
+                  "The EL table has more points than its grid.");
+    }
+
+    // Nodes outside the circle take the point of the closest node inside,
+    // searched in squares of increasing size around the node
+    std::vector<G4int> inside(grid_index_);
+
+    for (G4int i=0; i<nodes_; ++i) {
+      for (G4int j=0; j<nodes_; ++j) {
+        if (inside[i*nodes_+j] >= 0) continue;
+
+        G4int best = -1;
+        G4int best_dist2 = 0;
+
+        for (G4int r=1; r<nodes_; ++r) {
+          // Nodes in farther squares are at least r bins away
+          if (best >= 0 && r*r > best_dist2) break;
+          for (G4int di=-r; di<=r; ++di) {
+            for (G4int dj=-r; dj<=r; ++dj) {
+              if (std::abs(di) != r && std::abs(dj) != r) continue;
+              G4int ii = i + di, jj = j + dj;
+              if (ii < 0 || jj < 0 || ii >= nodes_ || jj >= nodes_) continue;
+              G4int candidate = inside[ii*nodes_+jj];
+              G4int dist2 = di*di + dj*dj;
+              if (candidate >= 0 && (best < 0 || dist2 < best_dist2)) {
+                best = candidate;
+                best_dist2 = dist2;
+              }
+            }
+          }
+        }
+
+        grid_index_[i*nodes_+j] = best;
       }
-      binX = min_xbin;
-      binY = min_ybin;
-      base = (maxidx - content[binX-1])/2;
     }
+  }
+
 
-    int sum = 0;
-    for (int i=0; i<binX-1; i++){
-      sum = sum + content[i];
+
+  ELLookupTable::Point ELLookupTable::GetPoint(const G4ThreeVector& pos) const
+  {
+    // Closest node of the grid, moving positions outside it to its border
+    G4int i = G4int(std::floor((pos.x() + radius_) / pitch_ + 0.5));
+    G4int j = G4int(std::floor((pos.y() + radius_) / pitch_ + 0.5));
+    i = std::max(0, std::min(i, nodes_-1));
+    j = std::max(0, std::min(j, nodes_-1));
+
+    size_t id = grid_index_[i*nodes_+j];
+
+    Point point;
+    point.num_bins = num_bins_;
+
+    // Points without an entry in the table produce no light
+    if (id >= num_points_) {
+      point.sensor_ids = 0;
+      point.probs = 0;
+      point.size = 0;
+      return point;
     }
-    // The "-1" comes because the EL point IDs start from 0
-    id = sum + binY - base - 1;
 
-    return ELtable_[id];
+    size_t first = offsets_[id];
+    point.sensor_ids = sensor_ids_ + first;
+    point.probs = probs_ + first * num_bins_;
+    point.size = offsets_[id+1] - first;
+    return point;
   }
 
 
@@ -1,7 +1,10 @@
 // ----------------------------------------------------------------------------
 // nexus | ELLookupTable.h
 //
-// This class describes the generation of the EL light.
+// This class holds the EL look-up table: for each point of a square grid
+// in the EL gap, the probability that an EL photon is detected by each
+// sensor in each time bin. Tables are read either from the text format
+// or, memory-mapped, from the binary format described below.
 //
 // The NEXT Collaboration
 // ----------------------------------------------------------------------------
@@ -9,38 +12,97 @@
 #ifndef EL_LOOKUP_TABLE_H
 #define EL_LOOKUP_TABLE_H
 
-#include <G4VUserRegionInformation.hh>
 #include <G4ThreeVector.hh>
 #include <globals.hh>
 
 #include <vector>
-#include <map>
+#include <stdint.h>
 
 
 namespace nexus {
 
-  class ELLookupTable: public G4VUserRegionInformation
+  /// Text format: header lines start with '*' and must include
+  /// "* grid_radius <mm>" and "* grid_pitch <mm>". Every other line holds
+  /// a point ID, a sensor ID and the probabilities of the time bins.
+  ///
+  /// Binary format (native byte order), in compressed sparse rows:
+  ///   ELTableHeader
+  ///   uint64_t offsets[num_points+1]   first entry of each point
+  ///   int32_t  sensor_ids[num_entries]
+  ///   float    probs[num_entries*num_bins]
+  /// The scripts/convert_el_table.py script converts text tables.
+
+  struct ELTableHeader {
+    char     magic[8];    ///< "NXELTAB1"
+    uint32_t version;     ///< Format version (1)
+    uint32_t num_bins;    ///< Number of time bins of each entry
+    double   radius;      ///< Radius of the grid (mm)
+    double   pitch;       ///< Distance between grid points (mm)
+    uint64_t num_points;  ///< Number of EL points
+    uint64_t num_entries; ///< Number of (point, sensor) entries
+  };
+
+  class ELLookupTable
   {
   public:
-    /// Constructor
-    ELLookupTable(G4String);
+    /// Response of the sensors to a point of the table
+    struct Point {
+      const int32_t* sensor_ids; ///< IDs of the sensors seeing light
+      const float* probs;        ///< num_bins probabilities per sensor
+      size_t size;               ///< Number of sensors
+      size_t num_bins;           ///< Number of time bins
+    };
+
+  public:
+    /// Constructor. The format of the file is detected from its content.
+    ELLookupTable(G4String filename);
     /// Destructor
     ~ELLookupTable();
 
-    /// Read input files and store their content in the transient table
-    void ReadFiles(G4String);
+    /// Return the sensor response of the grid point closest
+    /// to a given position in the EL gap
+    Point GetPoint(const G4ThreeVector&) const;
 
-    /// Returns the appropiate sensor map for a given point in the EL gap
-    virtual const std::map<int, std::vector<double> >&
-    GetSensorsMap(const G4ThreeVector&);
+    G4double GetRadius() const;
+    G4double GetPitch() const;
+    size_t GetNumberOfPoints() const;
 
+  private:
+    /// Read a table in text format into the owned arrays
+    void ReadText(const G4String& filename);
+    /// Memory-map a table in binary format
+    void MapBinary(const G4String& filename);
+    /// Compute the point ID of each grid node, using the
+    /// closest point inside the circle for nodes outside it
+    void BuildGridIndex();
 
   private:
+    G4double radius_;
+    G4double pitch_;
+    G4int nodes_;  ///< Number of grid nodes per axis
+
+    size_t num_points_;
+    size_t num_bins_;
+
+    const uint64_t* offsets_;
+    const int32_t*  sensor_ids_;
+    const float*    probs_;
 
-    std::vector<std::map<int, std::vector<double> > > ELtable_;
+    /// Storage of tables read from text
+    std::vector<uint64_t> own_offsets_;
+    std::vector<int32_t>  own_sensor_ids_;
+    std::vector<float>    own_probs_;
 
+    void*  map_;      ///< Mapped binary file, if any
+    size_t map_size_;
+
+    std::vector<G4int> grid_index_; ///< Point ID of each grid node
   };
 
+  inline G4double ELLookupTable::GetRadius() const { return radius_; }
+  inline G4double ELLookupTable::GetPitch() const { return pitch_; }
+  inline size_t ELLookupTable::GetNumberOfPoints() const { return num_points_; }
+
 } // end namespace nexus
 
 #endif
@@ -1,7 +1,10 @@
 // ----------------------------------------------------------------------------
 // nexus | ELParamSimulation.cc
 //
-// This class (WIP) implements a parametrized simulation .
+// This class implements a parametrized simulation of the
+// electroluminescence (S2) light. Instead of generating and tracking
+// the optical photons, the response of the sensors to each ionization
+// electron reaching the EL region is sampled from a look-up table.
 //
 // The NEXT Collaboration
 // ----------------------------------------------------------------------------
@@ -10,35 +13,53 @@
 
 #include "ELLookupTable.h"
 #include "IonizationElectron.h"
+#include "UniformElectricDriftField.h"
+#include "PmtSD.h"
+#include "SensorRegistry.h"
+#include "ClusterDiffusion.h"
 
-#include <G4RunManager.hh>
-
-#include <TRandom2.h>
-#include <TVector3.h>
+#include <G4Poisson.hh>
+#include <G4Region.hh>
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 
 namespace nexus {
 
 
-  ELParamSimulation::ELParamSimulation(G4Region* region):
+  ELParamSimulation::ELParamSimulation(G4Region* region, ELLookupTable* table,
+                                       G4double time_binning, G4double yield):
     G4VFastSimulationModel("ELParamSimulation", region),
-    table_(0)
+    table_(table), time_binning_(time_binning), yield_(yield),
+    sensors_searched_(false), warned_(false)
   {
-    // check whether the region has an EL look-up table attached
-    table_ = dynamic_cast<ELLookupTable*>(region->GetUserInformation());
-    // if (!table_) {
-    //   G4String msg = "ERROR: no EL lookup table attached to the region!";
-    //   G4Exception("[ELParamSimulation]", "ELParamSimulation()",
-    // 		  FatalException, msg);
-    // }
-
+    if (!table_) {
+      G4Exception("[ELParamSimulation]", "ELParamSimulation()",
+                  FatalException, "No EL look-up table given.");
+    }
+
+    if (yield_ <= 0.) {
+      // Photons emitted by an electron crossing the whole EL gap
+      UniformElectricDriftField* field =
+        dynamic_cast<UniformElectricDriftField*>(region->GetUserInformation());
+      if (field)
+        yield_ = field->LightYield() *
+          std::abs(field->GetAnodePosition() - field->GetCathodePosition());
+    }
+
+    if (yield_ <= 0.) {
+      G4Exception("[ELParamSimulation]", "ELParamSimulation()",
+                  FatalException, "Cannot determine the EL yield of the region.");
+    }
   }
 
 
 
   ELParamSimulation::~ELParamSimulation()
   {
+    delete table_;
   }
 
 
@@ -57,43 +78,103 @@ namespace nexus {
 
 
 
-  void ELParamSimulation::DoIt(const G4FastTrack& ftrack, G4FastStep& /*fstep*/)
+  void ELParamSimulation::FindSensors()
   {
-    // Get spatial coordinates
-    G4ThreeVector position = ftrack.GetPrimaryTrack()->GetPosition();
-
-    G4cout << "position = " << position << G4endl;
+    std::vector<SensorRegistry::Sensor> sensors = SensorRegistry::FindSensors();
 
+    for (size_t i=0; i<sensors.size(); ++i) {
+      Sensor sensor;
+      sensor.sd       = sensors[i].sd;
+      sensor.position = sensors[i].position;
+      sensors_[sensors[i].id] = sensor;
+    }
 
-    //table_->GetSensorsMap()
+    // The geometry is searched only once, even if no sensor is found
+    sensors_searched_ = true;
 
-    //if (HCE_.size() == 0) {
-
-      G4HCofThisEvent* hce =
-	G4RunManager::GetRunManager()->GetCurrentEvent()->GetHCofThisEvent();
-
-      //}
+    if (sensors_.empty())
+      G4Exception("[ELParamSimulation]", "FindSensors()", JustWarning,
+                  "No sensor found in the geometry; no EL light will be detected.");
+  }
 
 
-    G4cout << "No of collections: " << hce->GetNumberOfCollections() << G4endl;
 
+  void ELParamSimulation::DoIt(const G4FastTrack& ftrack, G4FastStep& fstep)
+  {
+    const G4Track* track = ftrack.GetPrimaryTrack();
+    // Clusters of ionization electrons carry their size as weight
+    FillSensors(track->GetPosition(), track->GetGlobalTime(),
+                std::max(1, G4int(track->GetWeight() + 0.5)),
+                dynamic_cast<ClusterDiffusion*>(track->GetUserInformation()));
 
-    G4cout << "here" << G4endl;
+    fstep.KillPrimaryTrack();
+  }
 
 
-    ///FIXME. Parameters to be put in some other place
-    // G4int fNum_tbins = 5;
-    // G4double fBinWidth = 200.;
-    // G4int gain = 1170;
 
-    // Get track coordinates
-    // ...
+  void ELParamSimulation::FillSensors(const G4ThreeVector& position, G4double time,
+                                      G4int num_electrons,
+                                      const ClusterDiffusion* diffusion)
+  {
+    if (!sensors_searched_) FindSensors();
+
+    if (!diffusion || num_electrons == 1) {
+      FillSensors(table_->GetPoint(position), time, num_electrons);
+      return;
+    }
+
+    // Each electron of a cluster enters the EL gap with its own
+    // transverse diffusion around the cluster. The electrons that
+    // fall on the same point of the table are sampled together.
+    std::vector<ELLookupTable::Point> points;
+    std::vector<G4int> electrons;
+
+    for (G4int e=0; e<num_electrons; ++e) {
+      ELLookupTable::Point point = table_->GetPoint(position + diffusion->Offset());
+      size_t p = 0;
+      while (p < points.size() && points[p].sensor_ids != point.sensor_ids) ++p;
+      if (p == points.size()) {
+        points.push_back(point);
+        electrons.push_back(0);
+      }
+      electrons[p]++;
+    }
+
+    for (size_t p=0; p<points.size(); ++p)
+      FillSensors(points[p], time, electrons[p]);
+  }
 
-    // Ask table for the right sensor map
-    // ...
 
-    // Fill PmtHits according to this map
 
+  void ELParamSimulation::FillSensors(const ELLookupTable::Point& point,
+                                      G4double time, G4int num_electrons)
+  {
+    for (size_t k=0; k<point.size; ++k) {
+
+      G4int sensor_id = point.sensor_ids[k];
+      std::unordered_map<G4int, Sensor>::const_iterator sensor =
+        sensors_.find(sensor_id);
+
+      if (sensor == sensors_.end()) {
+        if (!warned_) {
+          G4Exception("[ELParamSimulation]", "DoIt()", JustWarning,
+                      "The EL table contains sensors not found in the geometry.");
+          warned_ = true;
+        }
+        continue;
+      }
+
+      // Each EL photon is detected independently, so the number of
+      // photons detected in a bin is Poisson-distributed
+      const float* probs = point.probs + k * point.num_bins;
+      for (size_t i=0; i<point.num_bins; ++i) {
+        if (probs[i] <= 0.) continue;
+        G4int counts = G4int(G4Poisson(num_electrons * yield_ * probs[i]));
+        if (counts > 0)
+          sensor->second.sd->Fill(sensor_id, sensor->second.position,
+                                  time + (i + 0.5) * time_binning_, counts);
+      }
+    }
   }
 
 
@@ -1,7 +1,10 @@
 // ----------------------------------------------------------------------------
 // nexus | ELParamSimulation.h
 //
-// This class (WIP) implements a parametrized simulation .
+// This class implements a parametrized simulation of the
+// electroluminescence (S2) light. Instead of generating and tracking
+// the optical photons, the response of the sensors to each ionization
+// electron reaching the EL region is sampled from a look-up table.
 //
 // The NEXT Collaboration
 // ----------------------------------------------------------------------------
@@ -9,59 +12,72 @@
 #ifndef EL_PARAM_SIMULATION_H
 #define EL_PARAM_SIMULATION_H
 
+#include "ELLookupTable.h"
+
 #include <G4VFastSimulationModel.hh>
-#include "PmtHit.h"
-#include <vector>
+
+#include <unordered_map>
 
 
 namespace nexus {
 
-  class ELLookupTable;
+  class PmtSD;
+  class ClusterDiffusion;
 
   class ELParamSimulation: public G4VFastSimulationModel
   {
   public:
-    /// Constructor
-    ELParamSimulation(G4Region* region);
+    /// Constructor. The table gives, for each EL point, the probability
+    /// that an EL photon is detected by each sensor in each time bin,
+    /// counted from the arrival of the ionization electron. The yield is
+    /// the mean number of EL photons per ionization electron; if it is
+    /// not positive, it is computed from the drift field of the region.
+    /// The model takes ownership of the table.
+    ELParamSimulation(G4Region* region, ELLookupTable* table,
+                      G4double time_binning, G4double yield = 0.);
     /// Destructor
     ~ELParamSimulation();
 
-    // This model is only valid for ionization electrons
+    /// This model is only valid for ionization electrons
     G4bool IsApplicable(const G4ParticleDefinition&);
 
-    // You have to return "true" when the dynamics conditions to trigger your
-    // parameterisation are fulfilled. The G4FastTrack provides you access to
-    // the current G4Track, gives simple access to envelope related features
-    // (G4LogicalVolume, G4VSolid, G4AffineTransform references between the
-    // global and the envelope local coordinates systems) and simple access to
-    // the position, momentum expressed in the envelope coordinate system.
-    // Using those quantities and the G4VSolid methods, you can for example
-    // easily check how far you are from the envelope boundary.
-    G4bool ModelTrigger(const G4FastTrack &);
-
-    // Your parameterisation properly said. The G4FastTrack reference provides
-    // input informations. The final state of the particles after parameterisation
-    // has to be returned through the G4FastStep reference. This final state is
-    // described has "requests" the tracking will apply after your
-    // parameterisation has been invoked.
-    void DoIt(const G4FastTrack&, G4FastStep&);
+    /// The model is applied to every ionization electron in the region
+    G4bool ModelTrigger(const G4FastTrack&);
 
-    //To load EL table
-    // void ReadELTable(const char* filename,
-    // 		     std::map<int, std::map<int, std::vector<double> > >& eltable);
+    /// Sample the number of photons detected by each sensor,
+    /// fill the sensor hits and kill the ionization electron
+    void DoIt(const G4FastTrack&, G4FastStep&);
 
+    /// Sample the response of the sensors to a number of ionization
+    /// electrons entering the EL region at the given position and time.
+    /// The electrons of a cluster are spread by its diffusion, if given.
+    void FillSensors(const G4ThreeVector& position, G4double time,
+                     G4int num_electrons=1,
+                     const ClusterDiffusion* diffusion=0);
 
   private:
-    //BaseELGrid* elgrid_;
-    // std::map<G4int, std::map<G4int, std::vector<G4double> > >  eltable_;
+    /// Sensitive detector and position of a sensor
+    struct Sensor {
+      PmtSD* sd;
+      G4ThreeVector position;
+    };
 
-    // bool timebinning_;
-    // int num_tbins_;
+    /// Find the sensors placed in the geometry
+    void FindSensors();
 
-    ELLookupTable* table_;
+    /// Sample the response of the sensors to the electrons
+    /// entering the EL region at a point of the table
+    void FillSensors(const ELLookupTable::Point&, G4double time,
+                     G4int num_electrons);
 
-    std::vector<PmtHitsCollection*> HCE_;
+  private:
+    ELLookupTable* table_;
+    G4double time_binning_; ///< Width of the time bins of the table
+    G4double yield_;        ///< Mean number of EL photons per ie-
 
+    std::unordered_map<G4int, Sensor> sensors_; ///< Sensors, by ID
+    G4bool sensors_searched_; ///< Has the geometry been searched for sensors?
+    G4bool warned_; ///< Has the user been warned of unknown sensors?
   };
 
 } // end namespace nexus
@@ -10,6 +10,7 @@
 
 #include "IonizationElectron.h"
 #include "BaseDriftField.h"
+#include "ClusterDiffusion.h"
 
 #include <G4MaterialPropertiesTable.hh>
 #include <G4PhysicsOrderedFreeVector.hh>
@@ -21,6 +22,9 @@
 
 #include <CLHEP/Units/PhysicalConstants.h>
 
+#include <algorithm>
+#include <vector>
+
 using namespace nexus;
 using namespace CLHEP;
 
@@ -29,7 +33,7 @@ using namespace CLHEP;
 Electroluminescence::Electroluminescence(const G4String& process_name,
 					                               G4ProcessType type):
   G4VDiscreteProcess(process_name, type), theFastIntegralTable_(0),
-  table_generation_(false), photons_per_point_(0)
+  table_generation_(false), photons_per_point_(0), photon_bunch_size_(1)
 {
   ParticleChange_ = new G4ParticleChange();
   pParticleChange = ParticleChange_;
@@ -44,6 +48,12 @@ Electroluminescence::Electroluminescence(const G4String& process_name,
   msg_->DeclareProperty("photons_per_point", photons_per_point_,
 			"Photon per point");
 
+  G4GenericMessenger::Command& bunch_cmd =
+    msg_->DeclareProperty("photon_bunch_size", photon_bunch_size_,
+                          "Number of EL photons carried by each optical photon track.");
+  bunch_cmd.SetParameterName("photon_bunch_size", false);
+  bunch_cmd.SetRange("photon_bunch_size>0");
+
  }
 
 
@@ -62,6 +72,22 @@ G4bool Electroluminescence::IsApplicable(const G4ParticleDefinition& pdef)
 
 
 
+void Electroluminescence::BuildPhysicsTable(const G4ParticleDefinition&)
+{
+  fields_.Build();
+
+  // Materials defined after the construction of the process
+  if (theFastIntegralTable_ &&
+      theFastIntegralTable_->size() != G4Material::GetNumberOfMaterials()) {
+    theFastIntegralTable_->clearAndDestroy();
+    delete theFastIntegralTable_;
+    theFastIntegralTable_ = 0;
+  }
+  BuildThePhysicsTable();
+}
+
+
+
 G4VParticleChange*
 Electroluminescence::PostStepDoIt(const G4Track& track, const G4Step& step)
 {
@@ -71,22 +97,56 @@ Electroluminescence::PostStepDoIt(const G4Track& track, const G4Step& step)
   // Get the current region and its associated drift field.
   // If no drift field is defined, kill the track and leave
   G4Region* region = track.GetVolume()->GetLogicalVolume()->GetRegion();
-  BaseDriftField* field =
-    dynamic_cast<BaseDriftField*>(region->GetUserInformation());
+  BaseDriftField* field = fields_.GetField(region);
   if (!field) {
     ParticleChange_->ProposeTrackStatus(fStopAndKill);
     return G4VDiscreteProcess::PostStepDoIt(track, step);
   }
 
+  G4LorentzVector initial_position(step.GetPreStepPoint()->GetPosition(),
+                                   step.GetPreStepPoint()->GetGlobalTime());
+  G4LorentzVector final_position(step.GetPostStepPoint()->GetPosition(),
+                                 step.GetPostStepPoint()->GetGlobalTime());
+
+  G4Material* mat = step.GetPostStepPoint()->GetTouchable()->GetVolume()->GetLogicalVolume()->GetMaterial();
+
+  // Clusters of ionization electrons carry their size as weight
+  G4int num_electrons = std::max(1, G4int(track.GetWeight() + 0.5));
+
+  G4int num_tracks = EmitPhotons(track, field, mat, initial_position, final_position,
+                                 step.GetStepLength(), num_electrons, ParticleChange_);
+
+  // Track secondaries first to avoid a memory bloat
+  if ((num_tracks > 0) && (track.GetTrackStatus() == fAlive))
+    ParticleChange_->ProposeTrackStatus(fSuspend);
+
+  return G4VDiscreteProcess::PostStepDoIt(track, step);
+}
+
+
+
+G4int Electroluminescence::EmitPhotons(const G4Track& track, BaseDriftField* field,
+                                       const G4Material* mat,
+                                       const G4LorentzVector& initial_position,
+                                       const G4LorentzVector& final_position,
+                                       G4double step_length, G4int num_electrons,
+                                       G4VParticleChange* change)
+{
   // Get the light yield from the field
   const G4double yield = field->LightYield();
-  G4double step_length = step.GetStepLength();
 
-  if (yield <= 0.)
-    return G4VDiscreteProcess::PostStepDoIt(track, step);
+  if (yield <= 0.) return 0;
+
+  // Energy is sampled from integral (like it is
+  // done in G4Scintillation). The integral is empty
+  // for materials without EL spectrum.
+  G4PhysicsOrderedFreeVector* spectrum_integral =
+    (G4PhysicsOrderedFreeVector*)(*theFastIntegralTable_)(mat->GetIndex());
+
+  if (spectrum_integral->GetVectorLength() == 0) return 0;
 
   // Generate a random number of photons around mean 'yield'
-  G4double mean = yield * step_length;
+  G4double mean = yield * step_length * num_electrons;
 
   G4int num_photons;
 
@@ -101,38 +161,32 @@ Electroluminescence::PostStepDoIt(const G4Track& track, const G4Step& step)
   if (table_generation_)
     num_photons = photons_per_point_;
 
-  ParticleChange_->SetNumberOfSecondaries(num_photons);
-
-  // Track secondaries first to avoid a memory bloat
-  if ((num_photons > 0) && (track.GetTrackStatus() == fAlive))
-    ParticleChange_->ProposeTrackStatus(fSuspend);
-
-
-  //////////////////////////////////////////////////////////////////
+  // The photons are emitted in bunches that share direction, energy
+  // and position, each one tracked as a single photon whose weight
+  // is the number of photons in the bunch
+  G4int num_bunches = (num_photons + photon_bunch_size_ - 1) / photon_bunch_size_;
 
-  G4ThreeVector position = step.GetPreStepPoint()->GetPosition();
-  G4double time = step.GetPreStepPoint()->GetGlobalTime();
-  G4LorentzVector initial_position(position, time);
+  if (num_bunches <= 0) return 0;
 
-  G4ThreeVector position_end = step.GetPostStepPoint()->GetPosition();
-  G4double time_end = step.GetPostStepPoint()->GetGlobalTime();
-  G4LorentzVector final_position(position_end, time_end);
-
-  // Energy is sampled from integral (like it is
-  // done in G4Scintillation)
-  G4Material* mat = step.GetPostStepPoint()->GetTouchable()->GetVolume()->GetLogicalVolume()->GetMaterial();
-  G4MaterialPropertiesTable* mpt = mat->GetMaterialPropertiesTable();
-  const G4MaterialPropertyVector* spectrum = mpt->GetProperty("ELSPECTRUM");
-
-  if (!spectrum) return G4VDiscreteProcess::PostStepDoIt(track, step);
-
-  G4PhysicsOrderedFreeVector* spectrum_integral =
-    (G4PhysicsOrderedFreeVector*)(*theFastIntegralTable_)(mat->GetIndex());
+  change->SetNumberOfSecondaries(num_bunches);
 
+  // Keep the weights of the bunches instead of that of the ie-
+  change->SetSecondaryWeightByProcess(true);
 
   G4double sc_max = spectrum_integral->GetMaxValue();
 
-  for (G4int i=0; i<num_photons; i++) {
+  // The electrons of a cluster, which has drifted along the mean
+  // drift line, emit their light around it, each one with its own
+  // transverse diffusion. The bunches are shared among them.
+  std::vector<G4ThreeVector> offsets;
+  ClusterDiffusion* diffusion =
+    dynamic_cast<ClusterDiffusion*>(track.GetUserInformation());
+  if (diffusion && num_electrons > 1) {
+    offsets.resize(num_electrons);
+    for (G4int e=0; e<num_electrons; ++e) offsets[e] = diffusion->Offset();
+  }
+
+  for (G4int i=0; i<num_bunches; i++) {
     // Generate a random direction for the photon
     // (EL is supposed isotropic)
     G4double cos_theta = 1. - 2.*G4UniformRand();
@@ -177,15 +231,19 @@ Electroluminescence::PostStepDoIt(const G4Track& track, const G4Step& step)
 
     G4LorentzVector xyzt =
       field->GeneratePointAlongDriftLine(initial_position, final_position);
+    if (!offsets.empty())
+      xyzt += G4LorentzVector(offsets[G4long(i) * num_electrons / num_bunches], 0.);
 
     // Create the track
     G4Track* secondary = new G4Track(photon, xyzt.t(), xyzt.v());
     secondary->SetParentID(track.GetTrackID());
-    ParticleChange_->AddSecondary(secondary);
-
+    if (photon_bunch_size_ > 1)
+      secondary->SetWeight(std::min(photon_bunch_size_,
+                                    num_photons - i*photon_bunch_size_));
+    change->AddSecondary(secondary);
   }
 
-  return G4VDiscreteProcess::PostStepDoIt(track, step);
+  return num_bunches;
 }
 
 
@@ -10,14 +10,20 @@
 #define ELECTROLUMINESCENCE_H
 
 #include <G4VDiscreteProcess.hh>
+#include <G4LorentzVector.hh>
+
+#include "DriftFieldCache.h"
 
 
 class G4ParticleChange;
 class G4GenericMessenger;
+class G4Material;
 
 
 namespace nexus {
 
+  class BaseDriftField;
+
   class Electroluminescence: public G4VDiscreteProcess
   {
   public:
@@ -30,12 +36,24 @@ namespace nexus {
     /// Returns true if particle is an ionization electron
     G4bool IsApplicable(const G4ParticleDefinition&);
 
+    /// Cache the drift field of each region and
+    /// the EL spectrum of each material
+    void BuildPhysicsTable(const G4ParticleDefinition&);
+
   public:
     /// This is the method that implements the EL light emission
     /// as a post-step process, that is, photons are generated as
     /// secondaries at the end of the step.
     G4VParticleChange* PostStepDoIt(const G4Track&, const G4Step&);
 
+    /// Generate the EL photons emitted by a number of ionization electrons
+    /// drifting a given length between two points of a field, adding them
+    /// as secondaries to the particle change. Returns the number of tracks.
+    G4int EmitPhotons(const G4Track&, BaseDriftField*, const G4Material*,
+                      const G4LorentzVector& initial, const G4LorentzVector& final,
+                      G4double step_length, G4int num_electrons,
+                      G4VParticleChange*);
+
   private:
 
     /// Returns infinity; i.e., the process does not limit the step,
@@ -52,10 +70,13 @@ namespace nexus {
 
     G4PhysicsTable* theFastIntegralTable_;
 
+    DriftFieldCache fields_; ///< Drift field of each region
+
     G4GenericMessenger* msg_;
 
     G4bool table_generation_;
     G4int photons_per_point_;
+    G4int photon_bunch_size_; ///< Photons carried by each optical photon track
   };
 
 } // end namespace nexus
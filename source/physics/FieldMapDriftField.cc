@@ -0,0 +1,221 @@
+// ----------------------------------------------------------------------------
+// nexus | FieldMapDriftField.cc
+//
+// Drift field described by a precomputed map of the drift velocity, the
+// diffusion and the displacement of the drift lines on a regular grid,
+// either in (r, z) or in (x, y, z). The map is read from a binary file.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#include "FieldMapDriftField.h"
+#include "SegmentPointSampler.h"
+
+#include <Randomize.hh>
+
+#include "CLHEP/Units/SystemOfUnits.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+
+namespace nexus {
+
+  using namespace CLHEP;
+
+  namespace {
+    const char drift_map_magic[8] = {'N','X','D','R','M','A','P','1'};
+  }
+
+
+
+  FieldMapDriftField::FieldMapDriftField(G4String filename):
+    BaseDriftField(), dimensions_(0), anode_pos_(0.), cathode_pos_(0.)
+  {
+    std::ifstream file(filename, std::ifstream::binary);
+    if (!file.is_open()) {
+      G4Exception("[FieldMapDriftField]", "FieldMapDriftField()", FatalErrorInArgument,
+                  ("Cannot open drift field map " + filename).c_str());
+    }
+
+    DriftMapHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!file || std::memcmp(header.magic, drift_map_magic, sizeof(header.magic)) != 0 ||
+        header.version != 1 || (header.dimensions != 2 && header.dimensions != 3)) {
+      G4Exception("[FieldMapDriftField]", "FieldMapDriftField()", FatalErrorInArgument,
+                  ("Unsupported drift field map " + filename).c_str());
+    }
+
+    dimensions_ = header.dimensions;
+    size_t num_nodes = 1;
+    for (G4int i=0; i<3; ++i) {
+      num_nodes_[i] = header.num_nodes[i];
+      min_[i]       = header.min[i];
+      pitch_[i]     = header.pitch[i];
+      num_nodes *= num_nodes_[i];
+      if (num_nodes_[i] < 1 || (num_nodes_[i] > 1 && !(pitch_[i] > 0.))) {
+        G4Exception("[FieldMapDriftField]", "FieldMapDriftField()", FatalErrorInArgument,
+                    ("Invalid grid in drift field map " + filename).c_str());
+      }
+    }
+    anode_pos_   = header.anode;
+    cathode_pos_ = header.cathode;
+
+    values_.resize(num_nodes * kNumValues);
+    file.read(reinterpret_cast<char*>(values_.data()), values_.size() * sizeof(float));
+
+    if (!file) {
+      G4Exception("[FieldMapDriftField]", "FieldMapDriftField()", FatalErrorInArgument,
+                  ("Truncated drift field map " + filename).c_str());
+    }
+
+    rnd_ = new SegmentPointSampler();
+  }
+
+
+
+  FieldMapDriftField::~FieldMapDriftField()
+  {
+    delete rnd_;
+  }
+
+
+
+  void FieldMapDriftField::Interpolate(const G4ThreeVector& position,
+                                       G4double values[kNumValues]) const
+  {
+    G4double coords[3] = {position.x(), position.y(), position.z()};
+    if (dimensions_ == 2) {
+      coords[0] = std::sqrt(position.x()*position.x() + position.y()*position.y());
+      coords[1] = position.z();
+      coords[2] = 0.;
+    }
+
+    // Lower node and weight of the upper node along each coordinate,
+    // moving positions outside the grid to its border
+    size_t lower[3], stride[3];
+    G4double frac[3];
+    for (G4int i=0; i<3; ++i) {
+      G4double u = (num_nodes_[i] > 1) ? (coords[i] - min_[i]) / pitch_[i] : 0.;
+      u = std::max(0., std::min(u, G4double(num_nodes_[i] - 1)));
+      lower[i]  = std::min(size_t(u), size_t(std::max(num_nodes_[i] - 2, 0)));
+      frac[i]   = u - lower[i];
+      stride[i] = (num_nodes_[i] > 1) ? 1 : 0;
+    }
+
+    const size_t step[3] = {size_t(num_nodes_[1]) * num_nodes_[2] * kNumValues,
+                            size_t(num_nodes_[2]) * kNumValues,
+                            size_t(kNumValues)};
+    const float* base = values_.data() + lower[0]*step[0] + lower[1]*step[1] + lower[2]*step[2];
+
+    for (G4int v=0; v<kNumValues; ++v) values[v] = 0.;
+
+    // Sum over the corners of the cell
+    for (G4int c=0; c<8; ++c) {
+      G4double weight = 1.;
+      size_t offset = 0;
+      for (G4int i=0; i<3; ++i) {
+        G4bool upper = (c >> i) & 1;
+        weight *= upper ? frac[i] : 1. - frac[i];
+        if (upper) offset += stride[i] * step[i];
+      }
+      if (weight == 0.) continue;
+      const float* node = base + offset;
+      for (G4int v=0; v<kNumValues; ++v) values[v] += weight * node[v];
+    }
+  }
+
+
+
+  G4double FieldMapDriftField::Drift(G4LorentzVector& xyzt)
+  {
+    G4double transv_sigma;
+    return DriftCarrier(xyzt, true, transv_sigma);
+  }
+
+
+
+  G4double FieldMapDriftField::DriftCluster(G4LorentzVector& xyzt,
+                                            G4double& transv_sigma)
+  {
+    return DriftCarrier(xyzt, false, transv_sigma);
+  }
+
+
+
+  G4double FieldMapDriftField::DriftCarrier(G4LorentzVector& xyzt,
+                                            G4bool transv_diffusion,
+                                            G4double& transv_sigma)
+  {
+    transv_sigma = 0.;
+
+    // Charges outside the drift volume don't move
+    if (!CheckCoordinate(xyzt.z())) return 0.;
+
+    G4double values[kNumValues];
+    Interpolate(xyzt.vect(), values);
+
+    const G4double velocity = values[kVelocity];
+    if (!(velocity > 0.)) return 0.;
+
+    // Transverse directions of the displacement
+    G4ThreeVector dir1(1., 0., 0.), dir2(0., 1., 0.);
+    if (dimensions_ == 2) {
+      G4double r = xyzt.perp();
+      if (r > 0.) {
+        dir1.set(xyzt.x()/r, xyzt.y()/r, 0.);
+        dir2.set(-dir1.y(), dir1.x(), 0.);
+      }
+    }
+
+    // Same margin as in UniformElectricDriftField: the charge is
+    // left 1 micrometer beyond the anode, just outside the drift
+    // volume, so that it does not drift again
+    G4double secmargin = -1. * micrometer;
+    if (anode_pos_ > cathode_pos_) secmargin = -secmargin;
+
+    G4double drift_length = std::abs(xyzt.z() - anode_pos_);
+    G4double drift_time = drift_length / velocity;
+
+    transv_sigma = values[kTransvSigma];
+    G4double time_sigma = values[kLongitSigma] / velocity;
+
+    G4ThreeVector position = xyzt.vect()
+      + values[kDisplacement1] * dir1 + values[kDisplacement2] * dir2;
+    if (transv_diffusion)
+      position += G4RandGauss::shoot(0., transv_sigma) * dir1
+                + G4RandGauss::shoot(0., transv_sigma) * dir2;
+    position.setZ(anode_pos_ + secmargin);
+
+    G4double time = xyzt.t() + drift_time + G4RandGauss::shoot(0., time_sigma);
+    if (time < xyzt.t()) time = xyzt.t() + drift_time;
+
+    G4double step_length = (position - xyzt.vect()).mag();
+
+    xyzt.set(time, position);
+
+    return step_length;
+  }
+
+
+
+  G4LorentzVector FieldMapDriftField::GeneratePointAlongDriftLine(
+    const G4LorentzVector& origin, const G4LorentzVector& end)
+  {
+    rnd_->SetPoints(origin, end);
+    return rnd_->Shoot();
+  }
+
+
+
+  G4bool FieldMapDriftField::CheckCoordinate(G4double z) const
+  {
+    return (z >= std::min(anode_pos_, cathode_pos_) &&
+            z <= std::max(anode_pos_, cathode_pos_));
+  }
+
+
+} // end namespace nexus
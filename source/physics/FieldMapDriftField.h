@@ -0,0 +1,116 @@
+// ----------------------------------------------------------------------------
+// nexus | FieldMapDriftField.h
+//
+// Drift field described by a precomputed map of the drift velocity, the
+// diffusion and the displacement of the drift lines on a regular grid,
+// either in (r, z) or in (x, y, z). The map is read from a binary file.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#ifndef FIELD_MAP_DRIFT_FIELD_H
+#define FIELD_MAP_DRIFT_FIELD_H
+
+#include "BaseDriftField.h"
+
+#include <G4LorentzVector.hh>
+#include <globals.hh>
+
+#include <vector>
+#include <stdint.h>
+
+
+namespace nexus {
+
+  class SegmentPointSampler;
+
+  /// Binary format (native byte order):
+  ///   DriftMapHeader
+  ///   float values[num_nodes[0]*num_nodes[1]*num_nodes[2]][5]
+  /// with the nodes ordered by the first, second and third coordinate,
+  /// and the values of each node stored together: drift velocity (mm/ns),
+  /// transverse and longitudinal diffusion at the anode (sigma, mm) and
+  /// displacement of the drift line at the anode along the two transverse
+  /// coordinates (mm): x and y for (x, y, z) maps, r and r*phi for (r, z)
+  /// maps, whose third coordinate has a single node.
+  /// The drift velocity of a node is not the local one, but the mean
+  /// velocity along the drift line from the node to the anode: its
+  /// distance in z to the anode divided by the drift time to the anode.
+  /// The electrons drift to the anode in one step with that velocity.
+  /// The scripts/convert_drift_map.py script converts text maps.
+
+  struct DriftMapHeader {
+    char     magic[8];     ///< "NXDRMAP1"
+    uint32_t version;      ///< Format version (1)
+    uint32_t dimensions;   ///< 2 for (r, z) maps, 3 for (x, y, z) maps
+    uint32_t num_nodes[3]; ///< Number of nodes along each coordinate
+    uint32_t reserved;
+    double   min[3];       ///< Coordinates of the first node (mm)
+    double   pitch[3];     ///< Distance between nodes (mm)
+    double   anode;        ///< z of the anode (mm)
+    double   cathode;      ///< z of the cathode (mm)
+  };
+
+  class FieldMapDriftField: public BaseDriftField
+  {
+  public:
+    /// Values stored at each node of the map
+    enum Value { kVelocity, kTransvSigma, kLongitSigma,
+                 kDisplacement1, kDisplacement2, kNumValues };
+
+  public:
+    /// Constructor, reading the map from a binary file
+    FieldMapDriftField(G4String filename);
+    /// Destructor
+    ~FieldMapDriftField();
+
+    /// Move an ionization electron from its position to the anode,
+    /// following the drift line and diffusion of the map. The drift
+    /// lines go along the z axis, from the cathode to the anode.
+    G4double Drift(G4LorentzVector& xyzt);
+
+    /// Drift a cluster of ionization electrons along its mean drift line
+    G4double DriftCluster(G4LorentzVector& xyzt, G4double& transv_sigma);
+
+    G4LorentzVector GeneratePointAlongDriftLine(const G4LorentzVector&,
+                                                const G4LorentzVector&);
+
+    /// Interpolate trilinearly (bilinearly for (r, z) maps) the
+    /// values of the map at a position
+    void Interpolate(const G4ThreeVector&, G4double values[kNumValues]) const;
+
+    G4double GetAnodePosition() const;
+    G4double GetCathodePosition() const;
+
+  private:
+    /// Returns true if the z coordinate is between anode and cathode
+    G4bool CheckCoordinate(G4double) const;
+
+    /// Drift to the anode, with or without the transverse
+    /// diffusion, whose sigma is returned
+    G4double DriftCarrier(G4LorentzVector& xyzt, G4bool transv_diffusion,
+                          G4double& transv_sigma);
+
+  private:
+    G4int dimensions_;
+    G4int num_nodes_[3];
+    G4double min_[3];
+    G4double pitch_[3];
+
+    G4double anode_pos_;
+    G4double cathode_pos_;
+
+    std::vector<float> values_; ///< kNumValues values per node
+
+    SegmentPointSampler* rnd_;
+  };
+
+  inline G4double FieldMapDriftField::GetAnodePosition() const
+  { return anode_pos_; }
+
+  inline G4double FieldMapDriftField::GetCathodePosition() const
+  { return cathode_pos_; }
+
+} // end namespace nexus
+
+#endif
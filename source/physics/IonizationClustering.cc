@@ -9,6 +9,7 @@
 #include "IonizationClustering.h"
 
 #include "BaseDriftField.h"
+#include "ClusterDiffusion.h"
 #include "IonizationElectron.h"
 #include "SegmentPointSampler.h"
 
@@ -18,9 +19,14 @@
 #include <Randomize.hh>
 #include <G4LorentzVector.hh>
 #include <G4Gamma.hh>
+#include <G4Material.hh>
+#include <G4MaterialPropertiesTable.hh>
+#include <G4GenericMessenger.hh>
 
 #include "CLHEP/Units/SystemOfUnits.h"
 
+#include <algorithm>
+
 
 namespace nexus {
 
@@ -29,20 +35,41 @@ namespace nexus {
 
   IonizationClustering::IonizationClustering(const G4String& process_name,
                                              G4ProcessType type):
-    G4VRestDiscreteProcess(process_name, type), ParticleChange_(0), rnd_(0)
+    G4VRestDiscreteProcess(process_name, type), ParticleChange_(0), rnd_(0),
+    cluster_size_(1), max_clusters_(0)
   {
     // Create particle change object
     ParticleChange_ = new G4ParticleChange();
     pParticleChange = ParticleChange_;
+    // The weights of the ionization electrons are their cluster sizes,
+    // not the weight of the ionizing particle
+    ParticleChange_->SetSecondaryWeightByProcess(true);
 
     // Create a segment point sample
     rnd_ = new SegmentPointSampler();
+
+    msg_ = new G4GenericMessenger(this, "/Physics/IonizationClustering/",
+      "Control commands of the ionization clustering process.");
+
+    G4GenericMessenger::Command& size_cmd =
+      msg_->DeclareProperty("cluster_size", cluster_size_,
+                            "Number of ionization electrons carried by each track.");
+    size_cmd.SetParameterName("cluster_size", false);
+    size_cmd.SetRange("cluster_size>0");
+
+    G4GenericMessenger::Command& max_cmd =
+      msg_->DeclareProperty("max_clusters_per_step", max_clusters_,
+                            "Maximum number of ionization electron tracks "
+                            "created per step (0 = no limit).");
+    max_cmd.SetParameterName("max_clusters_per_step", false);
+    max_cmd.SetRange("max_clusters_per_step>=0");
   }
 
 
 
   IonizationClustering::~IonizationClustering()
   {
+    delete msg_;
     delete rnd_;
     delete ParticleChange_;
   }
@@ -62,6 +89,28 @@ namespace nexus {
 
 
 
+  void IonizationClustering::BuildPhysicsTable(const G4ParticleDefinition&)
+  {
+    fields_.Build();
+
+    // Materials without these properties take the values of xenon gas
+    const G4MaterialTable* materials = G4Material::GetMaterialTable();
+    ioni_energy_.assign(materials->size(), 22.4 * eV);
+    fano_factor_.assign(materials->size(), .15);
+
+    for (size_t i=0; i<materials->size(); ++i) {
+      G4MaterialPropertiesTable* mpt = (*materials)[i]->GetMaterialPropertiesTable();
+      if (!mpt) continue;
+      size_t index = (*materials)[i]->GetIndex();
+      if (mpt->ConstPropertyExists("IONIZATIONENERGY"))
+        ioni_energy_[index] = mpt->GetConstProperty("IONIZATIONENERGY");
+      if (mpt->ConstPropertyExists("FANOFACTOR"))
+        fano_factor_[index] = mpt->GetConstProperty("FANOFACTOR");
+    }
+  }
+
+
+
   G4VParticleChange*
   IonizationClustering::AtRestDoIt(const G4Track& track, const G4Step& step)
   {
@@ -95,8 +144,7 @@ namespace nexus {
 
     G4Region* region = track.GetVolume()->GetLogicalVolume()->GetRegion();
 
-    BaseDriftField* field =
-      dynamic_cast<BaseDriftField*>(region->GetUserInformation());
+    BaseDriftField* field = fields_.GetField(region);
 
     if (!field) return G4VRestDiscreteProcess::PostStepDoIt(track, step);
 
@@ -108,16 +156,13 @@ namespace nexus {
     // sub-Poissonian: \sigma^2 = F N, where F is the so-called Fano factor
     // and N is the average number of charges.
 
-    // Fetch the W_i and F from the material properties table
-    //G4MaterialPropertiesTable* mpt =
-    //  track.GetMaterial()->GetMaterialPropertiesTable();
-    //if (!mpt)
-    //  return G4VRestDiscreteProcess::PostStepDoIt(track, step);
+    // Fetch the W_i and F of the material, read from
+    // its properties table when the physics table was built
+    size_t index = track.GetMaterial()->GetIndex();
+    if (index >= ioni_energy_.size()) BuildPhysicsTable(*track.GetDefinition());
 
-    //G4double ioni_energy = mpt->GetConstProperty("IONIZATIONENERGY");
-    //G4double fano_factor = mpt->GetConstProperty("FANOFACTOR");
-    G4double ioni_energy = 22.4 * eV;
-    G4double fano_factor = .15;
+    G4double ioni_energy = ioni_energy_[index];
+    G4double fano_factor = fano_factor_[index];
 
     G4double mean = energy_dep / ioni_energy;
 
@@ -131,10 +176,18 @@ namespace nexus {
       num_charges = G4int(G4Poisson(mean));
     }
 
-    ParticleChange_->SetNumberOfSecondaries(num_charges);
+    // The charges are grouped in clusters, each one tracked as a single
+    // ionization electron whose weight is its number of charges
+    G4int cluster_size = cluster_size_;
+    if (max_clusters_ > 0)
+      cluster_size = std::max(cluster_size, (num_charges + max_clusters_ - 1) / max_clusters_);
+
+    G4int num_clusters = (num_charges + cluster_size - 1) / cluster_size;
+
+    ParticleChange_->SetNumberOfSecondaries(num_clusters);
 
     // Track secondaries first
-    if ((track.GetTrackStatus() == fAlive) && num_charges > 0)
+    if ((track.GetTrackStatus() == fAlive) && num_clusters > 0)
       ParticleChange_->ProposeTrackStatus(fSuspend);
 
     //////////////////////////////////////////////////////////////////
@@ -150,7 +203,7 @@ namespace nexus {
     rnd_->SetPoints(pre_point, post_point);
 
 
-    for (G4int i=0; i<num_charges; i++) {
+    for (G4int i=0; i<num_clusters; i++) {
 
       G4DynamicParticle* ionielectron =
         new G4DynamicParticle(IonizationElectron::Definition(),
@@ -169,6 +222,12 @@ namespace nexus {
       aSecondaryTrack->
         SetTouchableHandle(step.GetPreStepPoint()->GetTouchableHandle());
 
+      // The electrons of a cluster diffuse around its drift line
+      if (cluster_size > 1) {
+        aSecondaryTrack->SetWeight(std::min(cluster_size, num_charges - i*cluster_size));
+        aSecondaryTrack->SetUserInformation(new ClusterDiffusion());
+      }
+
       ParticleChange_->AddSecondary(aSecondaryTrack);
     }
 
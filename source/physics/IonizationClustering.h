@@ -11,6 +11,12 @@
 
 #include <G4VRestDiscreteProcess.hh>
 
+#include "DriftFieldCache.h"
+
+#include <vector>
+
+class G4GenericMessenger;
+
 
 namespace nexus {
 
@@ -35,6 +41,10 @@ namespace nexus {
     /// in the standard electromagnetic version of the process.
     G4bool IsApplicable(const G4ParticleDefinition&);
 
+    /// Cache the drift field of each region and the
+    /// ionization energy and Fano factor of each material
+    void BuildPhysicsTable(const G4ParticleDefinition&);
+
     /// Implements the clusterization for energy depositions of
     /// particles in flight
     G4VParticleChange* PostStepDoIt(const G4Track&, const G4Step&);
@@ -58,6 +68,15 @@ namespace nexus {
   private:
     G4ParticleChange* ParticleChange_;
     SegmentPointSampler* rnd_;
+    DriftFieldCache fields_; ///< Drift field of each region
+
+    std::vector<G4double> ioni_energy_; ///< Ionization energy of each material
+    std::vector<G4double> fano_factor_; ///< Fano factor of each material
+
+    G4int cluster_size_; ///< Ionization electrons per track
+    G4int max_clusters_; ///< Maximum number of tracks per step (0 = no limit)
+
+    G4GenericMessenger* msg_;
   };
 
 } // end namespace nexus
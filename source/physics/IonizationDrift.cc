@@ -11,19 +11,23 @@
 
 #include "IonizationElectron.h"
 #include "BaseDriftField.h"
+#include "ClusterDiffusion.h"
 
 #include <G4ParticleChangeForTransport.hh>
 #include <G4RegionStore.hh>
 #include <G4TransportationManager.hh>
 #include <G4TouchableHandle.hh>
 #include <G4Navigator.hh>
+#include <G4Material.hh>
+#include <G4MaterialPropertiesTable.hh>
+#include <Randomize.hh>
 
 
 namespace nexus {
 
 
   IonizationDrift::IonizationDrift(const G4String& name, G4ProcessType type):
-    G4VContinuousDiscreteProcess(name, type)
+    G4VContinuousDiscreteProcess(name, type), transv_sigma_(0.)
   {
     ParticleChange_ = new G4ParticleChangeForTransport();
     pParticleChange = ParticleChange_;
@@ -44,6 +48,22 @@ namespace nexus {
   {
     return ((pdef == *IonizationElectron::Definition())); 
   }
+
+
+
+  void IonizationDrift::BuildPhysicsTable(const G4ParticleDefinition&)
+  {
+    fields_.Build();
+
+    const G4MaterialTable* materials = G4Material::GetMaterialTable();
+    attachment_.assign(materials->size(), -1.);
+
+    for (size_t i=0; i<materials->size(); ++i) {
+      G4MaterialPropertiesTable* mpt = (*materials)[i]->GetMaterialPropertiesTable();
+      if (mpt && mpt->ConstPropertyExists("ATTACHMENT"))
+        attachment_[(*materials)[i]->GetIndex()] = mpt->GetConstProperty("ATTACHMENT");
+    }
+  }
   
   
   
@@ -55,16 +75,20 @@ namespace nexus {
     G4Region* region = track.GetVolume()->GetLogicalVolume()->GetRegion();
     
     // Get the drift field attached to this region
-    BaseDriftField* field = 
-      dynamic_cast<BaseDriftField*>(region->GetUserInformation());
+    BaseDriftField* field = fields_.GetField(region);
 
     // If the region has no field, the particle won't move 
     // and therefore the step length is zero.
     if (!field) return step_length;
 
-    // Get displacement from current position due to drift field
+    // Get displacement from current position due to drift field.
+    // Clusters follow the mean drift line, and the diffusion of their
+    // electrons is kept to spread them where they produce EL light.
     xyzt_.set(track.GetGlobalTime(), track.GetPosition());
-    step_length = field->Drift(xyzt_);
+    if (dynamic_cast<ClusterDiffusion*>(track.GetUserInformation()))
+      step_length = field->DriftCluster(xyzt_, transv_sigma_);
+    else
+      step_length = field->Drift(xyzt_);
     
     return step_length;
   }
@@ -82,20 +106,37 @@ namespace nexus {
 
       // Simulate attachment by impurities
       
-      G4MaterialPropertiesTable* mpt = 
-        track.GetMaterial()->GetMaterialPropertiesTable();
+      size_t index = track.GetMaterial()->GetIndex();
+      G4double attach = (index < attachment_.size()) ? attachment_[index] : -1.;
 
-      if (!mpt || !(mpt->ConstPropertyExists("ATTACHMENT"))) { 
+      if (attach < 0.) { 
         G4Exception("[IonizationDrift]", "AlongStepDoIt()", JustWarning,
           "No material properties table found. Assuming no attachment.");
       }
+      else if (track.GetWeight() > 1.) {
+        // Each electron of a cluster is attached independently, with the
+        // same probability as a single one. Weights above 1 only come
+        // from clusters: the weights of the primary vertices are assumed
+        // to be at most 1, and IonizationClustering does not pass them on.
+        G4double survival = exp(-xyzt_.t() / attach);
+        G4int survivors =
+          G4int(CLHEP::RandBinomial::shoot(G4int(track.GetWeight() + .5), survival));
+        if (survivors == 0)
+          ParticleChange_->ProposeTrackStatus(fStopAndKill);
+        else
+          ParticleChange_->ProposeWeight(survivors);
+      }
       else {
-        const G4double attach = mpt->GetConstProperty("ATTACHMENT");
         G4double rnd = -attach * log(G4UniformRand());
         if (xyzt_.t() > rnd) 
           ParticleChange_->ProposeTrackStatus(fStopAndKill);
       }
 
+      ClusterDiffusion* diffusion =
+        dynamic_cast<ClusterDiffusion*>(track.GetUserInformation());
+      if (diffusion)
+        diffusion->AddDrift(transv_sigma_, xyzt_.vect() - track.GetPosition());
+
       ParticleChange_->ProposeGlobalTime(xyzt_.t());
       ParticleChange_->ProposePosition(xyzt_.vect());
     }
@@ -13,6 +13,10 @@
 #include <G4VContinuousDiscreteProcess.hh>
 
 
+#include "DriftFieldCache.h"
+
+#include <vector>
+
 class G4Navigator;
 class G4ParticleChangeForTransport;
 
@@ -31,6 +35,10 @@ namespace nexus {
     /// The process is applicable only to ionization electrons
     G4bool IsApplicable(const G4ParticleDefinition&);
 
+    /// Cache the drift field of each region and the
+    /// attachment of each material
+    void BuildPhysicsTable(const G4ParticleDefinition&);
+
     G4VParticleChange* AlongStepDoIt(const G4Track&, const G4Step&);
     
     G4VParticleChange* PostStepDoIt(const G4Track&, const G4Step&);
@@ -48,8 +56,13 @@ namespace nexus {
     
   private:
     G4LorentzVector xyzt_;
+    G4double transv_sigma_; ///< Transverse diffusion of the electrons of a cluster
     G4ParticleChangeForTransport* ParticleChange_;
     G4Navigator* nav_; ///< Pointer to the G4 navigator for tracking
+
+    DriftFieldCache fields_; ///< Drift field of each region
+    /// Attachment of each material, by index (negative if not defined)
+    std::vector<G4double> attachment_;
   };
 
 } // end namespace nexus
@@ -43,6 +43,26 @@ namespace nexus {
 
   G4double UniformElectricDriftField::Drift(G4LorentzVector& xyzt)
   {
+    G4double transv_sigma;
+    return DriftCarrier(xyzt, true, transv_sigma);
+  }
+
+
+
+  G4double UniformElectricDriftField::DriftCluster(G4LorentzVector& xyzt,
+                                                   G4double& transv_sigma)
+  {
+    return DriftCarrier(xyzt, false, transv_sigma);
+  }
+
+
+
+  G4double UniformElectricDriftField::DriftCarrier(G4LorentzVector& xyzt,
+                                                   G4bool transv_diffusion,
+                                                   G4double& transv_sigma)
+  {
+    transv_sigma = 0.;
+
     // If the origin is not between anode and cathode,
     // the charge carrier, obviously, doesn't move.
     if (!CheckCoordinate(xyzt[axis_]))
@@ -57,7 +77,7 @@ namespace nexus {
     G4double drift_time = drift_length / drift_velocity_;
 
     // Calculate longitudinal and transversal deviation due to diffusion
-    G4double transv_sigma = transv_diff_ * sqrt(drift_length);
+    transv_sigma = transv_diff_ * sqrt(drift_length);
     G4double longit_sigma = longit_diff_ * sqrt(drift_length);
     G4double time_sigma = longit_sigma / drift_velocity_;
 
@@ -66,7 +86,8 @@ namespace nexus {
 
     for (G4int i=0; i<3; i++) {
       if (i != axis_)  {     // Transverse coordinate
-        position[i] = G4RandGauss::shoot(xyzt[i], transv_sigma);
+        position[i] = transv_diffusion ?
+          G4RandGauss::shoot(xyzt[i], transv_sigma) : xyzt[i];
       }
       else { // Longitudinal coordinate
         position[i] = anode_pos_ + secmargin;
@@ -36,10 +36,15 @@ namespace nexus {
     /// of an ionization electron
     G4double Drift(G4LorentzVector& xyzt);
 
+    /// Drift a cluster of ionization electrons along its mean drift line
+    G4double DriftCluster(G4LorentzVector& xyzt, G4double& transv_sigma);
+
     G4LorentzVector GeneratePointAlongDriftLine(const G4LorentzVector&, const G4LorentzVector&);
 
     // Setters/getters
 
+    EAxis GetAxis() const;
+
     void SetAnodePosition(G4double);
     G4double GetAnodePosition() const;
 
@@ -68,6 +73,11 @@ namespace nexus {
     /// Returns true if coordinate is between anode and cathode
     G4bool CheckCoordinate(G4double);
 
+    /// Drift to the anode, with or without the transverse
+    /// diffusion, whose sigma is returned
+    G4double DriftCarrier(G4LorentzVector& xyzt, G4bool transv_diffusion,
+                          G4double& transv_sigma);
+
 
 
   private:
@@ -91,6 +101,9 @@ namespace nexus {
 
   // inline methods ..................................................
 
+  inline EAxis UniformElectricDriftField::GetAxis() const
+  { return axis_; }
+
   inline void UniformElectricDriftField::SetAnodePosition(G4double p)
   { anode_pos_ = p; }
 
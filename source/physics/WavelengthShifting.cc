@@ -140,6 +140,8 @@ namespace nexus {
      new G4Track(aWLSPhoton,aSecondaryTime,aSecondaryPosition);
    aSecondaryTrack->SetTouchableHandle(track.GetTouchableHandle());
    aSecondaryTrack->SetParentID(track.GetTrackID());
+   // Re-emitted photon bunches keep their number of photons
+   aSecondaryTrack->SetWeight(track.GetWeight());
    ParticleChange_->AddSecondary(aSecondaryTrack);
 
    return G4VDiscreteProcess::PostStepDoIt(track, step);
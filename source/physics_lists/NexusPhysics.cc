@@ -14,6 +14,10 @@
 #include "Electroluminescence.h"
 #include "WavelengthShifting.h"
 #include "OpPhotoelectricEffect.h"
+#include "ELLookupTable.h"
+#include "ELParamSimulation.h"
+#include "AnalyticDriftEL.h"
+#include "FieldMapDriftField.h"
 
 #include <G4GenericMessenger.hh>
 #include <G4OpticalPhoton.hh>
@@ -22,6 +26,10 @@
 #include <G4StepLimiter.hh>
 #include <G4FastSimulationManagerProcess.hh>
 #include <G4PhysicsConstructorFactory.hh>
+#include <G4RegionStore.hh>
+#include <G4Region.hh>
+
+#include <sstream>
 
 
 namespace nexus {
@@ -34,7 +42,9 @@ namespace nexus {
 
   NexusPhysics::NexusPhysics():
     G4VPhysicsConstructor("NexusPhysics"),
-    clustering_(true), drift_(true), electroluminescence_(true), photoelectric_(false)
+    clustering_(true), drift_(true), electroluminescence_(true), photoelectric_(false),
+    el_fast_simulation_(false), el_table_(""), el_table_binning_(200.*ns),
+    el_fast_sim_yield_(0.), analytic_drift_(false)
   {
     msg_ = new G4GenericMessenger(this, "/PhysicsList/Nexus/",
       "Control commands of the nexus physics list.");
@@ -51,6 +61,31 @@ namespace nexus {
     msg_->DeclareProperty("photoelectric", photoelectric_,
       "Switch on/off the photoelectric effect.");
 
+    msg_->DeclareProperty("el_fast_simulation", el_fast_simulation_,
+      "Replace the tracking of EL photons by a look-up table.");
+
+    msg_->DeclareProperty("el_table", el_table_,
+      "File with the EL look-up table.");
+
+    G4GenericMessenger::Command& binning_cmd =
+      msg_->DeclarePropertyWithUnit("el_table_time_binning", "ns", el_table_binning_,
+                                    "Width of the time bins of the EL look-up table.");
+    binning_cmd.SetParameterName("el_table_time_binning", false);
+    binning_cmd.SetRange("el_table_time_binning>0.");
+
+    G4GenericMessenger::Command& yield_cmd =
+      msg_->DeclareProperty("el_fast_simulation_yield", el_fast_sim_yield_,
+                            "Mean number of EL photons per ionization electron "
+                            "(0 = computed from the EL field).");
+    yield_cmd.SetParameterName("el_fast_simulation_yield", false);
+    yield_cmd.SetRange("el_fast_simulation_yield>=0.");
+
+    msg_->DeclareProperty("analytic_drift", analytic_drift_,
+      "Drift the ionization electrons in uniform fields and across "
+      "the EL gap in a single step.");
+
+    msg_->DeclareMethod("drift_field_map", &NexusPhysics::SetDriftFieldMap,
+      "Replace the drift field of a region by a field map, as '<region> <file>'.");
   }
 
 
@@ -71,8 +106,48 @@ namespace nexus {
 
 
 
+  void NexusPhysics::SetDriftFieldMap(G4String args)
+  {
+    std::istringstream iss(args);
+    G4String region, filename;
+    iss >> region >> filename;
+
+    if (iss.fail()) {
+      G4Exception("[NexusPhysics]", "SetDriftFieldMap()", FatalException,
+                  "Usage: drift_field_map <region> <file>.");
+    }
+
+    drift_field_maps_.push_back(std::make_pair(region, filename));
+  }
+
+
+
+  void NexusPhysics::AttachDriftFieldMaps()
+  {
+    // The geometry, and therefore the regions, are
+    // constructed before the physics processes
+    for (size_t i=0; i<drift_field_maps_.size(); ++i) {
+      G4Region* region =
+        G4RegionStore::GetInstance()->GetRegion(drift_field_maps_[i].first, false);
+      if (!region) {
+        G4Exception("[NexusPhysics]", "AttachDriftFieldMaps()", FatalException,
+          ("Drift field map for unknown region " + drift_field_maps_[i].first).c_str());
+      }
+
+      // The map is owned here and lives as long as the physics. The
+      // field it replaces is still owned by the geometry that created
+      // it, which may use it elsewhere, so it is not deleted.
+      field_maps_.emplace_back(new FieldMapDriftField(drift_field_maps_[i].second));
+      region->SetUserInformation(field_maps_.back().get());
+    }
+  }
+
+
+
   void NexusPhysics::ConstructProcess()
   {
+    AttachDriftFieldMaps();
+
     G4ProcessManager* pmanager = 0;
 
     // Add our own wavelength shifting process for the optical photon
@@ -104,11 +179,46 @@ namespace nexus {
       pmanager->AddDiscreteProcess(drift);
     }
 
+    Electroluminescence* el = 0;
     if (electroluminescence_) {
-      Electroluminescence* el = new Electroluminescence();
+      el = new Electroluminescence();
       pmanager->AddDiscreteProcess(el);
     }
 
+    // Replace the electroluminescence in the EL region
+    // by its parametrization
+
+    ELParamSimulation* el_param = 0;
+    if (el_fast_simulation_) {
+      G4Region* el_region =
+        G4RegionStore::GetInstance()->GetRegion("EL_REGION", false);
+      if (!el_region) {
+        G4Exception("[NexusPhysics]", "ConstructProcess()", FatalException,
+          "EL fast simulation requested, but the geometry has no EL region.");
+      }
+      if (el_table_ == "") {
+        G4Exception("[NexusPhysics]", "ConstructProcess()", FatalException,
+          "EL fast simulation requested without an EL look-up table.");
+      }
+
+      el_param = new ELParamSimulation(el_region, new ELLookupTable(el_table_),
+                                       el_table_binning_, el_fast_sim_yield_);
+
+      G4FastSimulationManagerProcess* fastsim =
+        new G4FastSimulationManagerProcess("ELFastSimulation");
+      pmanager->AddDiscreteProcess(fastsim);
+    }
+
+    // Drift and EL light of the ie- in uniform fields computed
+    // in a single step, in place of the processes above
+
+    if (analytic_drift_) {
+      AnalyticDriftEL* analytic = new AnalyticDriftEL();
+      analytic->SetElectroluminescence(el);
+      analytic->SetELParametrization(el_param);
+      pmanager->AddDiscreteProcess(analytic);
+    }
+
 
     // Add clustering to all pertinent particles
 
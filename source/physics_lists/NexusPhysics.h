@@ -11,11 +11,17 @@
 
 #include <G4VPhysicsConstructor.hh>
 
+#include <memory>
+#include <vector>
+#include <utility>
+
 class G4GenericMessenger;
 
 
 namespace nexus {
 
+  class FieldMapDriftField;
+
   class NexusPhysics: public G4VPhysicsConstructor
   {
   public:
@@ -29,12 +35,30 @@ namespace nexus {
     /// Construct all required physics processes (Geant4 mandatory method)
     virtual void ConstructProcess();
 
+  private:
+    /// Attach a drift field map to a region, as '<region> <file>'
+    void SetDriftFieldMap(G4String args);
+    /// Replace the drift fields of the regions by their maps
+    void AttachDriftFieldMaps();
+
   private:
     G4bool clustering_;          ///< Switch on/of the ionization clustering
     G4bool drift_;               ///< Switch on/of the ionization drift
     G4bool electroluminescence_; ///< Switch on/off the electroluminescence
     G4bool photoelectric_;       ///< Switch on/off the photoelectric effect
 
+    G4bool el_fast_simulation_;   ///< Switch on/off the EL parametrization
+    G4String el_table_;           ///< File with the EL look-up table
+    G4double el_table_binning_;   ///< Width of the time bins of the table
+    G4double el_fast_sim_yield_;  ///< EL photons per ie- (0 = from field)
+
+    G4bool analytic_drift_; ///< Switch on/off the single-step drift and EL
+
+    /// Region names and files of the drift field maps
+    std::vector<std::pair<G4String, G4String> > drift_field_maps_;
+    /// Drift field maps attached to the regions, owned by this class
+    std::vector<std::unique_ptr<FieldMapDriftField> > field_maps_;
+
     G4GenericMessenger* msg_;
   };
 
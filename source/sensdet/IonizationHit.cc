@@ -13,7 +13,15 @@
 namespace nexus {
 
 
-  G4Allocator<IonizationHit> IonizationHitAllocator;
+  namespace {
+    /// Number of hits per block of the arena
+    const size_t hits_per_block = 16384;
+  }
+
+  thread_local std::vector<char*> IonizationHitArena::blocks_;
+  thread_local size_t IonizationHitArena::block_  = 0;
+  thread_local size_t IonizationHitArena::offset_ = 0;
+  thread_local size_t IonizationHitArena::live_   = 0;
 
 
 
@@ -54,4 +62,47 @@ namespace nexus {
   }
 
 
+
+  void* IonizationHitArena::Allocate()
+  {
+    if (blocks_.empty() || offset_ == hits_per_block) {
+      if (!blocks_.empty()) block_++;
+      if (block_ == blocks_.size()) NewBlock();
+      offset_ = 0;
+    }
+
+    void* hit = blocks_[block_] + offset_ * sizeof(IonizationHit);
+    offset_++;
+    live_++;
+    return hit;
+  }
+
+
+
+  void IonizationHitArena::Release(void*)
+  {
+    // The memory of single hits is not reused: the blocks are
+    // recycled at once when no hit is left
+    if (--live_ == 0) {
+      block_  = 0;
+      offset_ = 0;
+    }
+  }
+
+
+
+  size_t IonizationHitArena::GetNumberOfHits()
+  {
+    return live_;
+  }
+
+
+
+  void IonizationHitArena::NewBlock()
+  {
+    // operator new returns memory suitably aligned for any object
+    blocks_.push_back(static_cast<char*>(::operator new(hits_per_block * sizeof(IonizationHit))));
+  }
+
+
 } // end namespace nexus
@@ -12,9 +12,10 @@
 
 #include <G4VHit.hh>
 #include <G4THitsCollection.hh>
-#include <G4Allocator.hh>
 #include <G4ThreeVector.hh>
 
+#include <vector>
+
 
 namespace nexus {
 
@@ -61,16 +62,43 @@ namespace nexus {
 
 
   typedef G4THitsCollection<IonizationHit> IonizationHitsCollection;
-  extern G4Allocator<IonizationHit> IonizationHitAllocator;
+
+
+  /// Memory pool for the ionization hits. Hits are taken consecutively
+  /// from large blocks and are not freed one by one: the whole pool is
+  /// reset once all the hits in use (i.e., those of the event) are deleted.
+  /// Each thread has its own pool, so a hit must be deleted in the
+  /// thread that created it, as the hits of an event are.
+
+  class IonizationHitArena
+  {
+  public:
+    static void* Allocate();
+    static void Release(void*);
+
+    /// Number of hits currently in use
+    static size_t GetNumberOfHits();
+
+  private:
+    IonizationHitArena();
+
+    static void NewBlock();
+
+  private:
+    static thread_local std::vector<char*> blocks_; ///< Memory blocks, kept between events
+    static thread_local size_t block_;  ///< Block being filled
+    static thread_local size_t offset_; ///< Hits taken from the current block
+    static thread_local size_t live_;   ///< Hits in use
+  };
 
 
   // INLINE DEFINITIONS //////////////////////////////////////////////
 
   inline void* IonizationHit::operator new(size_t)
-  { return ((void*) IonizationHitAllocator.MallocSingle()); }
+  { return IonizationHitArena::Allocate(); }
 
   inline void IonizationHit::operator delete(void* aHit)
-  { IonizationHitAllocator.FreeSingle((IonizationHit*) aHit); }
+  { IonizationHitArena::Release(aHit); }
 
   inline G4int IonizationHit::GetTrackID() { return track_id_; }
   inline void IonizationHit::SetTrackID(G4int id) { track_id_ = id; }
@@ -24,7 +24,7 @@ using namespace nexus;
 
 
 IonizationSD::IonizationSD(const G4String& name):
-  G4VSensitiveDetector(name), include_(true)
+  G4VSensitiveDetector(name), include_(true), trj_track_id_(0), trj_(0)
 {
   collectionName.insert(GetCollectionUniqueName());
 }
@@ -57,6 +57,9 @@ void IonizationSD::Initialize(G4HCofThisEvent* hce)
     G4SDManager::GetSDMpointer()->GetCollectionID(SensitiveDetectorName+"/"+collectionName[0]);
   hce->AddHitsCollection(hcid, IHC_);
 
+  // Track IDs start again in every event
+  trj_track_id_ = 0;
+  trj_ = 0;
 }
 
 
@@ -74,10 +77,12 @@ G4bool IonizationSD::ProcessHits(G4Step* step, G4TouchableHistory*)
   // Discard steps where no energy was deposited in the detector
   if (edep <= 0.) return false;
 
+  G4int track_id = track->GetTrackID();
+
   // Create a hit and set its properties
   IonizationHit* hit = new IonizationHit();
-  hit->SetTrackID(step->GetTrack()->GetTrackID());
-  hit->SetTime(step->GetTrack()->GetGlobalTime());
+  hit->SetTrackID(track_id);
+  hit->SetTime(track->GetGlobalTime());
   hit->SetEnergyDeposit(edep);
   hit->SetPosition(step->GetPostStepPoint()->GetPosition());
 
@@ -87,8 +92,13 @@ G4bool IonizationSD::ProcessHits(G4Step* step, G4TouchableHistory*)
   // Add energy deposit to the trajectory associated
   // to the current track
   if (include_) {
-    Trajectory* trj =
-      (Trajectory*) TrajectoryMap::Get(step->GetTrack()->GetTrackID());
+    // Consecutive steps usually belong to the same track,
+    // so the trajectory is only looked up when the track changes
+    if (track_id != trj_track_id_) {
+      trj_ = TrajectoryMap::Get(track_id);
+      trj_track_id_ = track_id;
+    }
+    Trajectory* trj = (Trajectory*) trj_;
     if (trj) {
       edep += trj->GetEnergyDeposit();
       trj->SetEnergyDeposit(edep);
@@ -15,6 +15,7 @@
 class G4Step;
 class G4HCofThisEvent;
 class G4TouchableHistory;
+class G4VTrajectory;
 
 
 namespace nexus {
@@ -50,6 +51,9 @@ namespace nexus {
     IonizationHitsCollection* IHC_;
     G4String det_name_;
     G4bool include_;
+
+    G4int trj_track_id_; ///< Track of the cached trajectory (0 if none)
+    G4VTrajectory* trj_; ///< Trajectory of the last track with a hit
   };
 
   inline void IonizationSD::IncludeInTotalEnergyDeposit(G4bool inc)
@@ -9,22 +9,40 @@
 #include "PmtHit.h"
 
 
+#include <algorithm>
+
+
 using namespace nexus;
 
 
 G4Allocator<PmtHit> PmtHitAllocator;
 
 
+namespace {
+
+  // A dense vector of 32-bit counts takes less memory than the sparse
+  // layout, with 16 bytes per bin, once a quarter of its bins are filled
+  const size_t dense_occupancy = 4;
+  // Waveforms with fewer bins than this are always kept sparse
+  const size_t min_dense_bins = 16;
+
+}
+
+
 
 PmtHit::PmtHit():
-  G4VHit(), pmt_id_(-1.), bin_size_(0.)
+  G4VHit(), pmt_id_(-1.), bin_size_(0.),
+  is_dense_(false), last_(0), first_bin_(0), nonzero_(0),
+  histogram_valid_(false)
 {
 }
 
 
 
 PmtHit::PmtHit(G4int id, const G4ThreeVector& position, G4double bin_size):
-  G4VHit(), pmt_id_(id),  bin_size_(bin_size), position_(position)
+  G4VHit(), pmt_id_(id),  bin_size_(bin_size), position_(position),
+  is_dense_(false), last_(0), first_bin_(0), nonzero_(0),
+  histogram_valid_(false)
 {
 }
 
@@ -48,7 +66,13 @@ const PmtHit& PmtHit::operator=(const PmtHit& other)
   pmt_id_    = other.pmt_id_;
   bin_size_  = other.bin_size_;
   position_  = other.position_;
-  histogram_ = other.histogram_;
+  is_dense_  = other.is_dense_;
+  sparse_    = other.sparse_;
+  last_      = other.last_;
+  dense_     = other.dense_;
+  first_bin_ = other.first_bin_;
+  nonzero_   = other.nonzero_;
+  histogram_valid_ = false;
 
   return *this;
 }
@@ -64,7 +88,7 @@ G4int PmtHit::operator==(const PmtHit& other) const
 
 void PmtHit::SetBinSize(G4double bin_size)
 {
-  if (histogram_.size() == 0) {
+  if (sparse_.empty() && dense_.empty()) {
     bin_size_ = bin_size;
   }
   else {
@@ -75,8 +99,103 @@ void PmtHit::SetBinSize(G4double bin_size)
 
 
 
-void PmtHit::Fill(G4double time, G4int counts)
+const std::map<G4double, G4int>& PmtHit::GetHistogram() const
+{
+  if (!histogram_valid_) {
+    histogram_.clear();
+    std::map<G4double, G4int>& histogram = histogram_;
+    G4double bin_size = bin_size_;
+    ForEachBin([&histogram, bin_size](G4long bin, G4int counts)
+               { histogram.insert(histogram.end(),
+                                  std::make_pair(bin * bin_size, counts)); });
+    histogram_valid_ = true;
+  }
+  return histogram_;
+}
+
+
+
+void PmtHit::FillSparse(G4long bin, G4int counts)
+{
+  // Photons arrive in bursts, so consecutive ones often share the bin
+  if (last_ < sparse_.size() && sparse_[last_].first == bin) {
+    sparse_[last_].second += counts;
+    return;
+  }
+
+  std::vector< std::pair<G4long, uint32_t> >::iterator it =
+    std::lower_bound(sparse_.begin(), sparse_.end(),
+                     std::make_pair(bin, (uint32_t) 0));
+
+  if (it != sparse_.end() && it->first == bin) {
+    it->second += counts;
+    last_ = it - sparse_.begin();
+    return;
+  }
+
+  last_ = sparse_.insert(it, std::make_pair(bin, (uint32_t) counts)) - sparse_.begin();
+
+  size_t span = sparse_.back().first - sparse_.front().first + 1;
+  if (sparse_.size() >= min_dense_bins &&
+      span <= dense_occupancy * sparse_.size())
+    MakeDense();
+}
+
+
+
+void PmtHit::FillDenseOutside(G4long bin, G4int counts)
+{
+  G4long last_bin = first_bin_ + (G4long) dense_.size() - 1;
+  size_t span = std::max(last_bin, bin) - std::min(first_bin_, bin) + 1;
+
+  // A far outlier would leave most of the bins empty
+  if (span > dense_occupancy * (nonzero_ + 1)) {
+    MakeSparse();
+    FillSparse(bin, counts);
+    return;
+  }
+
+  if (bin > last_bin) {
+    dense_.resize(bin - first_bin_ + 1, 0);
+  }
+  else {
+    // Some room is left before the new first bin, so that
+    // earlier photons do not shift the vector every time
+    size_t extra = std::min((size_t) (first_bin_ - bin) + dense_.size()/2,
+                            dense_occupancy * (nonzero_ + 1) - span);
+    dense_.insert(dense_.begin(), first_bin_ - bin + extra, 0);
+    first_bin_ = bin - (G4long) extra;
+  }
+
+  dense_[bin - first_bin_] += counts;
+  nonzero_++;
+}
+
+
+
+void PmtHit::MakeDense()
+{
+  first_bin_ = sparse_.front().first;
+  dense_.assign(sparse_.back().first - first_bin_ + 1, 0);
+  for (size_t i=0; i<sparse_.size(); ++i)
+    dense_[sparse_[i].first - first_bin_] = sparse_[i].second;
+  nonzero_ = sparse_.size();
+
+  sparse_.clear();
+  last_ = 0;
+  is_dense_ = true;
+}
+
+
+
+void PmtHit::MakeSparse()
 {
-  G4double time_bin = floor(time/bin_size_) * bin_size_;
-  histogram_[time_bin] += counts;
+  sparse_.clear();
+  for (size_t i=0; i<dense_.size(); ++i)
+    if (dense_[i]) sparse_.push_back(std::make_pair(first_bin_ + (G4long) i, dense_[i]));
+
+  dense_.clear();
+  nonzero_ = 0;
+  last_ = 0;
+  is_dense_ = false;
 }
@@ -14,6 +14,11 @@
 #include <G4Allocator.hh>
 #include <G4ThreeVector.hh>
 
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <vector>
+
 
 namespace nexus {
 
@@ -58,15 +63,39 @@ namespace nexus {
     /// Adds counts to a given time bin
     void Fill(G4double time, G4int counts=1);
 
+    /// Returns the histogram as a map from the start time of each
+    /// non-empty bin to its counts. It is built on demand from the bins.
     const std::map<G4double, G4int>& GetHistogram() const;
 
+    /// Calls f(bin, counts) for every non-empty bin, in increasing
+    /// order of the bin index (that is, of time/bin_size)
+    template <typename F>
+    void ForEachBin(F f) const;
+
+  private:
+    void FillSparse(G4long bin, G4int counts);
+    void FillDenseOutside(G4long bin, G4int counts);
+    void MakeDense();
+    void MakeSparse();
+
   private:
     G4int pmt_id_;           ///< Detector ID number
     G4double bin_size_;      ///< Size of time bin
     G4ThreeVector position_; ///< Detector position
 
-    /// Sparse histogram with number of photons detected per time bin
-    std::map<G4double, G4int> histogram_;
+    /// The histogram is kept as a sorted vector of (bin, counts) while
+    /// few bins are filled, and as a dense vector of counts covering
+    /// [first_bin_, first_bin_ + dense_.size()) once their occupancy is high
+    G4bool is_dense_;
+    std::vector< std::pair<G4long, uint32_t> > sparse_;
+    size_t last_; ///< Position in sparse_ of the last bin filled
+    std::vector<uint32_t> dense_;
+    G4long first_bin_;  ///< Bin of the first element of dense_
+    size_t nonzero_;    ///< Non-empty bins in dense_
+
+    /// Histogram in the format returned by GetHistogram
+    mutable std::map<G4double, G4int> histogram_;
+    mutable G4bool histogram_valid_;
   };
 
 } // namespace nexus
@@ -94,8 +123,35 @@ namespace nexus {
   inline G4ThreeVector PmtHit::GetPosition() const { return position_; }
   inline void PmtHit::SetPosition(const G4ThreeVector& p) { position_ = p; }
 
-  inline const std::map<G4double, G4int>& PmtHit::GetHistogram() const
-  { return histogram_; }
+  inline void PmtHit::Fill(G4double time, G4int counts)
+  {
+    G4long bin = (G4long) std::floor(time/bin_size_);
+    histogram_valid_ = false;
+
+    if (is_dense_) {
+      G4long i = bin - first_bin_;
+      if (i >= 0 && i < (G4long) dense_.size()) {
+        uint32_t& c = dense_[i];
+        if (!c) nonzero_++;
+        c += counts;
+      }
+      else FillDenseOutside(bin, counts);
+    }
+    else FillSparse(bin, counts);
+  }
+
+  template <typename F>
+  inline void PmtHit::ForEachBin(F f) const
+  {
+    if (is_dense_) {
+      for (size_t i=0; i<dense_.size(); ++i)
+        if (dense_[i]) f(first_bin_ + (G4long) i, (G4int) dense_[i]);
+    }
+    else {
+      for (size_t i=0; i<sparse_.size(); ++i)
+        f(sparse_[i].first, (G4int) sparse_[i].second);
+    }
+  }
 
 } // namespace nexus
 
@@ -8,13 +8,16 @@
 // ----------------------------------------------------------------------------
 
 #include "PmtSD.h"
+#include "SensorRegistry.h"
 
 #include <G4OpticalPhoton.hh>
 #include <G4SDManager.hh>
 #include <G4ProcessManager.hh>
 #include <G4OpBoundaryProcess.hh>
+#include <G4OpticalSurface.hh>
+#include <G4LogicalSkinSurface.hh>
 #include <G4RunManager.hh>
-#include <G4RunManager.hh>
+#include <CLHEP/Random/RandBinomial.h>
 
 
 namespace nexus {
@@ -27,12 +30,16 @@ namespace nexus {
   {
     // Register the name of the collection of hits
     collectionName.insert(GetCollectionUniqueName());
+
+    // Make the sensors of this detector known to the persistency
+    SensorRegistry::Register(this);
   }
 
 
 
   PmtSD::~PmtSD()
   {
+    SensorRegistry::Deregister(this);
   }
 
 
@@ -53,6 +60,9 @@ namespace nexus {
       GetCollectionID(this->GetName()+"/"+this->GetCollectionName(0));
 
     HCE->AddHitsCollection(HCID, HC_);
+
+    // The hits of the previous event belong to its collection
+    hit_index_.clear();
   }
 
 
@@ -80,33 +90,26 @@ namespace nexus {
     // Check if the photon has reached a geometry boundary
     if (step->GetPostStepPoint()->GetStepStatus() == fGeomBoundary) {
 
-      // Check whether the photon has been detected in the boundary
-      if (boundary_->GetStatus() == Detection) {
+      // Check whether the photon has been detected in the boundary.
+      // Tracks of weight N are bunches of N photons (see Electroluminescence).
+      // The weights of the primary vertices (importance sampling) are
+      // assumed to be at most 1, so the photons they pass on count as
+      // single photons: the event weight is only kept in event_index.
+      G4int weight = G4int(step->GetTrack()->GetWeight() + 0.5);
+      G4int counts = 0;
+      if (weight > 1)
+        counts = CountBunchPhotons(step, boundary_->GetStatus(), weight);
+      else if (boundary_->GetStatus() == Detection)
+        counts = 1;
+
+      if (counts > 0) {
 	const G4VTouchable* touchable =
 	  step->GetPostStepPoint()->GetTouchable();
 
 	G4int pmt_id = FindPmtID(touchable);
 
- 	PmtHit* hit = 0;
-	for (size_t i=0; i<HC_->entries(); i++) {
- 	  if ((*HC_)[i]->GetPmtID() == pmt_id) {
- 	    hit = (*HC_)[i];
-	    break;
-	  }
- 	}
-
- 	// If no hit associated to this sensor exists already,
- 	// create it and set main properties
- 	if (!hit) {
- 	  hit = new PmtHit();
- 	  hit->SetPmtID(pmt_id);
- 	  hit->SetBinSize(timebinning_);
- 	  hit->SetPosition(touchable->GetTranslation());
- 	  HC_->insert(hit);
- 	}
-
  	G4double time = step->GetPostStepPoint()->GetGlobalTime();
- 	hit->Fill(time);
+ 	Fill(pmt_id, touchable->GetTranslation(), time, counts);
       }
     }
 
@@ -115,7 +118,74 @@ namespace nexus {
 
 
 
-  G4int PmtSD::FindPmtID(const G4VTouchable* touchable)
+  void PmtSD::Fill(G4int pmt_id, const G4ThreeVector& position,
+                   G4double time, G4int counts)
+  {
+    PmtHit*& hit = hit_index_[pmt_id];
+
+    // If no hit associated to this sensor exists already,
+    // create it and set main properties
+    if (!hit) {
+      hit = new PmtHit();
+      hit->SetPmtID(pmt_id);
+      hit->SetBinSize(timebinning_);
+      hit->SetPosition(position);
+      HC_->insert(hit);
+    }
+
+    hit->Fill(time, counts);
+  }
+
+
+
+  G4int PmtSD::CountBunchPhotons(const G4Step* step,
+                                 G4OpBoundaryProcessStatus status, G4int weight)
+  {
+    // The boundary process decides whether a photon reaching the sensor
+    // surface is detected or absorbed drawing once from its efficiency.
+    // For a bunch, the photons are instead detected independently.
+    if (status != Detection && status != Absorption) return 0;
+
+    G4MaterialPropertyVector* efficiency =
+      FindEfficiency(step->GetPostStepPoint()->GetPhysicalVolume()->GetLogicalVolume());
+    if (!efficiency)
+      efficiency = FindEfficiency(step->GetPreStepPoint()->GetPhysicalVolume()->GetLogicalVolume());
+
+    // Without a known efficiency, the bunch is detected as a whole
+    if (!efficiency) return (status == Detection) ? weight : 0;
+
+    G4double eff = efficiency->Value(step->GetTrack()->GetKineticEnergy());
+    if (eff <= 0.) return 0;
+    if (eff >= 1.) return weight;
+
+    return G4int(CLHEP::RandBinomial::shoot(weight, eff));
+  }
+
+
+
+  G4MaterialPropertyVector* PmtSD::FindEfficiency(const G4LogicalVolume* logvol)
+  {
+    std::unordered_map<const G4LogicalVolume*, G4MaterialPropertyVector*>::iterator it =
+      efficiency_.find(logvol);
+    if (it != efficiency_.end()) return it->second;
+
+    G4MaterialPropertyVector* efficiency = 0;
+
+    G4LogicalSkinSurface* skin = G4LogicalSkinSurface::GetSurface(logvol);
+    if (skin) {
+      G4OpticalSurface* surface =
+        dynamic_cast<G4OpticalSurface*>(skin->GetSurfaceProperty());
+      if (surface && surface->GetMaterialPropertiesTable())
+        efficiency = surface->GetMaterialPropertiesTable()->GetProperty("EFFICIENCY");
+    }
+
+    efficiency_[logvol] = efficiency;
+    return efficiency;
+  }
+
+
+
+  G4int PmtSD::FindPmtID(const G4VTouchable* touchable) const
   {
     G4int pmtid = touchable->GetCopyNumber(sensor_depth_);
     if (naming_order_ != 0) {
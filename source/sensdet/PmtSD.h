@@ -11,19 +11,25 @@
 #define PMT_SD_H
 
 #include <G4VSensitiveDetector.hh>
+#include <G4MaterialPropertyVector.hh>
+#include <G4OpBoundaryProcess.hh>
 #include "PmtHit.h"
 
+#include <unordered_map>
+
 class G4Step;
 class G4HCofThisEvent;
 class G4VTouchable;
 class G4TouchableHistory;
-class G4OpBoundaryProcess;
+class G4LogicalVolume;
 
 
 namespace nexus {
 
   class PmtSD: public G4VSensitiveDetector
   {
+    friend class SensorRegistry;
+
   public:
     /// Constructor providing names for the sensitive detector
     /// and the collection of hits
@@ -57,6 +63,12 @@ namespace nexus {
     /// Set a time binning for the pmt hits
     void SetTimeBinning(G4double);
 
+    /// Add counts to the hit of a sensor in the current event, creating
+    /// the hit if needed. Also used by fast simulation models that
+    /// produce the sensor response without tracking optical photons.
+    void Fill(G4int pmt_id, const G4ThreeVector& position,
+              G4double time, G4int counts=1);
+
     /// Return the unique name of the hits collection created
     /// by this sensitive detector. This will be used by the
     /// persistency manager to select the collection.
@@ -66,7 +78,14 @@ namespace nexus {
 
     G4bool ProcessHits(G4Step*, G4TouchableHistory*);
 
-    G4int FindPmtID(const G4VTouchable*);
+    G4int FindPmtID(const G4VTouchable*) const;
+
+    /// Number of photons of a bunch (an optical photon track of the given
+    /// weight) detected at the boundary where the step ends
+    G4int CountBunchPhotons(const G4Step*, G4OpBoundaryProcessStatus, G4int weight);
+
+    /// Detection efficiency of the optical surface of a volume, if any
+    G4MaterialPropertyVector* FindEfficiency(const G4LogicalVolume*);
 
     G4int naming_order_; ///< Order of the naming scheme
     G4int sensor_depth_; ///< Depth of the SD in the geometry tree
@@ -77,6 +96,12 @@ namespace nexus {
     G4OpBoundaryProcess* boundary_; ///< Pointer to the optical boundary process
 
     PmtHitsCollection* HC_; ///< Pointer to the collection of hits
+
+    /// Hit of each sensor in the current event
+    std::unordered_map<G4int, PmtHit*> hit_index_;
+
+    /// Detection efficiency of the skin surface of each volume
+    std::unordered_map<const G4LogicalVolume*, G4MaterialPropertyVector*> efficiency_;
   };
 
   // INLINE METHODS //////////////////////////////////////////////////
@@ -0,0 +1,112 @@
+// ----------------------------------------------------------------------------
+// nexus | SensorRegistry.cc
+//
+// This class keeps track of the photosensor sensitive detectors and
+// enumerates, walking the geometry tree, the ID and position of all
+// the sensors placed in the detector.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#include "SensorRegistry.h"
+
+#include "PmtSD.h"
+
+#include <G4VPhysicalVolume.hh>
+#include <G4LogicalVolume.hh>
+#include <G4NavigationHistory.hh>
+#include <G4TouchableHistory.hh>
+#include <G4TransportationManager.hh>
+#include <G4Navigator.hh>
+
+#include <algorithm>
+
+
+namespace nexus {
+
+
+  std::vector<PmtSD*>& SensorRegistry::Detectors()
+  {
+    static std::vector<PmtSD*> detectors;
+    return detectors;
+  }
+
+
+
+  void SensorRegistry::Register(PmtSD* sd)
+  {
+    std::vector<PmtSD*>& detectors = Detectors();
+    if (std::find(detectors.begin(), detectors.end(), sd) == detectors.end())
+      detectors.push_back(sd);
+  }
+
+
+
+  void SensorRegistry::Deregister(PmtSD* sd)
+  {
+    std::vector<PmtSD*>& detectors = Detectors();
+    detectors.erase(std::remove(detectors.begin(), detectors.end(), sd),
+                    detectors.end());
+  }
+
+
+
+  std::vector<SensorRegistry::Sensor>
+  SensorRegistry::FindSensors(const G4VPhysicalVolume* world)
+  {
+    std::vector<Sensor> sensors;
+
+    if (!world)
+      world = G4TransportationManager::GetTransportationManager()->
+        GetNavigatorForTracking()->GetWorldVolume();
+    if (!world || Detectors().empty()) return sensors;
+
+    // The navigation history computes the global transformation
+    // of each level, as the navigator does while tracking
+    G4NavigationHistory history;
+    history.SetFirstEntry(const_cast<G4VPhysicalVolume*>(world));
+
+    std::set<G4int> ids;
+    Walk(history, ids, sensors);
+
+    std::sort(sensors.begin(), sensors.end(),
+              [](const Sensor& a, const Sensor& b) { return a.id < b.id; });
+
+    return sensors;
+  }
+
+
+
+  void SensorRegistry::Walk(G4NavigationHistory& history, std::set<G4int>& ids,
+                            std::vector<Sensor>& sensors)
+  {
+    G4LogicalVolume* logvol = history.GetTopVolume()->GetLogicalVolume();
+
+    const std::vector<PmtSD*>& detectors = Detectors();
+    std::vector<PmtSD*>::const_iterator it =
+      std::find(detectors.begin(), detectors.end(), logvol->GetSensitiveDetector());
+
+    if (it != detectors.end()) {
+      // Same numbering as for the hits, which use the touchable
+      // of the sensitive volume where the photon is detected
+      G4TouchableHistory touchable(history);
+      G4int id = (*it)->FindPmtID(&touchable);
+      if (ids.insert(id).second) {
+        Sensor sensor;
+        sensor.id       = id;
+        sensor.sd       = *it;
+        sensor.position = touchable.GetTranslation();
+        sensors.push_back(sensor);
+      }
+    }
+
+    for (size_t i=0; i<logvol->GetNoDaughters(); ++i) {
+      G4VPhysicalVolume* daughter = logvol->GetDaughter(i);
+      history.NewLevel(daughter, kNormal, daughter->GetCopyNo());
+      Walk(history, ids, sensors);
+      history.BackLevel();
+    }
+  }
+
+
+} // end namespace nexus
@@ -0,0 +1,56 @@
+// ----------------------------------------------------------------------------
+// nexus | SensorRegistry.h
+//
+// This class keeps track of the photosensor sensitive detectors and
+// enumerates, walking the geometry tree, the ID and position of all
+// the sensors placed in the detector.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#ifndef SENSOR_REGISTRY_H
+#define SENSOR_REGISTRY_H
+
+#include <G4ThreeVector.hh>
+#include <vector>
+#include <set>
+
+class G4VPhysicalVolume;
+class G4NavigationHistory;
+
+
+namespace nexus {
+
+  class PmtSD;
+
+  class SensorRegistry
+  {
+  public:
+    /// Description of a sensor placed in the geometry
+    struct Sensor {
+      G4int id;               ///< Sensor ID, as given to its hits
+      PmtSD* sd;              ///< Sensitive detector of the sensor
+      G4ThreeVector position; ///< Position in the global frame
+    };
+
+    /// Add a sensitive detector to the registry. Invoked by
+    /// the PmtSD constructor.
+    static void Register(PmtSD*);
+    /// Remove a sensitive detector from the registry
+    static void Deregister(PmtSD*);
+
+    /// Return all the sensors of the registered sensitive detectors
+    /// placed under the given volume (by default, the world), sorted by ID.
+    /// Sensors placed several times with the same ID are returned once.
+    static std::vector<Sensor> FindSensors(const G4VPhysicalVolume* world = 0);
+
+  private:
+    static std::vector<PmtSD*>& Detectors();
+
+    static void Walk(G4NavigationHistory&, std::set<G4int>& ids,
+                     std::vector<Sensor>&);
+  };
+
+} // end namespace nexus
+
+#endif
@@ -0,0 +1,117 @@
+#include <decay0.h>
+#include <Decay0Producer.h>
+
+#include <CLHEP/Random/MixMaxRng.h>
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+  // Energies of the two electrons of n 2nubb decays of Xe136
+  // to the ground state of Ba136, in MeV
+  void SampleEnergies(bool tabulated, int n, long seed,
+                      std::vector<double>& e1, std::vector<double>& sum)
+  {
+    CLHEP::MixMaxRng engine(seed);
+    decay0 generator("Xe136", 0, 4);
+    generator.SetRandomEngine(&engine);
+    generator.SetTabulatedSampling(tabulated);
+
+    std::vector<decay0Part> particles;
+    for (int i=0; i<n; ++i) {
+      generator.decay0DoIt(particles);
+      REQUIRE(particles.size() >= 2);
+      REQUIRE(particles[0].pdgCode_ == 11);
+      REQUIRE(particles[1].pdgCode_ == 11);
+      e1 .push_back(particles[0].energy_);
+      sum.push_back(particles[0].energy_ + particles[1].energy_);
+    }
+    std::sort(e1 .begin(), e1 .end());
+    std::sort(sum.begin(), sum.end());
+  }
+
+  double Mean(const std::vector<double>& values)
+  {
+    double total = 0.;
+    for (double v: values) total += v;
+    return total / values.size();
+  }
+
+  double Quantile(const std::vector<double>& sorted, double q)
+  {
+    return sorted[size_t(q * (sorted.size() - 1))];
+  }
+
+}
+
+
+TEST_CASE("decay0 tables") {
+  // The tabulated spectra give the same distributions of the
+  // energy of the first electron and of the sum of both energies
+  // as the acceptance/rejection sampling of the original code.
+  // With 5000 decays, the tolerances on the means (0.03 MeV) and
+  // on the quartiles (0.04 MeV) are about 4 standard deviations.
+
+  const int n = 5000;
+  std::vector<double> table_e1, table_sum, reject_e1, reject_sum;
+  SampleEnergies(true , n, 1, table_e1 , table_sum );
+  SampleEnergies(false, n, 2, reject_e1, reject_sum);
+
+  REQUIRE(Mean(table_e1 ) == Approx(Mean(reject_e1 )).margin(0.03));
+  REQUIRE(Mean(table_sum) == Approx(Mean(reject_sum)).margin(0.03));
+
+  for (double q: {0.25, 0.5, 0.75}) {
+    REQUIRE(Quantile(table_e1 , q) == Approx(Quantile(reject_e1 , q)).margin(0.04));
+    REQUIRE(Quantile(table_sum, q) == Approx(Quantile(reject_sum, q)).margin(0.04));
+  }
+
+  // The sum never exceeds the Q value of Xe136
+  REQUIRE(table_sum.back() <= 2.458);
+}
+
+
+TEST_CASE("Decay0Producer") {
+  // The producer thread generates the decays with
+  // its own engine, so the same seed gives the same decays
+
+  SECTION("Same seed, same decays") {
+    decay0 generator1("Xe136", 0, 4);
+    decay0 generator2("Xe136", 0, 4);
+    nexus::Decay0Producer producer1(&generator1, 4, 17);
+    nexus::Decay0Producer producer2(&generator2, 8, 17);
+
+    std::vector<decay0Part> particles1, particles2;
+    for (int i=0; i<100; ++i) {
+      producer1.Pop(particles1);
+      producer2.Pop(particles2);
+      REQUIRE(particles1.size() == particles2.size());
+      for (size_t p=0; p<particles1.size(); ++p) {
+        REQUIRE(particles1[p].pdgCode_ == particles2[p].pdgCode_);
+        REQUIRE(particles1[p].energy_  == particles2[p].energy_);
+        REQUIRE(particles1[p].pmom_[0] == particles2[p].pmom_[0]);
+        REQUIRE(particles1[p].pmom_[1] == particles2[p].pmom_[1]);
+        REQUIRE(particles1[p].pmom_[2] == particles2[p].pmom_[2]);
+      }
+    }
+  }
+
+  SECTION("Destruction with a full buffer") {
+    // The thread waits for a free slot when it is stopped,
+    // which must not block the destructor
+    decay0 generator("Xe136", 0, 4);
+    nexus::Decay0Producer* producer = new nexus::Decay0Producer(&generator, 2, 17);
+
+    std::vector<decay0Part> particles;
+    producer->Pop(particles);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    delete producer;
+    REQUIRE(!particles.empty());
+  }
+}
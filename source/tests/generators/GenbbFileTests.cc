@@ -0,0 +1,78 @@
+#include <GenbbFile.h>
+
+#include <catch.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+
+namespace {
+
+  // Event e has e+1 electrons, particle p of it having
+  // momentum (e, p, -1) MeV and time p ns
+  const int num_events = 4;
+
+  void WriteBinary(const char* filename)
+  {
+    std::vector<uint64_t> offsets(1, 0);
+    std::vector<double> times;
+    std::vector<nexus::GenbbParticle> particles;
+    for (int e=0; e<num_events; ++e) {
+      times.push_back(0.5*e);
+      for (int p=0; p<=e; ++p) {
+        nexus::GenbbParticle particle = {11, 0, {double(e), double(p), -1.}, p*1.e-9};
+        particles.push_back(particle);
+      }
+      offsets.push_back(particles.size());
+    }
+
+    nexus::GenbbHeader header = {{'N','X','G','E','N','B','B','1'}, 1, 0,
+                                 (uint64_t) num_events, particles.size()};
+
+    std::ofstream file(filename, std::ofstream::binary);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size()*sizeof(uint64_t));
+    file.write(reinterpret_cast<const char*>(times.data()), times.size()*sizeof(double));
+    file.write(reinterpret_cast<const char*>(particles.data()),
+               particles.size()*sizeof(nexus::GenbbParticle));
+  }
+
+}
+
+
+TEST_CASE("GenbbFile") {
+  // These tests check that the events of a binary genbb file
+  // are read from the mapped file at any position
+
+  const char* filename = "GenbbFileTests.bin";
+  WriteBinary(filename);
+
+  REQUIRE(nexus::GenbbFile::IsBinary(filename));
+
+  nexus::GenbbFile file(filename);
+  REQUIRE(file.GetNumberOfEvents() == num_events);
+
+  // Events in reverse order, as a job starting at an offset would
+  for (int e=num_events-1; e>=0; --e) {
+    nexus::GenbbFile::Event event = file.GetEvent(e);
+    REQUIRE(event.size == size_t(e+1));
+    REQUIRE(event.time == 0.5*e);
+    for (size_t p=0; p<event.size; ++p) {
+      REQUIRE(event.particles[p].pdg_code == 11);
+      REQUIRE(event.particles[p].momentum[0] == e);
+      REQUIRE(event.particles[p].momentum[1] == p);
+      REQUIRE(event.particles[p].time == p*1.e-9);
+    }
+  }
+
+  std::remove(filename);
+
+  // Text files are not taken as binary ones
+  std::ofstream text(filename);
+  text << " GENBB generated file\n";
+  text.close();
+  REQUIRE(!nexus::GenbbFile::IsBinary(filename));
+
+  std::remove(filename);
+}
@@ -0,0 +1,95 @@
+#include <HDF5Writer.h>
+#include <hdf5_functions.h>
+
+#include <hdf5.h>
+
+#include <catch.hpp>
+
+#include <cstdio>
+#include <vector>
+
+
+namespace {
+
+  // Rows of a one-dimensional dataset of the output file
+  template <typename T>
+  std::vector<T> ReadRows(hid_t file, const char* name, hid_t memtype)
+  {
+    hid_t dataset = H5Dopen2(file, name, H5P_DEFAULT);
+    hid_t space = H5Dget_space(dataset);
+    hsize_t nrows = 0;
+    H5Sget_simple_extent_dims(space, &nrows, NULL);
+
+    std::vector<T> rows(nrows);
+    if (nrows > 0)
+      H5Dread(dataset, memtype, H5S_ALL, H5S_ALL, H5P_DEFAULT, rows.data());
+
+    H5Sclose(space);
+    H5Dclose(dataset);
+    return rows;
+  }
+
+}
+
+
+TEST_CASE("Sparse sensor response") {
+  // These tests check that the waveforms written in sparse layout
+  // are read back from the index and the flat time_bin and charge arrays
+
+  const char* filename = "SparseSensorResponseTests.h5";
+
+  // Waveforms of two events: event 0 has two sensors,
+  // event 1 has the first one again and a PMT
+  struct Sample { int event; unsigned int sensor, time_bin, charge; };
+  const std::vector<Sample> samples =
+    {{0, 1000, 3, 1}, {0, 1000, 4, 7}, {0, 1000, 9, 2},
+     {0, 2063, 5, 4},
+     {1, 1000, 0, 1}, {1, 1000, 1, 3},
+     {1,   12, 8, 70000}};
+
+  nexus::HDF5Writer writer;
+  writer.SetSparseSensorData(true);
+  // Flushes in the middle of the waveforms
+  writer.SetBufferRows(2);
+  writer.Open(filename, false);
+  for (size_t i=0; i<samples.size(); ++i)
+    writer.WriteSensorDataInfo(samples[i].event, samples[i].sensor,
+                               samples[i].time_bin, samples[i].charge);
+  writer.Close();
+
+  hid_t file = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+  REQUIRE(file >= 0);
+
+  std::vector<sns_index_t> index =
+    ReadRows<sns_index_t>(file, "/MC/sns_response/index", createSensorIndexType());
+  std::vector<uint32_t> time_bins =
+    ReadRows<uint32_t>(file, "/MC/sns_response/time_bin", H5T_NATIVE_UINT32);
+  std::vector<uint32_t> charges =
+    ReadRows<uint32_t>(file, "/MC/sns_response/charge", H5T_NATIVE_UINT32);
+  H5Fclose(file);
+  std::remove(filename);
+
+  REQUIRE(time_bins.size() == samples.size());
+  REQUIRE(charges.size()   == samples.size());
+
+  // One waveform per sensor and event, in the order written
+  REQUIRE(index.size() == 4);
+  const int    events [] = {0, 0, 1, 1};
+  const unsigned int sensors[] = {1000, 2063, 1000, 12};
+  const size_t lengths[] = {3, 1, 2, 1};
+
+  size_t offset = 0;
+  for (size_t w=0; w<index.size(); ++w) {
+    REQUIRE(index[w].event_id  == events[w]);
+    REQUIRE(index[w].sensor_id == sensors[w]);
+    REQUIRE(index[w].offset    == offset);
+    REQUIRE(index[w].length    == lengths[w]);
+
+    // The slice of the waveform holds its samples
+    for (size_t i=offset; i<offset+lengths[w]; ++i) {
+      REQUIRE(time_bins[i] == samples[i].time_bin);
+      REQUIRE(charges[i]   == samples[i].charge);
+    }
+    offset += lengths[w];
+  }
+}
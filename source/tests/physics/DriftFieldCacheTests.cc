@@ -0,0 +1,70 @@
+#include <DriftFieldCache.h>
+#include <UniformElectricDriftField.h>
+
+#include <G4Region.hh>
+
+#include <vector>
+
+#include <catch.hpp>
+
+
+namespace {
+
+  // Regions as defined by the NEXT geometries: a drift and an EL
+  // region with fields, plus regions without them
+  std::vector<G4Region*> MakeRegions(const G4String& prefix)
+  {
+    std::vector<G4Region*> regions;
+    for (G4int i=0; i<4; ++i) {
+      G4Region* region = new G4Region(prefix + std::to_string(i));
+      if (i < 2) region->SetUserInformation(new nexus::UniformElectricDriftField());
+      regions.push_back(region);
+    }
+    return regions;
+  }
+
+}
+
+
+TEST_CASE("DriftFieldCache") {
+  // The cache gives the same field as the region user information
+  std::vector<G4Region*> regions = MakeRegions("DRIFT_FIELD_CACHE_TEST_");
+
+  nexus::DriftFieldCache cache;
+  cache.Build();
+
+  for (size_t i=0; i<regions.size(); ++i)
+    REQUIRE(cache.GetField(regions[i]) ==
+            dynamic_cast<nexus::BaseDriftField*>(regions[i]->GetUserInformation()));
+
+  // Regions created after the build are found as well
+  G4Region* late = new G4Region("DRIFT_FIELD_CACHE_TEST_LATE");
+  late->SetUserInformation(new nexus::UniformElectricDriftField());
+  REQUIRE(cache.GetField(late) == late->GetUserInformation());
+}
+
+
+TEST_CASE("DriftFieldCache benchmark", "[.][benchmark]") {
+  // Run with: nexus-test "[benchmark]"
+  // Field lookups of ten million ie- drift steps
+  std::vector<G4Region*> regions = MakeRegions("DRIFT_FIELD_CACHE_BENCHMARK_");
+
+  nexus::DriftFieldCache cache;
+  cache.Build();
+
+  const size_t num_steps = 10000000;
+  size_t found = 0;
+
+  BENCHMARK("dynamic_cast of the region information") {
+    for (size_t i=0; i<num_steps; ++i)
+      if (dynamic_cast<nexus::BaseDriftField*>(regions[i%2]->GetUserInformation()))
+        found++;
+  }
+
+  BENCHMARK("Drift field cache") {
+    for (size_t i=0; i<num_steps; ++i)
+      if (cache.GetField(regions[i%2])) found++;
+  }
+
+  REQUIRE(found >= 2 * num_steps);
+}
@@ -0,0 +1,101 @@
+#include <ELLookupTable.h>
+
+#include <catch.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+
+namespace {
+
+  // Grid of radius 10 mm and pitch 5 mm: 13 points inside the circle,
+  // numbered by x and then by y. Point p is seen by sensor 100+p
+  // with probabilities {p, 2p} in its two time bins.
+  const int num_points = 13;
+
+  void WriteText(const char* filename)
+  {
+    std::ofstream file(filename);
+    file << "* EL table for testing\n";
+    file << "* grid_radius 10.\n";
+    file << "* grid_pitch 5.\n";
+    for (int p=0; p<num_points; ++p)
+      file << p << " " << 100+p << " " << p << " " << 2*p << "\n";
+  }
+
+  void WriteBinary(const char* filename)
+  {
+    nexus::ELTableHeader header = {{'N','X','E','L','T','A','B','1'},
+                                   1, 2, 10., 5., num_points, num_points};
+    std::vector<uint64_t> offsets;
+    std::vector<int32_t> ids;
+    std::vector<float> probs;
+    for (int p=0; p<num_points; ++p) {
+      offsets.push_back(p);
+      ids.push_back(100+p);
+      probs.push_back(p);
+      probs.push_back(2*p);
+    }
+    offsets.push_back(num_points);
+
+    std::ofstream file(filename, std::ofstream::binary);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size()*sizeof(uint64_t));
+    file.write(reinterpret_cast<const char*>(ids.data()), ids.size()*sizeof(int32_t));
+    file.write(reinterpret_cast<const char*>(probs.data()), probs.size()*sizeof(float));
+  }
+
+  int PointAt(const nexus::ELLookupTable& table, double x, double y)
+  {
+    nexus::ELLookupTable::Point point = table.GetPoint(G4ThreeVector(x, y, 0.));
+    REQUIRE(point.size == 1);
+    REQUIRE(point.num_bins == 2);
+    REQUIRE(point.probs[1] == Approx(2.*point.probs[0]));
+    return point.sensor_ids[0] - 100;
+  }
+
+}
+
+
+TEST_CASE("ELLookupTable") {
+  // These tests check that positions are assigned to the closest
+  // grid point, in both the text and the binary formats
+
+  const char* text_file   = "ELLookupTableTests.txt";
+  const char* binary_file = "ELLookupTableTests.bin";
+  WriteText(text_file);
+  WriteBinary(binary_file);
+
+  nexus::ELLookupTable text_table(text_file);
+  nexus::ELLookupTable binary_table(binary_file);
+
+  const nexus::ELLookupTable* tables[2] = {&text_table, &binary_table};
+
+  for (int t=0; t<2; ++t) {
+    const nexus::ELLookupTable& table = *tables[t];
+
+    REQUIRE(table.GetRadius() == Approx(10.));
+    REQUIRE(table.GetPitch()  == Approx(5.));
+    REQUIRE(table.GetNumberOfPoints() == num_points);
+
+    // Points inside the circle
+    REQUIRE(PointAt(table, -10.,  0.) ==  0);
+    REQUIRE(PointAt(table,  -5., -5.) ==  1);
+    REQUIRE(PointAt(table,   0.,  0.) ==  6);
+    REQUIRE(PointAt(table,   1., -1.) ==  6);
+    REQUIRE(PointAt(table,   4.,  6.) == 11);
+    REQUIRE(PointAt(table,  10.,  0.) == 12);
+
+    // Grid nodes outside the circle take the closest point inside
+    REQUIRE(PointAt(table, -10., -10.) ==  1);
+    REQUIRE(PointAt(table,  10.,  10.) == 11);
+
+    // Positions outside the grid are moved to its border
+    REQUIRE(PointAt(table, 1000., 0.) == 12);
+    REQUIRE(PointAt(table, 0., -1000.) == 4);
+  }
+
+  std::remove(text_file);
+  std::remove(binary_file);
+}
@@ -0,0 +1,118 @@
+#include <FieldMapDriftField.h>
+
+#include <catch.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+
+namespace {
+
+  // Values of a map that are linear in the coordinates,
+  // and therefore exactly reproduced by the interpolation
+  void LinearValues(double c0, double c1, double c2, float* values)
+  {
+    values[0] = 1. + 0.001 * c2;
+    values[1] = 0.;
+    values[2] = 0.;
+    values[3] = 0.01 * c0 - 0.02 * c2;
+    values[4] = 0.03 * c1 + 0.5;
+  }
+
+  // Map with nodes every 10 mm in x and y from -50 mm to 50 mm, and
+  // (for 3D maps) in z every 20 mm from 0 to 500 mm, the anode being at z=0
+  void WriteMap(const char* filename, int dimensions)
+  {
+    nexus::DriftMapHeader header = {{'N','X','D','R','M','A','P','1'}, 1,
+                                    (uint32_t) dimensions, {11, 11, 26}, 0,
+                                    {-50., -50., 0.}, {10., 10., 20.}, 0., 500.};
+    if (dimensions == 2) {
+      // (r, z) map: r from 0 to 50 mm, z from 0 to 500 mm
+      header.num_nodes[0] = 6;  header.min[0] = 0.;  header.pitch[0] = 10.;
+      header.num_nodes[1] = 26; header.min[1] = 0.;  header.pitch[1] = 20.;
+      header.num_nodes[2] = 1;  header.min[2] = 0.;  header.pitch[2] = 0.;
+    }
+
+    std::vector<float> values;
+    for (uint32_t i=0; i<header.num_nodes[0]; ++i)
+      for (uint32_t j=0; j<header.num_nodes[1]; ++j)
+        for (uint32_t k=0; k<header.num_nodes[2]; ++k) {
+          float node[nexus::FieldMapDriftField::kNumValues];
+          LinearValues(header.min[0] + i*header.pitch[0],
+                       header.min[1] + j*header.pitch[1],
+                       header.min[2] + k*header.pitch[2], node);
+          values.insert(values.end(), node, node + nexus::FieldMapDriftField::kNumValues);
+        }
+
+    std::ofstream file(filename, std::ofstream::binary);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(values.data()), values.size()*sizeof(float));
+  }
+
+}
+
+
+TEST_CASE("FieldMapDriftField") {
+  // These tests check the interpolation of the map and the drift of
+  // a charge without diffusion, for maps in (x, y, z) and in (r, z)
+
+  const char* filename = "FieldMapDriftFieldTests.bin";
+
+  SECTION("(x, y, z) map") {
+    WriteMap(filename, 3);
+    nexus::FieldMapDriftField field(filename);
+
+    double values[nexus::FieldMapDriftField::kNumValues];
+    float expected[nexus::FieldMapDriftField::kNumValues];
+
+    const G4ThreeVector points[3] = {G4ThreeVector(3., -7.5, 123.),
+                                     G4ThreeVector(-50., 50., 0.),
+                                     G4ThreeVector(12.3, 45.6, 499.)};
+    for (int p=0; p<3; ++p) {
+      field.Interpolate(points[p], values);
+      LinearValues(points[p].x(), points[p].y(), points[p].z(), expected);
+      for (int v=0; v<nexus::FieldMapDriftField::kNumValues; ++v)
+        REQUIRE(values[v] == Approx(expected[v]).margin(1.e-5));
+    }
+
+    // Positions outside the grid take the values of its border
+    field.Interpolate(G4ThreeVector(80., 0., 250.), values);
+    LinearValues(50., 0., 250., expected);
+    REQUIRE(values[nexus::FieldMapDriftField::kDisplacement1] ==
+            Approx(expected[nexus::FieldMapDriftField::kDisplacement1]));
+
+    // Drift to the anode, displaced by the map
+    G4LorentzVector xyzt(G4ThreeVector(10., 20., 200.), 5.);
+    LinearValues(10., 20., 200., expected);
+    G4double length = field.Drift(xyzt);
+
+    REQUIRE(length > 0.);
+    REQUIRE(xyzt.z() == Approx(0.).margin(1.e-2));
+    REQUIRE(xyzt.x() == Approx(10. + expected[nexus::FieldMapDriftField::kDisplacement1]));
+    REQUIRE(xyzt.y() == Approx(20. + expected[nexus::FieldMapDriftField::kDisplacement2]));
+    REQUIRE(xyzt.t() == Approx(5. + 200. / expected[nexus::FieldMapDriftField::kVelocity]));
+
+    // Charges outside the drift volume don't move
+    G4LorentzVector outside(G4ThreeVector(0., 0., 600.), 0.);
+    REQUIRE(field.Drift(outside) == 0.);
+    REQUIRE(outside.z() == 600.);
+  }
+
+  SECTION("(r, z) map") {
+    WriteMap(filename, 2);
+    nexus::FieldMapDriftField field(filename);
+
+    // The displacements are radial and azimuthal
+    G4LorentzVector xyzt(G4ThreeVector(0., 20., 100.), 0.);
+    float expected[nexus::FieldMapDriftField::kNumValues];
+    LinearValues(20., 100., 0., expected);
+    field.Drift(xyzt);
+
+    REQUIRE(xyzt.y() == Approx(20. + expected[nexus::FieldMapDriftField::kDisplacement1]));
+    REQUIRE(xyzt.x() == Approx(-expected[nexus::FieldMapDriftField::kDisplacement2]));
+  }
+
+  std::remove(filename);
+}
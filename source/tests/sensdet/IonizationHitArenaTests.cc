@@ -0,0 +1,87 @@
+#include <IonizationHit.h>
+
+#include <catch.hpp>
+
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+  // Hits of an event, more than those of a block of the arena
+  std::vector<nexus::IonizationHit*> NewHits(size_t n)
+  {
+    std::vector<nexus::IonizationHit*> hits;
+    for (size_t i=0; i<n; ++i) {
+      nexus::IonizationHit* hit = new nexus::IonizationHit();
+      hit->SetTrackID(i);
+      hits.push_back(hit);
+    }
+    return hits;
+  }
+
+  void DeleteHits(std::vector<nexus::IonizationHit*>& hits)
+  {
+    for (size_t i=0; i<hits.size(); ++i) delete hits[i];
+    hits.clear();
+  }
+
+}
+
+
+TEST_CASE("IonizationHitArena") {
+  // These tests check that the arena hands out distinct hits and
+  // rewinds to its first block once all the hits of an event are deleted
+
+  const size_t num_hits = 40000;
+
+  std::vector<nexus::IonizationHit*> event1 = NewHits(num_hits);
+  REQUIRE(nexus::IonizationHitArena::GetNumberOfHits() == num_hits);
+
+  // No hit overwrites another
+  for (size_t i=0; i<num_hits; ++i)
+    REQUIRE(event1[i]->GetTrackID() == G4int(i));
+
+  nexus::IonizationHit* first = event1[0];
+  nexus::IonizationHit* last  = event1[num_hits-1];
+
+  SECTION("The arena is reset between events") {
+    DeleteHits(event1);
+    REQUIRE(nexus::IonizationHitArena::GetNumberOfHits() == 0);
+
+    // The next event reuses the same memory
+    std::vector<nexus::IonizationHit*> event2 = NewHits(num_hits);
+    REQUIRE(event2[0] == first);
+    REQUIRE(event2[num_hits-1] == last);
+    DeleteHits(event2);
+  }
+
+  SECTION("The arena is not reset while hits are in use") {
+    nexus::IonizationHit* kept = event1[num_hits/2];
+    event1.erase(event1.begin() + num_hits/2);
+    DeleteHits(event1);
+    REQUIRE(nexus::IonizationHitArena::GetNumberOfHits() == 1);
+
+    nexus::IonizationHit* hit = new nexus::IonizationHit();
+    REQUIRE(hit != first);
+    REQUIRE(kept->GetTrackID() == G4int(num_hits/2));
+
+    delete hit;
+    delete kept;
+    REQUIRE(nexus::IonizationHitArena::GetNumberOfHits() == 0);
+  }
+
+  SECTION("Each thread has its own arena") {
+    size_t other_hits = 0;
+    std::thread worker([&other_hits]() {
+        std::vector<nexus::IonizationHit*> hits = NewHits(10);
+        other_hits = nexus::IonizationHitArena::GetNumberOfHits();
+        DeleteHits(hits);
+      });
+    worker.join();
+
+    REQUIRE(other_hits == 10);
+    REQUIRE(nexus::IonizationHitArena::GetNumberOfHits() == num_hits);
+    DeleteHits(event1);
+  }
+}
@@ -0,0 +1,60 @@
+#include <PmtHit.h>
+
+#include <Randomize.hh>
+
+#include <cmath>
+#include <map>
+
+#include <catch.hpp>
+
+
+TEST_CASE("PmtHit histogram") {
+  // These tests check that the binned waveform is the same as
+  // a map from bin start time to counts, whatever the internal layout
+
+  G4double bin_size = 25.;
+
+  SECTION("Few photons") {
+    nexus::PmtHit hit;
+    hit.SetBinSize(bin_size);
+    hit.Fill(10.);
+    hit.Fill(20.);
+    hit.Fill(260., 3);
+
+    auto histogram = hit.GetHistogram();
+    REQUIRE(histogram.size() == 2);
+    REQUIRE(histogram[0.]   == 2);
+    REQUIRE(histogram[250.] == 3);
+  }
+
+  SECTION("Dense and sparse layouts") {
+    for (G4int trial=0; trial<50; ++trial) {
+      nexus::PmtHit hit;
+      hit.SetBinSize(bin_size);
+      std::map<G4double, G4int> expected;
+
+      // A burst of photons plus a few outliers spread in time
+      for (G4int i=0; i<20*trial + 1; ++i) {
+        G4double time = (i % 10 == 0) ?
+          1.e5 * G4UniformRand() : 5.e4 + 2000. * G4UniformRand();
+        hit.Fill(time);
+        expected[std::floor(time/bin_size) * bin_size] += 1;
+      }
+
+      REQUIRE(hit.GetHistogram() == expected);
+
+      // Bins are visited in time order
+      G4long previous = -1;
+      G4int total = 0;
+      hit.ForEachBin([&previous, &total](G4long bin, G4int counts) {
+          REQUIRE(bin > previous);
+          previous = bin;
+          total += counts;
+        });
+      REQUIRE(total == 20*trial + 1);
+
+      nexus::PmtHit copy(hit);
+      REQUIRE(copy.GetHistogram() == expected);
+    }
+  }
+}
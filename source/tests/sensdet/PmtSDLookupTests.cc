@@ -0,0 +1,131 @@
+#include <PmtSD.h>
+#include <PmtHit.h>
+
+#include <G4SDManager.hh>
+#include <G4HCofThisEvent.hh>
+#include <G4SystemOfUnits.hh>
+#include <Randomize.hh>
+
+#include <map>
+#include <vector>
+
+#include <catch.hpp>
+
+
+namespace {
+
+  // Sensor IDs numbered as the NEXT-100 SiPMs (board*1000 + sipm)
+  // plus its 60 PMTs
+  std::vector<G4int> Next100SensorIDs()
+  {
+    std::vector<G4int> ids;
+    for (G4int pmt=0; pmt<60; ++pmt) ids.push_back(pmt);
+    for (G4int board=1; board<=56; ++board)
+      for (G4int sipm=0; sipm<64; ++sipm)
+        ids.push_back(board*1000 + sipm);
+    return ids;
+  }
+
+  // Sensor hit by each of the detected photons
+  std::vector<G4int> DetectedPhotons(const std::vector<G4int>& ids, size_t n)
+  {
+    std::vector<G4int> photons(n);
+    for (size_t i=0; i<n; ++i)
+      photons[i] = ids[(size_t) (G4UniformRand() * ids.size())];
+    return photons;
+  }
+
+  // Sensitive detector registered in the SD manager, as done by the geometries
+  nexus::PmtSD* MakeSensitiveDetector(const G4String& name)
+  {
+    nexus::PmtSD* sd = new nexus::PmtSD(name);
+    sd->SetTimeBinning(1.*microsecond);
+    G4SDManager::GetSDMpointer()->AddNewDetector(sd);
+    return sd;
+  }
+
+  // Start an event: the detector creates its collection of hits
+  PmtHitsCollection* BeginEvent(nexus::PmtSD* sd, G4HCofThisEvent& hce)
+  {
+    sd->Initialize(&hce);
+    G4int hcid = G4SDManager::GetSDMpointer()->
+      GetCollectionID(sd->GetName() + "/" + nexus::PmtSD::GetCollectionUniqueName());
+    return static_cast<PmtHitsCollection*>(hce.GetHC(hcid));
+  }
+
+  G4int TotalCounts(const nexus::PmtHit* hit)
+  {
+    G4int counts = 0;
+    auto histogram = hit->GetHistogram();
+    for (auto it = histogram.begin(); it != histogram.end(); ++it)
+      counts += it->second;
+    return counts;
+  }
+
+}
+
+
+TEST_CASE("PmtSD hit index") {
+  nexus::PmtSD* sd = MakeSensitiveDetector("PmtSDLookupTest");
+  G4int capacity = G4SDManager::GetSDMpointer()->GetCollectionCapacity();
+
+  std::vector<G4int> ids = Next100SensorIDs();
+  std::vector<G4int> photons = DetectedPhotons(ids, 10000);
+
+  // The collection has one hit per sensor, holding all its photons
+  G4HCofThisEvent event1(capacity);
+  PmtHitsCollection* hits1 = BeginEvent(sd, event1);
+  REQUIRE(hits1);
+
+  std::map<G4int, G4int> expected;
+  for (size_t i=0; i<photons.size(); ++i) {
+    sd->Fill(photons[i], G4ThreeVector(), i*ns);
+    expected[photons[i]]++;
+  }
+
+  REQUIRE(hits1->entries() == expected.size());
+  for (size_t i=0; i<hits1->entries(); ++i) {
+    const nexus::PmtHit* hit = (*hits1)[i];
+    REQUIRE(TotalCounts(hit) == expected[hit->GetPmtID()]);
+  }
+
+  // The index is cleared between events: the photons of the
+  // next event go to new hits, leaving those of the first one
+  G4HCofThisEvent event2(capacity);
+  PmtHitsCollection* hits2 = BeginEvent(sd, event2);
+
+  G4int id = photons[0];
+  sd->Fill(id, G4ThreeVector(), 0., 5);
+
+  REQUIRE(hits2->entries() == 1);
+  REQUIRE((*hits2)[0]->GetPmtID() == id);
+  REQUIRE(TotalCounts((*hits2)[0]) == 5);
+
+  G4int counts1 = 0;
+  for (size_t i=0; i<hits1->entries(); ++i) counts1 += TotalCounts((*hits1)[i]);
+  REQUIRE(counts1 == (G4int) photons.size());
+}
+
+
+TEST_CASE("PmtSD hit lookup benchmark", "[.][benchmark]") {
+  // Run with: nexus-test "[benchmark]"
+  // Hits of one million photons detected by
+  // NEXT-100-sized sensor planes, all of them fired
+  nexus::PmtSD* sd = MakeSensitiveDetector("PmtSDBenchmark");
+  G4int capacity = G4SDManager::GetSDMpointer()->GetCollectionCapacity();
+
+  std::vector<G4int> ids = Next100SensorIDs();
+  std::vector<G4int> photons = DetectedPhotons(ids, 1000000);
+
+  size_t num_hits = 0;
+
+  BENCHMARK("PmtSD::Fill") {
+    G4HCofThisEvent event(capacity);
+    PmtHitsCollection* hits = BeginEvent(sd, event);
+    for (size_t i=0; i<photons.size(); ++i)
+      sd->Fill(photons[i], G4ThreeVector(), 0.);
+    num_hits = hits->entries();
+  }
+
+  REQUIRE(num_hits == ids.size());
+}
@@ -0,0 +1,32 @@
+#include <AliasSampler.h>
+
+#include <catch.hpp>
+
+#include <vector>
+
+
+TEST_CASE("AliasSampler") {
+  // These tests check that the alias tables reproduce exactly the
+  // probabilities of the distribution, including indices of zero weight
+
+  const G4double weights[] = {1., 0., 3., 0.5, 2.5, 0., 1.};
+  std::vector<G4double> w(weights, weights + sizeof(weights)/sizeof(G4double));
+
+  nexus::AliasSampler sampler(w);
+  REQUIRE(sampler.GetSize() == w.size());
+
+  // Probability of each index over a fine grid of uniform numbers
+  const size_t num_points = 700000;
+  std::vector<G4double> freq(w.size(), 0.);
+  for (size_t i=0; i<num_points; ++i)
+    freq[sampler.Index((i + 0.5) / num_points)] += 1. / num_points;
+
+  for (size_t i=0; i<w.size(); ++i) {
+    REQUIRE(sampler.GetProbability(i) == Approx(w[i] / 8.));
+    REQUIRE(freq[i] == Approx(w[i] / 8.).margin(1.e-5));
+  }
+
+  // Random indices stay within the table
+  for (G4int i=0; i<1000; ++i)
+    REQUIRE(sampler.Shoot() < w.size());
+}
@@ -0,0 +1,73 @@
+#include <HitCompactor.h>
+
+#include <catch.hpp>
+
+
+TEST_CASE("HitCompactor") {
+  // These tests check that the deposits are merged per voxel
+  // into hits at their energy-weighted centroid
+
+  SECTION("Deposits in the same voxel are merged") {
+    nexus::HitCompactor compactor(G4ThreeVector(1., 1., 1.), 0., true);
+    compactor.Add(1, G4ThreeVector(0.2, 0.2, 0.2), 1., 1.);
+    compactor.Add(1, G4ThreeVector(0.6, 0.6, 0.6), 3., 3.);
+
+    auto hits = compactor.GetHits();
+    REQUIRE(hits.size() == 1);
+    REQUIRE(compactor.GetNumberOfDeposits() == 2);
+    REQUIRE(hits[0].energy == Approx(4.));
+    REQUIRE(hits[0].position.x() == Approx(0.5));
+    REQUIRE(hits[0].position.z() == Approx(0.5));
+    REQUIRE(hits[0].time == Approx(2.5));
+  }
+
+  SECTION("Deposits in different voxels or tracks are not merged") {
+    nexus::HitCompactor compactor(G4ThreeVector(1., 1., 1.), 0., true);
+    compactor.Add(1, G4ThreeVector( 0.5, 0.5, 0.5), 0., 1.);
+    compactor.Add(1, G4ThreeVector(-0.5, 0.5, 0.5), 0., 1.);
+    compactor.Add(2, G4ThreeVector( 0.5, 0.5, 0.5), 0., 1.);
+
+    auto hits = compactor.GetHits();
+    REQUIRE(hits.size() == 3);
+    REQUIRE(hits[0].track_id == 1);
+    REQUIRE(hits[2].track_id == 2);
+  }
+
+  SECTION("Deposits of different tracks can be merged") {
+    nexus::HitCompactor compactor(G4ThreeVector(1., 1., 1.), 0., false);
+    compactor.Add(1, G4ThreeVector(0.5, 0.5, 0.5), 0., 1.);
+    compactor.Add(2, G4ThreeVector(0.5, 0.5, 0.5), 0., 2.);
+
+    auto hits = compactor.GetHits();
+    REQUIRE(hits.size() == 1);
+    REQUIRE(hits[0].track_id == 2);
+    REQUIRE(hits[0].energy == Approx(3.));
+  }
+
+  SECTION("Time window") {
+    nexus::HitCompactor compactor(G4ThreeVector(1., 1., 1.), 10., true);
+    compactor.Add(1, G4ThreeVector(0.5, 0.5, 0.5),  1., 1.);
+    compactor.Add(1, G4ThreeVector(0.5, 0.5, 0.5),  5., 1.);
+    compactor.Add(1, G4ThreeVector(0.5, 0.5, 0.5), 15., 1.);
+
+    REQUIRE(compactor.GetHits().size() == 2);
+
+    compactor.Clear();
+    REQUIRE(compactor.GetHits().size() == 0);
+    REQUIRE(compactor.GetNumberOfDeposits() == 0);
+  }
+
+  SECTION("Total energy is conserved") {
+    nexus::HitCompactor compactor(G4ThreeVector(2., 2., 2.), 0., true);
+    G4double total = 0.;
+    for (G4int i=0; i<100; ++i) {
+      G4double e = 0.1 * (i % 7 + 1);
+      compactor.Add(i % 3, G4ThreeVector(0.37*i, -0.21*i, 0.05*i), 0.1*i, e);
+      total += e;
+    }
+
+    G4double sum = 0.;
+    for (auto& hit: compactor.GetHits()) sum += hit.energy;
+    REQUIRE(sum == Approx(total));
+  }
+}
@@ -0,0 +1,69 @@
+#include <InverseCDFSampler.h>
+
+#include <Randomize.hh>
+#include "CLHEP/Units/SystemOfUnits.h"
+
+#include <TF1.h>
+
+#include <catch.hpp>
+
+#include <cmath>
+
+
+namespace {
+
+  G4double Cos2(G4double x) { return std::pow(std::cos(x), 2); }
+
+}
+
+
+TEST_CASE("InverseCDFSampler") {
+  // These tests check that the sampler reproduces the
+  // cos^2 distribution of the zenith angle of muons
+
+  nexus::InverseCDFSampler sampler(Cos2, 0., CLHEP::pi/2);
+
+  // Quantiles of the cumulative distribution F(x) = (x + sin(x) cos(x)) / (pi/2)
+  REQUIRE(sampler.Quantile(0.) == Approx(0.).margin(1.e-6));
+  REQUIRE(sampler.Quantile(1.) == Approx(CLHEP::pi/2));
+  for (G4double x=0.1; x<1.5; x+=0.2) {
+    G4double u = (x + std::sin(x)*std::cos(x)) / (CLHEP::pi/2);
+    REQUIRE(sampler.Quantile(u) == Approx(x).epsilon(1.e-4));
+  }
+
+  // Mean of the distribution: pi/4 - 1/pi
+  const G4int num_samples = 100000;
+  G4double sum = 0.;
+  for (G4int i=0; i<num_samples; ++i) {
+    G4double x = sampler.Shoot();
+    REQUIRE(x >= 0.);
+    REQUIRE(x <= CLHEP::pi/2);
+    sum += x;
+  }
+  REQUIRE(sum / num_samples == Approx(CLHEP::pi/4 - 1./CLHEP::pi).epsilon(0.01));
+}
+
+
+TEST_CASE("InverseCDFSampler benchmark", "[.][benchmark]") {
+  // Run with: nexus-test "[benchmark]"
+  // Cost per event of the zenith angle of MuonGenerator
+  const G4int num_events = 10000;
+  G4double sum = 0.;
+
+  nexus::InverseCDFSampler sampler(Cos2, 0., CLHEP::pi/2);
+
+  BENCHMARK("TF1 built for each event") {
+    for (G4int i=0; i<num_events; ++i) {
+      TF1* f1 = new TF1("f1", "pow(cos(x),2)", 0, CLHEP::pi/2);
+      sum += f1->GetRandom();
+      delete f1;
+    }
+  }
+
+  BENCHMARK("InverseCDFSampler built once") {
+    for (G4int i=0; i<num_events; ++i)
+      sum += sampler.Shoot();
+  }
+
+  REQUIRE(sum > 0.);
+}
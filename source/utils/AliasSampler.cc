@@ -0,0 +1,95 @@
+// ----------------------------------------------------------------------------
+// nexus | AliasSampler.cc
+//
+// This class samples the index of a discrete distribution in constant
+// time using the alias method of Walker, with the tables of Vose.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#include "AliasSampler.h"
+
+#include <Randomize.hh>
+
+#include <algorithm>
+
+
+namespace nexus {
+
+
+  AliasSampler::AliasSampler(const std::vector<G4double>& weights)
+  {
+    const size_t n = weights.size();
+
+    G4double total = 0.;
+    for (size_t i=0; i<n; ++i) {
+      if (weights[i] < 0.) {
+        G4Exception("[AliasSampler]", "AliasSampler()", FatalException,
+                    "Negative weight in a discrete distribution.");
+      }
+      total += weights[i];
+    }
+
+    if (!(total > 0.)) {
+      G4Exception("[AliasSampler]", "AliasSampler()", FatalException,
+                  "The weights of the discrete distribution are all zero.");
+    }
+
+    norm_.resize(n);
+    prob_.resize(n);
+    alias_.resize(n);
+
+    // Scaled probabilities, of mean 1, split in those below
+    // and above the mean
+    std::vector<size_t> small, large;
+    for (size_t i=0; i<n; ++i) {
+      norm_[i] = weights[i] / total;
+      prob_[i] = norm_[i] * n;
+      alias_[i] = i;
+      if (prob_[i] < 1.) small.push_back(i);
+      else               large.push_back(i);
+    }
+
+    // Each small index is completed up to the mean with a large one
+    while (!small.empty() && !large.empty()) {
+      size_t s = small.back(); small.pop_back();
+      size_t l = large.back();
+      alias_[s] = l;
+      prob_[l] -= 1. - prob_[s];
+      if (prob_[l] < 1.) {
+        large.pop_back();
+        small.push_back(l);
+      }
+    }
+
+    // What is left is at the mean, up to rounding errors
+    for (size_t i=0; i<large.size(); ++i) prob_[large[i]] = 1.;
+    for (size_t i=0; i<small.size(); ++i) prob_[small[i]] = 1.;
+  }
+
+
+
+  AliasSampler::~AliasSampler()
+  {
+  }
+
+
+
+  size_t AliasSampler::Index(G4double u) const
+  {
+    // The integer part of u*n chooses a column,
+    // and the fractional part the index within it
+    G4double pos = std::max(0., u) * prob_.size();
+    size_t column = std::min(size_t(pos), prob_.size() - 1);
+    return (pos - column < prob_[column]) ? column : alias_[column];
+  }
+
+
+
+  size_t AliasSampler::Shoot() const
+  {
+    return Index(G4UniformRand());
+  }
+
+
+} // end namespace nexus
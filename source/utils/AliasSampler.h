@@ -0,0 +1,53 @@
+// ----------------------------------------------------------------------------
+// nexus | AliasSampler.h
+//
+// This class samples the index of a discrete distribution in constant
+// time using the alias method of Walker, with the tables of Vose.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#ifndef ALIAS_SAMPLER_H
+#define ALIAS_SAMPLER_H
+
+#include <globals.hh>
+
+#include <vector>
+
+
+namespace nexus {
+
+  class AliasSampler
+  {
+  public:
+    /// Constructor providing the (non normalized) weights of the indices
+    AliasSampler(const std::vector<G4double>& weights);
+    /// Destructor
+    ~AliasSampler();
+
+    /// Returns a random index, with a probability proportional to its weight
+    size_t Shoot() const;
+
+    /// Returns the index for a uniform random number in [0, 1)
+    size_t Index(G4double u) const;
+
+    /// Returns the normalized probability of an index
+    G4double GetProbability(size_t index) const;
+
+    size_t GetSize() const;
+
+  private:
+    std::vector<G4double> prob_;  ///< Probability of keeping each index
+    std::vector<size_t>   alias_; ///< Index taken otherwise
+    std::vector<G4double> norm_;  ///< Normalized weights
+  };
+
+  inline G4double AliasSampler::GetProbability(size_t index) const
+  { return norm_[index]; }
+
+  inline size_t AliasSampler::GetSize() const
+  { return prob_.size(); }
+
+} // end namespace nexus
+
+#endif
@@ -0,0 +1,134 @@
+// ----------------------------------------------------------------------------
+// nexus | HitCompactor.cc
+//
+// This class merges the energy deposits that fall in the same voxel
+// (and time window) into a single hit placed at their energy-weighted
+// centroid.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#include "HitCompactor.h"
+
+#include <cmath>
+#include <functional>
+
+
+namespace nexus {
+
+
+  HitCompactor::HitCompactor(G4ThreeVector voxel_size, G4double time_window,
+                             G4bool per_track):
+    voxel_size_(voxel_size), time_window_(time_window), per_track_(per_track),
+    ndeposits_(0)
+  {
+  }
+
+
+
+  HitCompactor::~HitCompactor()
+  {
+  }
+
+
+
+  long HitCompactor::Bin(G4double x, G4double width) const
+  {
+    // A non-positive width puts all the values in the same bin
+    if (width <= 0.) return 0;
+    return (long) std::floor(x / width);
+  }
+
+
+
+  void HitCompactor::Add(G4int track_id, const G4ThreeVector& position,
+                         G4double time, G4double energy)
+  {
+    ndeposits_++;
+
+    Key key;
+    key.track_id = per_track_ ? track_id : 0;
+    key.ix = Bin(position.x(), voxel_size_.x());
+    key.iy = Bin(position.y(), voxel_size_.y());
+    key.iz = Bin(position.z(), voxel_size_.z());
+    key.it = Bin(time, time_window_);
+
+    std::pair<std::unordered_map<Key, size_t, KeyHash>::iterator, bool> result =
+      index_.insert(std::make_pair(key, voxels_.size()));
+
+    if (result.second) {
+      Voxel voxel;
+      voxel.track_id   = track_id;
+      voxel.max_energy = energy;
+      voxel.energy = 0.;
+      voxel.ex = voxel.ey = voxel.ez = voxel.et = 0.;
+      voxels_.push_back(voxel);
+    }
+
+    Voxel& voxel = voxels_[result.first->second];
+    voxel.energy += energy;
+    voxel.ex += energy * position.x();
+    voxel.ey += energy * position.y();
+    voxel.ez += energy * position.z();
+    voxel.et += energy * time;
+
+    if (energy > voxel.max_energy) {
+      voxel.max_energy = energy;
+      voxel.track_id   = track_id;
+    }
+  }
+
+
+
+  const std::vector<HitCompactor::Hit>& HitCompactor::GetHits()
+  {
+    hits_.resize(voxels_.size());
+
+    for (size_t i=0; i<voxels_.size(); ++i) {
+      const Voxel& voxel = voxels_[i];
+      Hit& hit = hits_[i];
+      hit.track_id = voxel.track_id;
+      hit.energy   = voxel.energy;
+      if (voxel.energy > 0.) {
+        hit.position = G4ThreeVector(voxel.ex, voxel.ey, voxel.ez) / voxel.energy;
+        hit.time     = voxel.et / voxel.energy;
+      } else {
+        hit.position = G4ThreeVector();
+        hit.time     = 0.;
+      }
+    }
+
+    return hits_;
+  }
+
+
+
+  void HitCompactor::Clear()
+  {
+    index_.clear();
+    voxels_.clear();
+    hits_.clear();
+    ndeposits_ = 0;
+  }
+
+
+
+  bool HitCompactor::Key::operator==(const Key& other) const
+  {
+    return track_id == other.track_id &&
+      ix == other.ix && iy == other.iy && iz == other.iz && it == other.it;
+  }
+
+
+
+  size_t HitCompactor::KeyHash::operator()(const Key& key) const
+  {
+    size_t h = std::hash<G4int>()(key.track_id);
+    const long bins[4] = {key.ix, key.iy, key.iz, key.it};
+    for (int i=0; i<4; ++i)
+      h ^= std::hash<long>()(bins[i]) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+  }
+
+
+} // end namespace nexus
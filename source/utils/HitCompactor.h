@@ -0,0 +1,95 @@
+// ----------------------------------------------------------------------------
+// nexus | HitCompactor.h
+//
+// This class merges the energy deposits that fall in the same voxel
+// (and time window) into a single hit placed at their energy-weighted
+// centroid.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#ifndef HIT_COMPACTOR_H
+#define HIT_COMPACTOR_H
+
+#include <G4ThreeVector.hh>
+
+#include <vector>
+#include <unordered_map>
+
+
+namespace nexus {
+
+  /// Merger of energy deposits into voxels
+
+  class HitCompactor
+  {
+  public:
+    /// Merged deposit
+    struct Hit {
+      G4int track_id;
+      G4ThreeVector position;
+      G4double time;
+      G4double energy;
+    };
+
+    /// Constructor. The deposits are merged in voxels of the given size
+    /// and, if time_window > 0, only within time slices of that width.
+    /// If per_track is false, deposits of different tracks are merged
+    /// together, and the hit is assigned to the track with the largest
+    /// single deposit.
+    HitCompactor(G4ThreeVector voxel_size, G4double time_window, G4bool per_track);
+
+    /// Destructor
+    ~HitCompactor();
+
+    /// Add a deposit
+    void Add(G4int track_id, const G4ThreeVector& position,
+             G4double time, G4double energy);
+
+    /// Return the merged hits, in order of their first deposit
+    const std::vector<Hit>& GetHits();
+
+    /// Remove all the deposits, keeping the allocated memory
+    void Clear();
+
+    /// Number of deposits added since the last Clear
+    size_t GetNumberOfDeposits() const;
+
+  private:
+    struct Key {
+      G4int track_id;
+      long ix, iy, iz, it;
+      bool operator==(const Key& other) const;
+    };
+
+    struct KeyHash {
+      size_t operator()(const Key& key) const;
+    };
+
+    /// Running sums of a voxel
+    struct Voxel {
+      G4int track_id;
+      G4double max_energy;
+      G4double energy;
+      G4double ex, ey, ez, et;
+    };
+
+    long Bin(G4double x, G4double width) const;
+
+  private:
+    G4ThreeVector voxel_size_;
+    G4double time_window_;
+    G4bool per_track_;
+
+    size_t ndeposits_;
+    std::unordered_map<Key, size_t, KeyHash> index_; ///< Voxel of each key
+    std::vector<Voxel> voxels_; ///< Voxels, in order of their first deposit
+    std::vector<Hit> hits_;
+  };
+
+  inline size_t HitCompactor::GetNumberOfDeposits() const
+  { return ndeposits_; }
+
+} // end namespace nexus
+
+#endif
@@ -0,0 +1,88 @@
+// ----------------------------------------------------------------------------
+// nexus | InverseCDFSampler.cc
+//
+// This class samples a continuous distribution in an interval by
+// inverting its cumulative distribution, tabulated once at construction.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#include "InverseCDFSampler.h"
+
+#include <Randomize.hh>
+
+#include <algorithm>
+
+
+namespace nexus {
+
+
+  InverseCDFSampler::InverseCDFSampler(const std::function<G4double(G4double)>& pdf,
+                                       G4double xmin, G4double xmax,
+                                       size_t num_bins):
+    xmin_(xmin), width_(0.)
+  {
+    if (!(xmax > xmin) || num_bins < 1) {
+      G4Exception("[InverseCDFSampler]", "InverseCDFSampler()", FatalException,
+                  "The interval or the number of bins of the table is not valid.");
+    }
+
+    width_ = (xmax - xmin) / num_bins;
+
+    // Cumulative distribution, integrating the density with the trapezoidal rule
+    cdf_.assign(num_bins + 1, 0.);
+    G4double previous = std::max(0., pdf(xmin));
+    for (size_t i=1; i<=num_bins; ++i) {
+      G4double current = std::max(0., pdf(xmin + i*width_));
+      cdf_[i] = cdf_[i-1] + 0.5 * (previous + current) * width_;
+      previous = current;
+    }
+
+    if (!(cdf_[num_bins] > 0.)) {
+      G4Exception("[InverseCDFSampler]", "InverseCDFSampler()", FatalException,
+                  "The probability density vanishes in the whole interval.");
+    }
+
+    for (size_t i=0; i<=num_bins; ++i) cdf_[i] /= cdf_[num_bins];
+
+    // Bin containing the lower end of each quantile range [k, k+1)/num_bins
+    guide_.resize(num_bins);
+    size_t bin = 0;
+    for (size_t k=0; k<num_bins; ++k) {
+      G4double u = G4double(k) / num_bins;
+      while (bin < num_bins - 1 && cdf_[bin+1] <= u) ++bin;
+      guide_[k] = bin;
+    }
+  }
+
+
+
+  InverseCDFSampler::~InverseCDFSampler()
+  {
+  }
+
+
+
+  G4double InverseCDFSampler::Quantile(G4double u) const
+  {
+    const size_t num_bins = guide_.size();
+    u = std::min(1., std::max(0., u));
+
+    size_t bin = guide_[std::min(size_t(u * num_bins), num_bins - 1)];
+    while (bin < num_bins - 1 && cdf_[bin+1] < u) ++bin;
+
+    // The cumulative distribution is taken as linear within the bin
+    G4double delta = cdf_[bin+1] - cdf_[bin];
+    G4double frac  = (delta > 0.) ? (u - cdf_[bin]) / delta : 0.;
+    return xmin_ + (bin + std::min(1., std::max(0., frac))) * width_;
+  }
+
+
+
+  G4double InverseCDFSampler::Shoot() const
+  {
+    return Quantile(G4UniformRand());
+  }
+
+
+} // end namespace nexus
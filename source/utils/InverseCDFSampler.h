@@ -0,0 +1,48 @@
+// ----------------------------------------------------------------------------
+// nexus | InverseCDFSampler.h
+//
+// This class samples a continuous distribution in an interval by
+// inverting its cumulative distribution, tabulated once at construction.
+// A guide table gives the bin of each quantile in constant expected time.
+//
+// The NEXT Collaboration
+// ----------------------------------------------------------------------------
+
+#ifndef INVERSE_CDF_SAMPLER_H
+#define INVERSE_CDF_SAMPLER_H
+
+#include <globals.hh>
+
+#include <functional>
+#include <vector>
+
+
+namespace nexus {
+
+  class InverseCDFSampler
+  {
+  public:
+    /// Constructor providing the (non normalized) probability density,
+    /// the interval and the number of bins of the table
+    InverseCDFSampler(const std::function<G4double(G4double)>& pdf,
+                      G4double xmin, G4double xmax, size_t num_bins=10000);
+    /// Destructor
+    ~InverseCDFSampler();
+
+    /// Returns the value for a given quantile in [0, 1]
+    G4double Quantile(G4double u) const;
+
+    /// Returns a random value following the distribution
+    G4double Shoot() const;
+
+  private:
+    G4double xmin_;
+    G4double width_; ///< Width of the bins
+
+    std::vector<G4double> cdf_; ///< Normalized cumulative distribution at the bin edges
+    std::vector<size_t> guide_; ///< First bin of each of num_bins equal quantile ranges
+  };
+
+} // end namespace nexus
+
+#endif
@@ -0,0 +1,133 @@
+import pytest
+
+import os
+import time
+import subprocess
+import numpy  as np
+import pandas as pd
+
+"""
+This module compares the single-step analytic drift and EL of the
+ionization electrons, and their tracking in weighted clusters, with
+their step-by-step tracking one by one, for Kr events in the NEW detector.
+"""
+
+seeds = [1, 2, 3]
+
+
+def run_kr_event(NEXUSDIR, config_tmpdir, name, seed, extra_lines, delayed_lines=()):
+    """
+    Run one event of the NEW_fullKr example with the given seed and
+    extra configuration commands, plus commands executed after the run
+    initialization. Returns the output file and the wall time of the job.
+    """
+    init_macro    = os.path.join(config_tmpdir, name + '.init.mac')
+    config_macro  = os.path.join(config_tmpdir, name + '.config.mac')
+    delayed_macro = os.path.join(config_tmpdir, name + '.delayed.mac')
+    output_file   = os.path.join(config_tmpdir, name)
+
+    with open(NEXUSDIR + '/macros/NEW_fullKr.init.mac') as f:
+        init_lines = f.readlines()
+    with open(init_macro, 'w') as f:
+        for l in init_lines:
+            if l.startswith('/nexus/RegisterMacro'):
+                l = f'/nexus/RegisterMacro {config_macro}\n'
+                l = l + f'/nexus/RegisterDelayedMacro {delayed_macro}\n'
+            f.write(l)
+
+    with open(NEXUSDIR + '/macros/NEW_fullKr.config.mac') as f:
+        config_lines = f.readlines()
+    with open(config_macro, 'w') as f:
+        for l in config_lines:
+            if l.startswith('/nexus/persistency/outputFile'):
+                l = f'/nexus/persistency/outputFile {output_file}\n'
+            f.write(l)
+        f.write(f'/nexus/random_seed {seed}\n')
+        for l in extra_lines:
+            f.write(l + '\n')
+
+    with open(delayed_macro, 'w') as f:
+        for l in delayed_lines:
+            f.write(l + '\n')
+
+    command = [NEXUSDIR + '/bin/nexus', '-b', '-n', '1', init_macro]
+    start   = time.time()
+    subprocess.run(command, check=True, env=os.environ.copy())
+    return output_file + '.h5', time.time() - start
+
+
+def total_charge(filename):
+    sns_response  = pd.read_hdf(filename, 'MC/sns_response')
+    sns_positions = pd.read_hdf(filename, 'MC/sns_positions')
+    pmt_ids = sns_positions[sns_positions.sensor_name.str.contains('Pmt')].sensor_id
+    is_pmt  = sns_response.sensor_id.isin(pmt_ids)
+    return sns_response[is_pmt].charge.sum(), sns_response[~is_pmt].charge.sum()
+
+
+def sipm_spread(filename):
+    """
+    Charge-weighted standard deviation of the SiPM positions
+    in x and y, which measures the transverse size of the event.
+    """
+    sns_response  = pd.read_hdf(filename, 'MC/sns_response')
+    sns_positions = pd.read_hdf(filename, 'MC/sns_positions')
+    sipms  = sns_positions[~sns_positions.sensor_name.str.contains('Pmt')]
+    charge = sns_response.groupby('sensor_id').charge.sum()
+    sipms  = sipms.set_index('sensor_id').join(charge, how='inner')
+    return [np.sqrt(np.cov(sipms[axis], aweights=sipms.charge)) for axis in 'xy']
+
+
+@pytest.mark.order('last')
+@pytest.mark.parametrize('seed', seeds)
+def test_analytic_drift_agrees_with_tracking(capsys, NEXUSDIR, config_tmpdir, seed):
+    """
+    With the same seed both modes simulate the same Kr decay,
+    so the PMT and SiPM charges must agree within fluctuations.
+    """
+    tracked_file, tracked_time = run_kr_event(NEXUSDIR, config_tmpdir,
+                                              f'Kr_tracked_{seed}', seed, [])
+    analytic_file, analytic_time = run_kr_event(NEXUSDIR, config_tmpdir,
+                                                f'Kr_analytic_{seed}', seed,
+                                                ['/PhysicsList/Nexus/analytic_drift true'])
+
+    with capsys.disabled():
+        print('')
+        print(f'Kr event {seed}: tracked drift {tracked_time:.1f} s, '
+              f'analytic drift {analytic_time:.1f} s')
+
+    tracked_pmt , tracked_sipm  = total_charge(tracked_file)
+    analytic_pmt, analytic_sipm = total_charge(analytic_file)
+
+    assert tracked_pmt > 0
+    assert np.isclose(analytic_pmt , tracked_pmt , rtol=0.1)
+    assert np.isclose(analytic_sipm, tracked_sipm, rtol=0.1)
+
+
+@pytest.mark.order('last')
+@pytest.mark.parametrize('cluster_size', [10, 100])
+def test_ionization_clusters_agree_with_single_electrons(capsys, NEXUSDIR, config_tmpdir,
+                                                         cluster_size):
+    """
+    Tracking the ionization electrons in clusters of cluster_size
+    electrons gives the same total charges as tracking them one by one,
+    and the electrons of the clusters diffuse as much as single ones.
+    """
+    seed = seeds[0]
+    single_file, single_time = run_kr_event(NEXUSDIR, config_tmpdir,
+                                            f'Kr_single_{cluster_size}', seed, [])
+    cluster_file, cluster_time = run_kr_event(NEXUSDIR, config_tmpdir,
+                                              f'Kr_cluster_{cluster_size}', seed, [],
+                                              [f'/Physics/IonizationClustering/cluster_size {cluster_size}'])
+
+    with capsys.disabled():
+        print('')
+        print(f'Kr event {seed}: single electrons {single_time:.1f} s, '
+              f'clusters of {cluster_size} {cluster_time:.1f} s')
+
+    single_pmt , single_sipm  = total_charge(single_file)
+    cluster_pmt, cluster_sipm = total_charge(cluster_file)
+
+    assert single_pmt > 0
+    assert np.isclose(cluster_pmt , single_pmt , rtol=0.1)
+    assert np.isclose(cluster_sipm, single_sipm, rtol=0.1)
+    assert np.allclose(sipm_spread(cluster_file), sipm_spread(single_file), rtol=0.2)
@@ -0,0 +1,179 @@
+import pytest
+
+import os
+import time
+import subprocess
+import numpy  as np
+import pandas as pd
+
+"""
+This module compares the faster modes of the EL simulation (the
+parametrization with a look-up table and the emission of photon bunches)
+with the full simulation of the EL optical photons.
+"""
+
+# All the events of the EL_TABLE generator after the first one
+# start from a different EL point, so a single event is simulated
+num_ie = 500
+
+
+def run_nexus(NEXUSDIR, config_tmpdir, name, config_lines, delayed_lines=()):
+    """
+    Run the NEW EL-table setup with some extra configuration commands,
+    returning the output file and the wall time of the job. The commands
+    of the physics processes, which only exist once the run is initialized,
+    go in the delayed lines.
+    """
+    init_macro    = os.path.join(config_tmpdir, name + '.init.mac')
+    config_macro  = os.path.join(config_tmpdir, name + '.config.mac')
+    delayed_macro = os.path.join(config_tmpdir, name + '.delayed.mac')
+    output_file   = os.path.join(config_tmpdir, name)
+
+    with open(init_macro, 'w') as f:
+        f.write('/PhysicsList/RegisterPhysics G4EmStandardPhysics_option4\n')
+        f.write('/PhysicsList/RegisterPhysics G4DecayPhysics\n')
+        f.write('/PhysicsList/RegisterPhysics G4OpticalPhysics\n')
+        f.write('/PhysicsList/RegisterPhysics NexusPhysics\n')
+        f.write('/Geometry/RegisterGeometry NEXT_NEW\n')
+        f.write('/Generator/RegisterGenerator EL_TABLE\n')
+        f.write('/Actions/RegisterTrackingAction DEFAULT\n')
+        f.write('/Actions/RegisterEventAction SAVE_ALL\n')
+        f.write('/Actions/RegisterRunAction DEFAULT\n')
+        f.write(f'/nexus/RegisterMacro {config_macro}\n')
+        f.write(f'/nexus/RegisterDelayedMacro {delayed_macro}\n')
+
+    with open(config_macro, 'w') as f:
+        f.write('/run/verbose 0\n')
+        f.write('/event/verbose 0\n')
+        f.write('/tracking/verbose 0\n')
+        f.write('/Geometry/NextNew/elfield true\n')
+        f.write('/Geometry/NextNew/pressure 15. bar\n')
+        f.write('/Geometry/NextNew/el_table_binning 5. mm\n')
+        f.write('/Geometry/NextNew/el_table_point_id 0\n')
+        f.write(f'/Generator/ELTableGenerator/num_ie {num_ie}\n')
+        f.write('/PhysicsList/Nexus/photoelectric false\n')
+        f.write(f'/nexus/persistency/outputFile {output_file}\n')
+        for line in config_lines:
+            f.write(line + '\n')
+
+    with open(delayed_macro, 'w') as f:
+        for line in delayed_lines:
+            f.write(line + '\n')
+
+    command = [NEXUSDIR + '/bin/nexus', '-b', '-n', '1', init_macro]
+    start   = time.time()
+    subprocess.run(command, check=True, env=os.environ.copy())
+    return output_file + '.h5', time.time() - start
+
+
+def charge_per_sensor(filename):
+    sns_response = pd.read_hdf(filename, 'MC/sns_response')
+    return sns_response.groupby('sensor_id').charge.sum()
+
+
+@pytest.fixture(scope='module')
+def el_table(NEXUSDIR, config_tmpdir):
+    """
+    Write an EL table in which all the points share the detection
+    probabilities of the EL point simulated with the full optics.
+    """
+    photons_per_point = 1000
+    filename, _ = run_nexus(NEXUSDIR, config_tmpdir, 'EL_table_point',
+                            ['/nexus/random_seed 11'],
+                            ['/Physics/Electroluminescence/table_generation true',
+                             f'/Physics/Electroluminescence/photons_per_point {photons_per_point}'])
+
+    probs = charge_per_sensor(filename) / (num_ie * photons_per_point)
+
+    # Any grid is valid, since all the points have the same map
+    radius, pitch = 100., 5.
+    nodes      = int(np.floor(2 * radius / pitch)) + 1
+    coords     = -radius + pitch * np.arange(nodes)
+    num_points = np.count_nonzero(np.hypot(*np.meshgrid(coords, coords)) <= radius)
+
+    table_file = os.path.join(config_tmpdir, 'EL_table.txt')
+    with open(table_file, 'w') as f:
+        f.write('* Uniform EL table for testing\n')
+        f.write(f'* grid_radius {radius}\n')
+        f.write(f'* grid_pitch {pitch}\n')
+        for point_id in range(num_points):
+            for sensor_id, prob in probs.items():
+                f.write(f'{point_id} {sensor_id} {prob}\n')
+
+    return table_file
+
+
+@pytest.fixture(scope='module')
+def el_full_simulation(NEXUSDIR, config_tmpdir):
+    """Run the full simulation of the EL photons, one by one."""
+    return run_nexus(NEXUSDIR, config_tmpdir, 'EL_full',
+                     ['/nexus/random_seed 12'])
+
+
+def assert_same_response(full, other, variance_factor=1):
+    """
+    Check that the total charge and the charge of the sensors seeing most
+    of the light agree with the full simulation. The variance factor
+    accounts for the correlations between counts in the tested mode.
+    """
+    # The photon yield fluctuates between electrons in the full simulation,
+    # so the tolerance is looser than the Poisson error of the total
+    assert np.isclose(other.sum(), full.sum(), rtol=0.1)
+
+    brightest = full[full > 400].index
+    assert len(brightest) > 0
+    full_b    = full[brightest]
+    other_b   = other.reindex(brightest, fill_value=0)
+    tolerance = 5 * np.sqrt(variance_factor * full_b) + 0.1 * full_b
+    assert np.all(np.abs(other_b - full_b) < tolerance)
+
+
+@pytest.mark.order('last')
+def test_el_fast_simulation_agrees_with_full_simulation(capsys, NEXUSDIR, config_tmpdir,
+                                                        el_table, el_full_simulation):
+    """The parametrized simulation reproduces the full simulation."""
+    full_file, full_time = el_full_simulation
+
+    fast_file, fast_time = run_nexus(NEXUSDIR, config_tmpdir, 'EL_fast',
+                                     ['/nexus/random_seed 13',
+                                      '/PhysicsList/Nexus/el_fast_simulation true',
+                                      f'/PhysicsList/Nexus/el_table {el_table}',
+                                      '/PhysicsList/Nexus/el_table_time_binning 10000. ns'])
+
+    with capsys.disabled():
+        print('')
+        print(f'EL full simulation: {full_time:.1f} s, '
+              f'fast simulation: {fast_time:.1f} s, '
+              f'speedup: {full_time / fast_time:.1f}')
+
+    # The timings are only reported, since the wall time
+    # of a job depends on the load of the machine
+    assert_same_response(charge_per_sensor(full_file), charge_per_sensor(fast_file))
+
+
+@pytest.mark.order('last')
+@pytest.mark.parametrize('bunch_size', [10, 100])
+def test_el_photon_bunches_agree_with_full_simulation(capsys, NEXUSDIR, config_tmpdir,
+                                                      el_full_simulation, bunch_size):
+    """
+    Emitting the EL photons in bunches reproduces the sensor response
+    of the full simulation while tracking bunch_size times fewer photons.
+    """
+    full_file, full_time = el_full_simulation
+
+    bunch_file, bunch_time = run_nexus(NEXUSDIR, config_tmpdir, f'EL_bunch_{bunch_size}',
+                                       ['/nexus/random_seed 14'],
+                                       [f'/Physics/Electroluminescence/photon_bunch_size {bunch_size}'])
+
+    full  = charge_per_sensor(full_file)
+    bunch = charge_per_sensor(bunch_file)
+
+    with capsys.disabled():
+        print('')
+        print(f'EL photon bunches of {bunch_size}: {bunch_time:.1f} s '
+              f'(full simulation: {full_time:.1f} s), '
+              f'total charge ratio: {bunch.sum() / full.sum():.3f}')
+
+    # The photons of a bunch reach the same sensor, so the variance
+    # of the counts grows at most by the size of the bunch
+    assert_same_response(full, bunch, bunch_size)
@@ -0,0 +1,95 @@
+import pytest
+
+import os
+import subprocess
+import numpy  as np
+import pandas as pd
+
+"""
+This module checks the filter of the primary generators, which
+generate candidates until one passes the cuts of the filter.
+"""
+
+num_events   = 20
+min_energy   = 0.5e-3 # MeV
+max_energy   = 1.0e-3 # MeV
+min_costheta = 0.5
+
+
+@pytest.fixture(scope='module')
+def filtered_geantinos(NEXUSDIR, config_tmpdir):
+    """
+    Run geantinos in the NEW geometry with a filter on
+    the energy, the volume and the direction of the particles.
+    """
+    init_macro   = os.path.join(config_tmpdir, 'filtered_geantinos.init.mac')
+    config_macro = os.path.join(config_tmpdir, 'filtered_geantinos.config.mac')
+    output_file  = os.path.join(config_tmpdir, 'filtered_geantinos')
+
+    with open(init_macro, 'w') as f:
+        f.write('/PhysicsList/RegisterPhysics G4EmStandardPhysics_option4\n')
+        f.write('/PhysicsList/RegisterPhysics G4DecayPhysics\n')
+        f.write('/PhysicsList/RegisterPhysics NexusPhysics\n')
+        f.write('/Geometry/RegisterGeometry NEXT_NEW\n')
+        f.write('/Generator/RegisterGenerator SINGLE_PARTICLE\n')
+        f.write('/Actions/RegisterTrackingAction DEFAULT\n')
+        f.write('/Actions/RegisterEventAction SAVE_ALL\n')
+        f.write('/Actions/RegisterRunAction DEFAULT\n')
+        f.write(f'/nexus/RegisterMacro {config_macro}\n')
+
+    with open(config_macro, 'w') as f:
+        f.write('/run/verbose 0\n')
+        f.write('/event/verbose 0\n')
+        f.write('/tracking/verbose 0\n')
+        f.write('/Geometry/NextNew/pressure 10. bar\n')
+        f.write('/Generator/SingleParticle/particle geantino\n')
+        f.write('/Generator/SingleParticle/min_energy 1 eV\n')
+        f.write('/Generator/SingleParticle/max_energy 1 keV\n')
+        f.write('/Generator/SingleParticle/region ACTIVE\n')
+        f.write(f'/Generator/SingleParticle/filter/min_energy {min_energy} MeV\n')
+        f.write('/Generator/SingleParticle/filter/volume ACTIVE\n')
+        f.write(f'/Generator/SingleParticle/filter/min_costheta {min_costheta}\n')
+        f.write(f'/nexus/persistency/outputFile {output_file}\n')
+
+    command = [NEXUSDIR + '/bin/nexus', '-b', '-n', str(num_events), init_macro]
+    subprocess.run(command, check=True, env=os.environ.copy())
+    return output_file + '.h5'
+
+
+def configuration(filename):
+    conf = pd.read_hdf(filename, 'MC/configuration')
+    return dict(zip(conf.param_key.values, conf.param_value.values))
+
+
+def test_filter_counts_are_saved(filtered_geantinos):
+    """
+    Every event is an accepted candidate, and about half of the
+    candidates pass the energy cut and a fourth of those the direction cut.
+    """
+    conf = configuration(filtered_geantinos)
+
+    generated  = int(conf['generated_candidates'])
+    accepted   = int(conf['accepted_candidates'])
+    efficiency = float(conf['filter_efficiency'])
+
+    assert accepted == num_events
+    assert generated >= accepted
+    assert np.isclose(efficiency, accepted / generated, rtol=1e-4)
+    assert 0.03 < efficiency < 0.5
+
+
+def test_primaries_pass_the_filter(filtered_geantinos):
+    """Check that the primary particles satisfy the cuts of the filter."""
+    particles = pd.read_hdf(filtered_geantinos, 'MC/particles')
+    primaries = particles[particles.primary == 1]
+
+    assert len(primaries) == num_events
+
+    assert np.all(primaries.kin_energy >= min_energy * (1 - 1e-6))
+    assert np.all(primaries.kin_energy <= max_energy * (1 + 1e-6))
+
+    momentum = primaries[['initial_momentum_x',
+                          'initial_momentum_y',
+                          'initial_momentum_z']].values
+    costheta = momentum[:, 2] / np.linalg.norm(momentum, axis=1)
+    assert np.all(costheta >= min_costheta - 1e-6)
@@ -0,0 +1,126 @@
+import pytest
+
+import os
+import subprocess
+import numpy  as np
+import pandas as pd
+
+"""
+This module checks the importance sampling of the muon generator
+with angular distribution, whose weighted events must give the same
+rate of muons reaching the detector as an unbiased generation.
+"""
+
+num_events = 1000
+
+
+def run_muons(NEXUSDIR, config_tmpdir, name, generator, generator_config):
+    """
+    Run low-energy muons from the MUONS plane above the
+    tonne-scale detector and return the output file.
+    """
+    init_macro   = os.path.join(config_tmpdir, f'{name}.init.mac')
+    config_macro = os.path.join(config_tmpdir, f'{name}.config.mac')
+    output_file  = os.path.join(config_tmpdir, name)
+
+    with open(init_macro, 'w') as f:
+        f.write('/PhysicsList/RegisterPhysics G4EmStandardPhysics_option4\n')
+        f.write('/PhysicsList/RegisterPhysics NexusPhysics\n')
+        f.write('/Geometry/RegisterGeometry TON_SCALE\n')
+        f.write(f'/Generator/RegisterGenerator {generator}\n')
+        f.write('/Actions/RegisterTrackingAction DEFAULT\n')
+        f.write('/Actions/RegisterEventAction SAVE_ALL\n')
+        f.write('/Actions/RegisterRunAction DEFAULT\n')
+        f.write(f'/nexus/RegisterMacro {config_macro}\n')
+
+    with open(config_macro, 'w') as f:
+        f.write('/run/verbose 0\n')
+        f.write('/event/verbose 0\n')
+        f.write('/tracking/verbose 0\n')
+        f.write('/Geometry/NextTonScale/water_thickn 50. cm\n')
+        f.write('/PhysicsList/Nexus/clustering          false\n')
+        f.write('/PhysicsList/Nexus/drift               false\n')
+        f.write('/PhysicsList/Nexus/electroluminescence false\n')
+        for line in generator_config:
+            f.write(line + '\n')
+        f.write(f'/nexus/persistency/outputFile {output_file}\n')
+
+    command = [NEXUSDIR + '/bin/nexus', '-b', '-n', str(num_events), init_macro]
+    subprocess.run(command, check=True, env=os.environ.copy())
+    return output_file + '.h5'
+
+
+@pytest.fixture(scope='module')
+def vertical_distribution(config_tmpdir):
+    """
+    Angular distribution (in units of pi) with a single bin
+    of almost vertical muons, in any azimuth.
+    """
+    ROOT = pytest.importorskip('ROOT')
+
+    filename = os.path.join(config_tmpdir, 'vertical_muons.root')
+    histo_file = ROOT.TFile(filename, 'RECREATE')
+    histo = ROOT.TH2F('za', '', 1, 0., 2., 1, 0., 0.002)
+    histo.SetBinContent(1, 1, 1.)
+    histo.Write()
+    histo_file.Close()
+    return filename
+
+
+@pytest.fixture(scope='module')
+def unbiased_muons(NEXUSDIR, config_tmpdir):
+    """Vertical muons generated over the whole plane."""
+    config = ['/Generator/MuonGenerator/region MUONS',
+              '/Generator/MuonGenerator/min_energy 200 MeV',
+              '/Generator/MuonGenerator/max_energy 200 MeV',
+              '/Generator/MuonGenerator/momentum_Y -1.']
+    return run_muons(NEXUSDIR, config_tmpdir, 'unbiased_muons', 'MUON', config)
+
+
+@pytest.fixture(scope='module')
+def importance_sampled_muons(NEXUSDIR, config_tmpdir, vertical_distribution):
+    """Muons of the same distribution generated where they reach the detector."""
+    config = ['/Generator/MuonAngleGenerator/region MUONS',
+              '/Generator/MuonAngleGenerator/min_energy 200 MeV',
+              '/Generator/MuonAngleGenerator/max_energy 200 MeV',
+              '/Generator/MuonAngleGenerator/azimuth_rotation 1 deg',
+              f'/Generator/MuonAngleGenerator/angle_file {vertical_distribution}',
+              '/Generator/MuonAngleGenerator/angle_dist za',
+              '/Generator/MuonAngleGenerator/importance_sampling true']
+    return run_muons(NEXUSDIR, config_tmpdir, 'importance_sampled_muons',
+                     'LAB_MUON', config)
+
+
+def reached_detector(filename):
+    """
+    Events whose muon reaches the detector, which are those
+    with particles created out of the laboratory air.
+    """
+    index     = pd.read_hdf(filename, 'MC/event_index')
+    particles = pd.read_hdf(filename, 'MC/particles')
+
+    inside = particles[particles.initial_volume != 'LABORATORY'].event_id.unique()
+    return index.set_index('event_id').weight, index.event_id.isin(inside).values
+
+
+def test_weighted_rate_matches_unbiased_generator(unbiased_muons,
+                                                  importance_sampled_muons):
+    """
+    The mean weight of the importance-sampled events is the fraction
+    of muons of the plane that reach the detector, measured by the
+    unbiased generator. The weights of the bounding rectangles alone
+    would overestimate it by about 4/pi for the cylindrical tank.
+    """
+    weights, reached = reached_detector(unbiased_muons)
+    assert np.all(weights == 1)
+
+    rate  = reached.mean()
+    error = np.sqrt(rate * (1 - rate) / num_events)
+
+    weights, reached = reached_detector(importance_sampled_muons)
+    assert np.all(weights > 0)
+    assert reached.mean() > 0.99
+
+    weighted_rate = np.sum(weights.values * reached) / num_events
+
+    assert np.isclose(weighted_rate, rate, atol=4 * error)
@@ -143,3 +143,67 @@ def test_sensor_names_are_the_same_across_tables(detectors):
 
     for p in sns_bin_conf:
         assert p[:-8] in pos_labels
+
+
+
+def test_no_filter_counts_without_cuts(detectors):
+    """
+    The generators of these runs have no filter cut,
+    so no counts of filtered candidates are saved.
+    """
+    filename, _, _, _, _ = detectors
+
+    conf = pd.read_hdf(filename, 'MC/configuration')
+    parameters = conf.param_key.values
+
+    assert 'generated_candidates' not in parameters
+    assert 'filter_efficiency'    not in parameters
+
+
+
+def test_event_index_points_to_event_rows(detectors):
+    """
+    Check that the event index gives, for each event, the rows
+    of the hits, particles and sensor response tables of that event.
+    """
+    filename, _, _, _, _ = detectors
+
+    index = pd.read_hdf(filename, 'MC/event_index')
+
+    for table in ['hits', 'particles', 'sns_response']:
+        rows = pd.read_hdf(filename, 'MC/' + table)
+        assert index[table + '_length'].sum() == len(rows)
+
+        for _, evt in index.iterrows():
+            start = evt[table + '_offset']
+            end   = start + evt[table + '_length']
+            assert np.all(rows.event_id.values[start:end] == evt.event_id)
+
+
+
+def test_all_sensors_have_a_position(detectors):
+    """
+    Check that the positions table lists every sensor of the
+    geometry, including those that have not detected any light.
+    """
+    filename, pmt_ids, _, _, _ = detectors
+
+    pos  = pd.read_hdf(filename, 'MC/sns_positions')
+    resp = pd.read_hdf(filename, 'MC/sns_response')
+
+    assert np.isin(resp.sensor_id.unique(), pos.sensor_id.values).all()
+    assert np.isin(pmt_ids, pos.sensor_id.values).all()
+
+
+
+def test_event_weights_are_one_for_unbiased_generators(detectors):
+    """
+    Check that the event index stores the generator weight of
+    each event, which is one for generators that don't bias the sampling.
+    """
+    filename, _, _, _, _ = detectors
+
+    index = pd.read_hdf(filename, 'MC/event_index')
+
+    assert 'weight' in index.columns
+    assert np.all(index.weight == 1)
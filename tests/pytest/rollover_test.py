@@ -0,0 +1,78 @@
+import pytest
+
+import os
+import glob
+import subprocess
+import numpy  as np
+import pandas as pd
+
+"""
+This module checks that, when the output is split in several files,
+each file counts the events it stores.
+"""
+
+num_events    = 10
+evts_per_file = 3
+
+
+@pytest.fixture(scope='module')
+def rolled_files(NEXUSDIR, config_tmpdir):
+    """
+    Run geantinos in the NEW geometry, saving all the events,
+    in files of evts_per_file events.
+    """
+    init_macro   = os.path.join(config_tmpdir, 'rollover.init.mac')
+    config_macro = os.path.join(config_tmpdir, 'rollover.config.mac')
+    output_file  = os.path.join(config_tmpdir, 'rollover')
+
+    with open(init_macro, 'w') as f:
+        f.write('/PhysicsList/RegisterPhysics G4EmStandardPhysics_option4\n')
+        f.write('/PhysicsList/RegisterPhysics NexusPhysics\n')
+        f.write('/Geometry/RegisterGeometry NEXT_NEW\n')
+        f.write('/Generator/RegisterGenerator SINGLE_PARTICLE\n')
+        f.write('/Actions/RegisterTrackingAction DEFAULT\n')
+        f.write('/Actions/RegisterEventAction SAVE_ALL\n')
+        f.write('/Actions/RegisterRunAction DEFAULT\n')
+        f.write(f'/nexus/RegisterMacro {config_macro}\n')
+
+    with open(config_macro, 'w') as f:
+        f.write('/run/verbose 0\n')
+        f.write('/event/verbose 0\n')
+        f.write('/tracking/verbose 0\n')
+        f.write('/Generator/SingleParticle/particle geantino\n')
+        f.write('/Generator/SingleParticle/min_energy 1 eV\n')
+        f.write('/Generator/SingleParticle/max_energy 1 keV\n')
+        f.write('/Generator/SingleParticle/region ACTIVE\n')
+        f.write('/Generator/SingleParticle/filter/min_energy 0.5 keV\n')
+        f.write(f'/nexus/persistency/max_events_per_file {evts_per_file}\n')
+        f.write(f'/nexus/persistency/outputFile {output_file}\n')
+
+    command = [NEXUSDIR + '/bin/nexus', '-b', '-n', str(num_events), init_macro]
+    subprocess.run(command, check=True, env=os.environ.copy())
+    return sorted(glob.glob(output_file + '_*.h5'))
+
+
+def configuration(filename):
+    conf = pd.read_hdf(filename, 'MC/configuration')
+    return dict(zip(conf.param_key.values, conf.param_value.values))
+
+
+def test_rolled_files_count_their_own_events(rolled_files):
+    """
+    All the events are saved, so the processed, saved and accepted
+    events of each file are the events of its index.
+    """
+    assert len(rolled_files) == int(np.ceil(num_events / evts_per_file))
+
+    total = 0
+    for filename in rolled_files:
+        conf  = configuration(filename)
+        index = pd.read_hdf(filename, 'MC/event_index')
+
+        assert int(conf['num_events'])          == len(index)
+        assert int(conf['saved_events'])        == len(index)
+        assert int(conf['accepted_candidates']) == len(index)
+        assert int(conf['generated_candidates']) >= len(index)
+        total += len(index)
+
+    assert total == num_events